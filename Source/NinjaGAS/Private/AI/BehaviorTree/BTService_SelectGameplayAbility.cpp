@@ -1,8 +1,8 @@
 ﻿// Ninja Bear Studio Inc. 2024, all rights reserved.
 #include "AI/BehaviorTree/BTService_SelectGameplayAbility.h"
 
+#include "NinjaGASFunctionLibrary.h"
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemGlobals.h"
 #include "Abilities/GameplayAbility.h"
 #include "BehaviorTree/BlackboardComponent.h"
 
@@ -62,7 +62,7 @@ void UBTService_SelectGameplayAbility::OnBecomeRelevant(UBehaviorTreeComponent&
 
 bool UBTService_SelectGameplayAbility::CanBeActivated(const UBehaviorTreeComponent& OwnerComp, const TSubclassOf<UGameplayAbility>& AbilityClass)
 {
-	const UAbilitySystemComponent* AbilityComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(OwnerComp.GetOwner());
+	const UAbilitySystemComponent* AbilityComponent = UNinjaGASFunctionLibrary::EnsureAbilitySystemComponentFromActor(OwnerComp.GetOwner());
 	if (!IsValid(AbilityComponent))
 	{
 		return false;
@@ -1,9 +1,10 @@
 ﻿// Ninja Bear Studio Inc. 2024, all rights reserved.
 #include "AI/BehaviorTree/BTService_UpdateAttributes.h"
 
+#include "NinjaGASFunctionLibrary.h"
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemGlobals.h"
 #include "AIController.h"
+#include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
 #include "BehaviorTree/BlackboardComponent.h"
 #include "BehaviorTree/Blackboard/BlackboardKeyType_Float.h"
 
@@ -70,7 +71,7 @@ void UBTService_UpdateAttributes::OnCeaseRelevant(UBehaviorTreeComponent& OwnerC
 	check(MyMemory);
 	
 	const APawn* Pawn = OwnerComp.GetAIOwner()->GetPawn();
-	UAbilitySystemComponent* AbilitySystemComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Pawn);
+	UAbilitySystemComponent* AbilitySystemComponent = UNinjaGASFunctionLibrary::PeekAbilitySystemComponentFromActor(Pawn);
 
 	if (IsValid(AbilitySystemComponent))
 	{
@@ -117,15 +118,28 @@ void UBTService_UpdateAttributes::BindToAttributes(UBehaviorTreeComponent& Owner
 	UBlackboardComponent* Blackboard = OwnerComp.GetBlackboardComponent();
 	if (IsValid(Blackboard))
 	{
-		const APawn* Pawn = OwnerComp.GetAIOwner()->GetPawn();
-		UAbilitySystemComponent* AbilitySystemComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Pawn);
+		APawn* Pawn = OwnerComp.GetAIOwner()->GetPawn();
+		UAbilitySystemComponent* AbilitySystemComponent = UNinjaGASFunctionLibrary::EnsureAbilitySystemComponentFromActor(Pawn);
 
 		if (IsValid(AbilitySystemComponent))
 		{
+			const UNinjaGASAbilitySystemComponent* NinjaAbilitySystemComponent = Cast<UNinjaGASAbilitySystemComponent>(AbilitySystemComponent);
+			
 			int32 AttributeCount = 0;
 			for (const FAttributeBlackboardMapping& Mapping : AttributeMappings)
 			{
-				if (AbilitySystemComponent->HasAttributeSetForAttribute(Mapping.Attribute))
+				if (MyMemory->AttributeDelegateHandles.Contains(Mapping.Attribute))
+				{
+					// Already bound in a previous attempt.
+					AttributeCount++;
+					continue;
+				}
+				
+				const bool bHasAttribute = IsValid(NinjaAbilitySystemComponent)
+					? NinjaAbilitySystemComponent->IsAttributeAvailable(Mapping.Attribute)
+					: AbilitySystemComponent->HasAttributeSetForAttribute(Mapping.Attribute);
+				
+				if (bHasAttribute)
 				{
 					const FGameplayAttribute Attribute = Mapping.Attribute;
 					FDelegateHandle Delegate = AbilitySystemComponent->GetGameplayAttributeValueChangeDelegate(Attribute)
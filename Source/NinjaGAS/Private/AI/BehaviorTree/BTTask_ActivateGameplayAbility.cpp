@@ -1,8 +1,8 @@
 ﻿// Ninja Bear Studio Inc. 2024, all rights reserved.
 #include "AI/BehaviorTree/BTTask_ActivateGameplayAbility.h"
 
+#include "NinjaGASFunctionLibrary.h"
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemGlobals.h"
 #include "AIController.h"
 #include "Abilities/GameplayAbility.h"
 #include "BehaviorTree/BlackboardComponent.h"
@@ -58,7 +58,7 @@ EBTNodeResult::Type UBTTask_ActivateGameplayAbility::ExecuteTask(UBehaviorTreeCo
     {
         bool bActivated = false;
         
-        UAbilitySystemComponent* AbilityComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(BotController->GetPawn());
+        UAbilitySystemComponent* AbilityComponent = UNinjaGASFunctionLibrary::EnsureAbilitySystemComponentFromActor(BotController->GetPawn());
         if (IsValid(AbilityComponent))
         {
             switch(ActivationMode)
@@ -151,7 +151,7 @@ void UBTTask_ActivateGameplayAbility::OnTaskFinished(UBehaviorTreeComponent& Own
         const AAIController* BotController = OwnerComp.GetAIOwner();
         if (IsValid(BotController))
         {
-            UAbilitySystemComponent* AbilityComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(BotController->GetPawn());
+            UAbilitySystemComponent* AbilityComponent = UNinjaGASFunctionLibrary::PeekAbilitySystemComponentFromActor(BotController->GetPawn());
             if (IsValid(AbilityComponent))
             {
                 AbilityComponent->OnAbilityEnded.Remove(MyMemory->AbilityCallbackDelegateHandle);
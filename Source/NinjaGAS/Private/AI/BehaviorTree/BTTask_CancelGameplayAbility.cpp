@@ -1,8 +1,8 @@
 ﻿// Ninja Bear Studio Inc. 2024, all rights reserved.
 #include "AI/BehaviorTree/BTTask_CancelGameplayAbility.h"
 
+#include "NinjaGASFunctionLibrary.h"
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemGlobals.h"
 #include "AIController.h"
 #include "Abilities/GameplayAbility.h"
 #include "BehaviorTree/BlackboardComponent.h"
@@ -43,7 +43,7 @@ EBTNodeResult::Type UBTTask_CancelGameplayAbility::ExecuteTask(UBehaviorTreeComp
     {
         bool bCancelled = false;
         
-        UAbilitySystemComponent* AbilityComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(BotController->GetPawn());
+        UAbilitySystemComponent* AbilityComponent = UNinjaGASFunctionLibrary::PeekAbilitySystemComponentFromActor(BotController->GetPawn());
         if (IsValid(AbilityComponent))
         {
             switch(CancellationMode)
@@ -6,6 +6,7 @@
 #include "StateTreeExecutionContext.h"
 #include "GameFramework/Controller.h"
 #include "GameFramework/Pawn.h"
+#include "Interfaces/LazyAbilitySystemComponentOwnerInterface.h"
 
 float FStateTreeAbilityCooldownConsideration::GetScore(FStateTreeExecutionContext& Context) const
 {
@@ -39,6 +40,12 @@ UAbilitySystemComponent* FStateTreeAbilityCooldownConsideration::GetAbilitySyste
 		return nullptr;
 	}
 
+	// Scoring never initializes lazy components, which would not have any cooldowns yet.
+	if (const ILazyAbilitySystemComponentOwnerInterface* LazyComponentOwner = Cast<ILazyAbilitySystemComponentOwnerInterface>(Owner))
+	{
+		return LazyComponentOwner->PeekAbilitySystemComponent();
+	}
+	
 	if (Owner->Implements<UAbilitySystemInterface>())
 	{
 		return Cast<IAbilitySystemInterface>(Owner)->GetAbilitySystemComponent();
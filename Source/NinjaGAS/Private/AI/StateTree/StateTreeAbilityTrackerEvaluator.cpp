@@ -1,8 +1,8 @@
 // Ninja Bear Studio Inc., all rights reserved.
 #include "AI/StateTree/StateTreeAbilityTrackerEvaluator.h"
 
+#include "NinjaGASFunctionLibrary.h"
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemGlobals.h"
 #include "AIController.h"
 #include "StateTreeExecutionContext.h"
 #include "Runtime/Launch/Resources/Version.h"
@@ -95,7 +95,9 @@ FGameplayTagContainer FStateTreeAbilityTrackerEvaluator::GetAbilityTags(const FA
 
 void FStateTreeAbilityTrackerEvaluator::TreeStop(FStateTreeExecutionContext& Context) const
 {
-	UAbilitySystemComponent* AbilityComponent = GetAbilitySystemComponent(Context);
+	// A component that was never initialized has nothing to unbind.
+	static constexpr bool bInitializeIfNeeded = false;
+	UAbilitySystemComponent* AbilityComponent = GetAbilitySystemComponent(Context, bInitializeIfNeeded);
 	if (!IsValid(AbilityComponent))
 	{
 		return;
@@ -109,7 +111,7 @@ void FStateTreeAbilityTrackerEvaluator::TreeStop(FStateTreeExecutionContext& Con
 	}
 }
 
-UAbilitySystemComponent* FStateTreeAbilityTrackerEvaluator::GetAbilitySystemComponent(const FStateTreeExecutionContext& Context)
+UAbilitySystemComponent* FStateTreeAbilityTrackerEvaluator::GetAbilitySystemComponent(const FStateTreeExecutionContext& Context, const bool bInitializeIfNeeded)
 {
 	const AAIController* Owner = Cast<AAIController>(Context.GetOwner());
 	if (!IsValid(Owner))
@@ -117,7 +119,9 @@ UAbilitySystemComponent* FStateTreeAbilityTrackerEvaluator::GetAbilitySystemComp
 		return nullptr;
 	}
 
-	return UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Owner->GetPawn());
+	return bInitializeIfNeeded
+		? UNinjaGASFunctionLibrary::EnsureAbilitySystemComponentFromActor(Owner->GetPawn())
+		: UNinjaGASFunctionLibrary::PeekAbilitySystemComponentFromActor(Owner->GetPawn());
 }
 
 bool FStateTreeAbilityTrackerEvaluator::HasValidData(const FInstanceDataType* InstanceDataPtr, const FAbilityEndedData& AbilityEndedData)
@@ -1,8 +1,8 @@
 ﻿// Ninja Bear Studio Inc., all rights reserved.
 #include "AI/StateTree/StateTreeActivateGameplayAbilityTask.h"
 
+#include "NinjaGASFunctionLibrary.h"
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemGlobals.h"
 #include "AIController.h"
 #include "StateTreeExecutionContext.h"
 #include "Abilities/GameplayAbility.h"
@@ -58,7 +58,7 @@ EStateTreeRunStatus FStateTreeActivateGameplayAbilityTask::EnterState(FStateTree
 
 UAbilitySystemComponent* FStateTreeActivateGameplayAbilityTask::GetAbilitySystemComponent(const FStateTreeExecutionContext& Context)
 {
-	const AActor* OwnerActor = Cast<AActor>(Context.GetOwner());
+	AActor* OwnerActor = Cast<AActor>(Context.GetOwner());
 	if (!IsValid(OwnerActor))
 	{
 		return nullptr;
@@ -66,12 +66,12 @@ UAbilitySystemComponent* FStateTreeActivateGameplayAbilityTask::GetAbilitySystem
 
 	if (OwnerActor->IsA<AAIController>())
 	{
-		const APawn* OwnerPawn = Cast<AAIController>(OwnerActor)->GetPawn();
-		return UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(OwnerPawn);
+		APawn* OwnerPawn = Cast<AAIController>(OwnerActor)->GetPawn();
+		return UNinjaGASFunctionLibrary::EnsureAbilitySystemComponentFromActor(OwnerPawn);
 	}
 
 	// Simply try to obtain the ASC directly from the actor (probably a pawn/character).
-	return UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(OwnerActor);
+	return UNinjaGASFunctionLibrary::EnsureAbilitySystemComponentFromActor(OwnerActor);
 }
 
 EStateTreeRunStatus FStateTreeActivateGameplayAbilityTask::ActivateAbility(const FStateTreeExecutionContext& Context) const
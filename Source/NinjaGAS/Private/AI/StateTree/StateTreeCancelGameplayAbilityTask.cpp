@@ -1,8 +1,8 @@
 ﻿// Ninja Bear Studio Inc., all rights reserved.
 #include "AI/StateTree/StateTreeCancelGameplayAbilityTask.h"
 
+#include "NinjaGASFunctionLibrary.h"
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemGlobals.h"
 #include "AIController.h"
 #include "StateTreeExecutionContext.h"
 #include "VisualLogger/VisualLogger.h"
@@ -30,11 +30,11 @@ UAbilitySystemComponent* FStateTreeCancelGameplayAbilityTask::GetAbilitySystemCo
 	if (OwnerActor->IsA<AAIController>())
 	{
 		const APawn* OwnerPawn = Cast<AAIController>(OwnerActor)->GetPawn();
-		return UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(OwnerPawn);
+		return UNinjaGASFunctionLibrary::PeekAbilitySystemComponentFromActor(OwnerPawn);
 	}
 
 	// Simply try to obtain the ASC directly from the actor (probably a pawn/character).
-	return UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(OwnerActor);	
+	return UNinjaGASFunctionLibrary::PeekAbilitySystemComponentFromActor(OwnerActor);	
 }
 
 EStateTreeRunStatus FStateTreeCancelGameplayAbilityTask::CancelAbilities(const FStateTreeExecutionContext& Context, UAbilitySystemComponent* AbilityComponent) const
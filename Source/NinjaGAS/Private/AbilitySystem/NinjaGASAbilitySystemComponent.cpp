@@ -11,17 +11,83 @@
 
 #include "AbilitySystemGlobals.h"
 #include "GameplayCueManager.h"
+#include "GameplayEffectAggregator.h"
+#include "NinjaGASGrantPlanSubsystem.h"
+#include "NinjaGASInitializationSubsystem.h"
 #include "NinjaGASLog.h"
+#include "NinjaGASStats.h"
 #include "NinjaGASTags.h"
 #include "Animation/AnimInstance.h"
 #include "Animation/AnimMontage.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "Data/NinjaGASDataAsset.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "HAL/IConsoleManager.h"
 #include "Interfaces/AbilitySystemDefaultsInterface.h"
 #include "Interfaces/BatchGameplayAbilityInterface.h"
 #include "Net/UnrealNetwork.h"
 #include "Types/FNinjaAbilityDefaultHandles.h"
+#include "Types/FNinjaAbilityGrantPlan.h"
+#include "Types/FNinjaAttributeTableLayout.h"
 #include "Runtime/Launch/Resources/Version.h"
 
+DECLARE_CYCLE_STAT(TEXT("Initialize Defaults From Data"), STAT_NinjaGAS_InitializeFromData, STATGROUP_NinjaGAS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Attribute Set Pool Hits"), STAT_NinjaGAS_AttributeSetPoolHits, STATGROUP_NinjaGAS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Attribute Set Pool Misses"), STAT_NinjaGAS_AttributeSetPoolMisses, STATGROUP_NinjaGAS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Deferred Aggregation Batches"), STAT_NinjaGAS_DeferredAggregationBatches, STATGROUP_NinjaGAS);
+
+namespace NinjaGAS::AbilitySystem
+{
+	/**
+	 * Requests a data asset and its "Abilities" bundle from the Asset Manager.
+	 * Data assets not registered with the Asset Manager are streamed without bundles.
+	 */
+	static TSharedPtr<FStreamableHandle> RequestAbilityDataLoad(const TSoftObjectPtr<UNinjaGASDataAsset>& SoftAbilityData, FStreamableDelegate Delegate)
+	{
+		UAssetManager& AssetManager = UAssetManager::Get();
+		const FSoftObjectPath& AssetPath = SoftAbilityData.ToSoftObjectPath();
+
+		const FPrimaryAssetId AssetId = AssetManager.GetPrimaryAssetIdForPath(AssetPath);
+		if (AssetId.IsValid())
+		{
+			const TArray<FName> Bundles = { UNinjaGASDataAsset::AbilitiesBundle };
+			return AssetManager.LoadPrimaryAsset(AssetId, Bundles, MoveTemp(Delegate));
+		}
+
+		return AssetManager.GetStreamableManager().RequestAsyncLoad(AssetPath, MoveTemp(Delegate));
+	}
+
+	/**
+	 * Checks if the modifiers on top of an attribute match the ones captured by the baseline.
+	 * Base values may have changed since, so additive and multiplicative offsets are accepted.
+	 */
+	static bool HasBaselineModifiers(const FGameplayAttributeData& Baseline, const FGameplayAttributeData& Current)
+	{
+		const float BaselineOffset = Baseline.GetCurrentValue() - Baseline.GetBaseValue();
+		if (FMath::IsNearlyEqual(Current.GetCurrentValue() - Current.GetBaseValue(), BaselineOffset))
+		{
+			return true;
+		}
+
+		if (FMath::IsNearlyZero(Baseline.GetBaseValue()) || FMath::IsNearlyZero(Current.GetBaseValue()))
+		{
+			return false;
+		}
+
+		const float BaselineRatio = Baseline.GetCurrentValue() / Baseline.GetBaseValue();
+		return FMath::IsNearlyEqual(Current.GetCurrentValue() / Current.GetBaseValue(), BaselineRatio);
+	}
+}
+
+static TAutoConsoleVariable<bool> CVarDeferredAggregationEnabled(
+	TEXT("NinjaGAS.DeferredAggregation.Enabled"),
+	true,
+	TEXT("When enabled, default effects are applied and removed in a batch, evaluating each dirty aggregator once.")
+);
+
 UNinjaGASAbilitySystemComponent::UNinjaGASAbilitySystemComponent() 
 	: RepAnimMontageInfoForMeshes(this)
 {
@@ -32,13 +98,24 @@ UNinjaGASAbilitySystemComponent::UNinjaGASAbilitySystemComponent()
 	bPendingMontageRepForMesh = false;
 	bEnableAbilityBatchRPC = true;
 	bResetStateWhenAvatarChanges = false;
+	bDiffDefaultsWhenAvatarChanges = false;
+	bScheduleInitialization = false;
+	bPoolAttributeSets = false;
+	MaxPooledAttributeSetsPerClass = 1;
 	bSyncMeshAnimInfoWithLocalAnimInfo = true;
+	MontageReplicationUpdateMode = EMontageReplicationUpdateMode::Timer;
+	MontageReplicationUpdateRate = 10.f;
+	MontageReplicationLODDistance = 0.f;
+	bDriveNotifyWindowsFromMontageTime = false;
+	NotifyWindowUpdateRate = 20.f;
+	bUseMontageRegistry = false;
 }
 
 void UNinjaGASAbilitySystemComponent::InitializeComponent()
 {
 	Super::InitializeComponent();
 	RepAnimMontageInfoForMeshes.SetAbilitySystemComponent(this);
+	PreloadDefaultsForClient();
 }
 
 void UNinjaGASAbilitySystemComponent::InitAbilityActorInfo(AActor* InOwnerActor, AActor* InAvatarActor)
@@ -47,24 +124,158 @@ void UNinjaGASAbilitySystemComponent::InitAbilityActorInfo(AActor* InOwnerActor,
 	const bool bAvatarHasChanged = AbilityActorInfo  && AbilityActorInfo->AvatarActor != InAvatarActor && InAvatarActor != nullptr;
 	
 	Super::InitAbilityActorInfo(InOwnerActor, InAvatarActor);
-	InitializeDefaultsFromOwner(InOwnerActor);
 
 	if (bAvatarHasChanged)
 	{
-		if (bResetStateWhenAvatarChanges)
+		// Meshes from the previous avatar are usually gone, and cached Anim Instances belong to it.
+		PruneMontageSlots();
+	}
+
+	RebuildMontageRegistry();
+
+	if (UNinjaGASInitializationSubsystem* Scheduler = GetInitializationScheduler())
+	{
+		bAbilitySystemInitialized = false;
+		Scheduler->QueueInitialization(this, bAvatarHasChanged);
+		return;
+	}
+	
+	InitializeDefaults(bAvatarHasChanged);
+}
+
+void UNinjaGASAbilitySystemComponent::InitializeDefaults(const bool bAvatarHasChanged)
+{
+	{
+		TGuardValue<bool> InitializingDefaultsGuard(bInitializingDefaults, true);
+		InitializeDefaultsFromOwner(GetOwnerActor());
+
+		if (bAvatarHasChanged)
 		{
-			ResetAbilitySystemComponent();	
+			if (bResetStateWhenAvatarChanges)
+			{
+				ResetAbilitySystemComponent();	
+			}
+
+			AActor* NewAvatar = GetAvatarActor();
+			InitializeDefaultsFromAvatar(NewAvatar);
+			OnAbilitySystemAvatarChanged.Broadcast(NewAvatar);
 		}
+	}
+
+	UpdateInitializedState();
+}
+
+void UNinjaGASAbilitySystemComponent::ProcessScheduledInitialization(const bool bReset, const bool bInitialize, const bool bAvatarHasChanged)
+{
+	if (bReset)
+	{
+		ResetAbilitySystemComponent();
+	}
+
+	if (bInitialize && AbilityActorInfo.IsValid() && IsValid(GetOwnerActor()))
+	{
+		InitializeDefaults(bAvatarHasChanged);
+	}
+}
+
+UNinjaGASInitializationSubsystem* UNinjaGASAbilitySystemComponent::GetInitializationScheduler() const
+{
+	if (!bScheduleInitialization || !UNinjaGASInitializationSubsystem::IsSchedulingEnabled())
+	{
+		return nullptr;
+	}
+
+	const UWorld* World = GetWorld();
+	return IsValid(World) ? World->GetSubsystem<UNinjaGASInitializationSubsystem>() : nullptr;
+}
+
+void UNinjaGASAbilitySystemComponent::UpdateInitializedState()
+{
+	if (bAbilitySystemInitialized || bInitializingDefaults || !AbilityActorInfo.IsValid() || AreDefaultsLoading())
+	{
+		return;
+	}
+
+	const UNinjaGASInitializationSubsystem* Scheduler = GetInitializationScheduler();
+	if (IsValid(Scheduler) && Scheduler->IsQueued(this))
+	{
+		return;
+	}
+
+	bAbilitySystemInitialized = true;
+	AbilitySystemInitializedDelegate.Broadcast();
+	OnAbilitySystemInitialized.Broadcast();
+}
 
-		InitializeDefaultsFromAvatar(InAvatarActor);
-		OnAbilitySystemAvatarChanged.Broadcast(InAvatarActor);
+void UNinjaGASAbilitySystemComponent::RequestResetAbilitySystemComponent()
+{
+	if (UNinjaGASInitializationSubsystem* Scheduler = GetInitializationScheduler())
+	{
+		Scheduler->QueueReset(this);
+		return;
 	}
+
+	ResetAbilitySystemComponent();
 }
 
 void UNinjaGASAbilitySystemComponent::OnGiveAbility(FGameplayAbilitySpec& AbilitySpec)
 {
 	Super::OnGiveAbility(AbilitySpec);
+
+	if (BulkAbilityUpdateCount > 0)
+	{
+		PendingGivenAbilityHandles.Add(AbilitySpec.Handle);
+		return;
+	}
+	
 	AbilityGivenDelegate.Broadcast(AbilitySpec);
+
+	if (AbilitiesGivenDelegate.IsBound())
+	{
+		const TArray<FGameplayAbilitySpecHandle> GivenHandles = { AbilitySpec.Handle };
+		AbilitiesGivenDelegate.Broadcast(GivenHandles);
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::OnRep_SpawnedAttributes(const TArray<UAttributeSet*>& PreviousSpawnedAttributes)
+{
+	Super::OnRep_SpawnedAttributes(PreviousSpawnedAttributes);
+
+	// Replicated sets may be replaced without changing their count.
+	InvalidateAttributeSetIndex();
+}
+
+void UNinjaGASAbilitySystemComponent::BeginBulkAbilityUpdate()
+{
+	++BulkAbilityUpdateCount;
+}
+
+void UNinjaGASAbilitySystemComponent::EndBulkAbilityUpdate()
+{
+	check(BulkAbilityUpdateCount > 0);
+	if (--BulkAbilityUpdateCount > 0 || PendingGivenAbilityHandles.IsEmpty())
+	{
+		return;
+	}
+
+	// Handles are moved out first, since listeners may grant abilities as well.
+	const TArray<FGameplayAbilitySpecHandle> GivenHandles = MoveTemp(PendingGivenAbilityHandles);
+	PendingGivenAbilityHandles.Reset();
+
+	if (AbilityGivenDelegate.IsBound())
+	{
+		for (const FGameplayAbilitySpecHandle& Handle : GivenHandles)
+		{
+			if (const FGameplayAbilitySpec* Spec = FindAbilitySpecFromHandle(Handle))
+			{
+				AbilityGivenDelegate.Broadcast(*Spec);
+			}
+		}
+	}
+	
+	AbilitiesGivenDelegate.Broadcast(GivenHandles);
+	
+	UE_LOG(LogAbilitySystemComponent, Log, TEXT("[%s] %d abilities granted in bulk."), *GetNameSafe(GetAvatarActor()), GivenHandles.Num());
 }
 
 void UNinjaGASAbilitySystemComponent::InitializeDefaultsFromOwner(const AActor* NewOwner)
@@ -85,6 +296,11 @@ void UNinjaGASAbilitySystemComponent::InitializeDefaultsFromOwner(const AActor*
 	if (IsValid(AbilityData))
 	{
 		InitializeFromData(AbilityData, OwnerHandles);
+		BroadcastDefaultsReady(AbilityData);
+	}
+	else if (!Defaults->GetSoftAbilityData().IsNull())
+	{
+		LoadDefaultsAsync(Defaults->GetSoftAbilityData(), nullptr);
 	}
 }
 
@@ -94,43 +310,178 @@ void UNinjaGASAbilitySystemComponent::InitializeDefaultsFromAvatar(const AActor*
 	// The new avatar has to be valid, and we need to make sure it's not the owner actor.
 	if (!IsValid(NewAvatar) || NewAvatar == GetOwnerActor())
 	{
+		// Defaults kept from a former avatar, waiting to be swapped, are not used anymore.
+		if (IsValid(AvatarHandles.CurrentAbilitySetup))
+		{
+			ClearDefaults(AvatarHandles);
+		}
+		
+		return;
+	}
+
+	const IAbilitySystemDefaultsInterface* Defaults = Cast<IAbilitySystemDefaultsInterface>(NewAvatar);
+	const UNinjaGASDataAsset* AbilityData = Defaults && Defaults->HasAbilityData() ? Defaults->GetAbilityData() : nullptr;
+
+	if (!IsValid(AbilityData) && Defaults && !Defaults->GetSoftAbilityData().IsNull())
+	{
+		// Defaults from the former avatar are kept until the new ones are loaded,
+		// so they can still be swapped by difference, if that's the current setup.
+		LoadDefaultsAsync(Defaults->GetSoftAbilityData(), NewAvatar);
 		return;
 	}
 
+	ApplyAvatarDefaults(AbilityData);
+}
+
+void UNinjaGASAbilitySystemComponent::ApplyAvatarDefaults(const UNinjaGASDataAsset* AbilityData)
+{
+	if (bDiffDefaultsWhenAvatarChanges && IsValid(AvatarHandles.CurrentAbilitySetup) && IsValid(AbilityData))
+	{
+		SwapDefaultsFromData(AbilityData, AvatarHandles);
+		BroadcastDefaultsReady(AbilityData);
+		return;
+	}
+	
 	static constexpr bool bRemovePermanentAttributes = true; 
 	ClearDefaults(AvatarHandles, bRemovePermanentAttributes);
 	
-	const IAbilitySystemDefaultsInterface* Defaults = Cast<IAbilitySystemDefaultsInterface>(NewAvatar);
-	if (Defaults && Defaults->HasAbilityData())
+	if (IsValid(AbilityData))
+	{
+		InitializeFromData(AbilityData, AvatarHandles);
+		BroadcastDefaultsReady(AbilityData);
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::LoadDefaultsAsync(const TSoftObjectPtr<UNinjaGASDataAsset>& SoftAbilityData, const AActor* RequestedAvatar)
+{
+	const bool bFromOwner = RequestedAvatar == nullptr;
+	TSharedPtr<FStreamableHandle>& DefaultsHandle = bFromOwner ? OwnerDefaultsHandle : AvatarDefaultsHandle;
+
+	if (!bFromOwner && DefaultsHandle.IsValid())
+	{
+		// A new avatar replaces any pending request from a former one. Owner requests are
+		// never cancelled, since the owner does not change and only the first load is granted.
+		DefaultsHandle->CancelHandle();
+		DefaultsHandle.Reset();
+	}
+	
+	const TWeakObjectPtr<const AActor> WeakAvatar = RequestedAvatar;
+	if (!SoftAbilityData.IsValid() && UAssetManager::IsInitialized())
+	{
+		UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("[%s] Loading ASC defaults from %s."), *GetNameSafe(GetOwner()), *SoftAbilityData.ToString());
+		
+		const FStreamableDelegate Delegate = FStreamableDelegate::CreateUObject(this, &ThisClass::HandleDefaultsLoaded, SoftAbilityData, WeakAvatar);
+		DefaultsHandle = NinjaGAS::AbilitySystem::RequestAbilityDataLoad(SoftAbilityData, Delegate);
+		return;
+	}
+
+	// Already resident, or too early for the Asset Manager, so defaults are granted right away.
+	SoftAbilityData.LoadSynchronous();
+	HandleDefaultsLoaded(SoftAbilityData, WeakAvatar);
+}
+
+void UNinjaGASAbilitySystemComponent::HandleDefaultsLoaded(const TSoftObjectPtr<UNinjaGASDataAsset> SoftAbilityData, const TWeakObjectPtr<const AActor> RequestedAvatar)
+{
+	const UNinjaGASDataAsset* AbilityData = SoftAbilityData.Get();
+	if (!IsValid(AbilityData))
+	{
+		UE_LOG(LogAbilitySystemComponent, Warning, TEXT("[%s] Unable to load ASC defaults from %s."), *GetNameSafe(GetOwner()), *SoftAbilityData.ToString());
+		return;
+	}
+
+	if (!RequestedAvatar.IsExplicitlyNull())
 	{
-		const UNinjaGASDataAsset* AbilityData = Defaults->GetAbilityData();
-		if (IsValid(AbilityData))
+		// The avatar may have changed or been destroyed while the data was loading.
+		if (RequestedAvatar.IsValid() && RequestedAvatar.Get() == GetAvatarActor())
 		{
-			InitializeFromData(AbilityData, AvatarHandles);
+			ApplyAvatarDefaults(AbilityData);
 		}
 	}
+	else if (!OwnerHandles.IsValid())
+	{
+		InitializeFromData(AbilityData, OwnerHandles);
+		BroadcastDefaultsReady(AbilityData);
+	}
+
+	UpdateInitializedState();
+}
+
+void UNinjaGASAbilitySystemComponent::PreloadDefaultsForClient()
+{
+	if (IsOwnerActorAuthoritative() || !UAssetManager::IsInitialized())
+	{
+		return;
+	}
+
+	const IAbilitySystemDefaultsInterface* Defaults = Cast<IAbilitySystemDefaultsInterface>(GetOwner());
+	if (!Defaults || !Defaults->HasAbilityData())
+	{
+		Defaults = Cast<IAbilitySystemDefaultsInterface>(this);
+	}
+
+	const TSoftObjectPtr<UNinjaGASDataAsset> SoftAbilityData = Defaults->GetSoftAbilityData();
+	if (Defaults->GetAbilityData() == nullptr && !SoftAbilityData.IsNull() && !SoftAbilityData.IsValid())
+	{
+		// Only loads the data, defaults are still granted once the actor info is initialized.
+		OwnerDefaultsHandle = NinjaGAS::AbilitySystem::RequestAbilityDataLoad(SoftAbilityData, FStreamableDelegate());
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::BroadcastDefaultsReady(const UNinjaGASDataAsset* AbilityData)
+{
+	// Data loaded asynchronously may register new montages.
+	RebuildMontageRegistry();
+	
+	DefaultsReadyDelegate.Broadcast(AbilityData);
+	OnAbilitySystemDefaultsReady.Broadcast(AbilityData);
+}
+
+bool UNinjaGASAbilitySystemComponent::AreDefaultsLoading() const
+{
+	return (OwnerDefaultsHandle.IsValid() && OwnerDefaultsHandle->IsLoadingInProgress())
+		|| (AvatarDefaultsHandle.IsValid() && AvatarDefaultsHandle->IsLoadingInProgress());
 }
 
 void UNinjaGASAbilitySystemComponent::InitializeFromData(const UNinjaGASDataAsset* AbilityData, FAbilityDefaultHandles& OutHandles)
 {
+	SCOPE_CYCLE_COUNTER(STAT_NinjaGAS_InitializeFromData);
+	
 	if (!IsValid(AbilityData))
 	{
 		return;
 	}
 
-	const TArray<FDefaultAttributeSet>& AttributeSets = AbilityData->DefaultAttributeSets;
-	InitializeAttributeSets(AttributeSets, OutHandles);
-
 	int32 TagCount = 0;
 	const bool bIsAuth = IsOwnerActorAuthoritative(); 
 
+	// Plans are compiled once per data asset and shared by all components using it.
+	const TSharedPtr<const FNinjaAbilityGrantPlan> GrantPlan = UNinjaGASGrantPlanSubsystem::FindOrCompileGrantPlan(AbilityData);
+	if (GrantPlan.IsValid())
+	{
+		GrantPlan->ReserveHandles(OutHandles, bIsAuth);
+		InitializeAttributeSets(*GrantPlan, OutHandles);
+	}
+	else
+	{
+		const TArray<FDefaultAttributeSet>& AttributeSets = AbilityData->DefaultAttributeSets;
+		InitializeAttributeSets(AttributeSets, OutHandles);
+	}
+
 	if (bIsAuth)
 	{
-		const TArray<FDefaultGameplayEffect>& GameplayEffects = AbilityData->DefaultGameplayEffects;
-		InitializeGameplayEffects(GameplayEffects, OutHandles);
+		if (GrantPlan.IsValid())
+		{
+			InitializeGameplayEffects(*GrantPlan, OutHandles);
+			InitializeGameplayAbilities(*GrantPlan, OutHandles);
+		}
+		else
+		{
+			const TArray<FDefaultGameplayEffect>& GameplayEffects = AbilityData->DefaultGameplayEffects;
+			InitializeGameplayEffects(GameplayEffects, OutHandles);
 
-		const TArray<FDefaultGameplayAbility>& GameplayAbilities = AbilityData->DefaultGameplayAbilities;
-		InitializeGameplayAbilities(GameplayAbilities, OutHandles);
+			const TArray<FDefaultGameplayAbility>& GameplayAbilities = AbilityData->DefaultGameplayAbilities;
+			InitializeGameplayAbilities(GameplayAbilities, OutHandles);
+		}
 
 		const FGameplayTagContainer& InitialGameplayTags = AbilityData->InitialGameplayTags; 
 		if (InitialGameplayTags.IsValid())
@@ -164,35 +515,61 @@ void UNinjaGASAbilitySystemComponent::InitializeAttributeSets(const TArray<FDefa
 				continue;	
 			}
 
-			if (GetSpawnedAttributes().ContainsByPredicate([AttributeSetClass](const UAttributeSet* AttributeSet){ return AttributeSet->GetClass() == AttributeSetClass; }))
-			{
-				UE_LOG(LogAbilitySystemComponent, Warning, TEXT("Discarding Attribute Set %s since it was already spawned!"), *GetNameSafe(AttributeSetClass));
-				continue;
-			}
-		
-			UAttributeSet* NewAttributeSet = NewObject<UAttributeSet>(GetOwner(), AttributeSetClass);
-			check(IsValid(NewAttributeSet));
-		
-			const UDataTable* AttributeTable = Entry.AttributeTable;
-			if (IsValid(AttributeTable))
-			{
-				NewAttributeSet->InitFromMetaDataTable(AttributeTable);
-			}
+			InitializeAttributeSet(AttributeSetClass, Entry.AttributeTable, Entry.IsPermanent(), OutHandles);
+		}
+	}	
+}
+
+void UNinjaGASAbilitySystemComponent::InitializeAttributeSets(const FNinjaAbilityGrantPlan& GrantPlan, FAbilityDefaultHandles& OutHandles)
+{
+	const bool bIsAuth = IsOwnerActorAuthoritative();
+	
+	for (const FNinjaAbilityGrantPlan::FAttributeSetEntry& Entry : GrantPlan.AttributeSets)
+	{
+		if (FNinjaAbilityGrantPlan::AppliesTo(Entry, bIsAuth))
+		{
+			InitializeAttributeSet(Entry.AttributeSetClass, Entry.AttributeTable, Entry.bPermanent, OutHandles);
+		}
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::InitializeAttributeSet(const TSubclassOf<UAttributeSet>& AttributeSetClass, const UDataTable* AttributeTable, const bool bPermanent, FAbilityDefaultHandles& OutHandles)
+{
+	if (FindAttributeSetByClass(AttributeSetClass) != nullptr)
+	{
+		UE_LOG(LogAbilitySystemComponent, Warning, TEXT("Discarding Attribute Set %s since it was already spawned!"), *GetNameSafe(AttributeSetClass));
+		return;
+	}
 
-			AddAttributeSetSubobject(NewAttributeSet);
+	UAttributeSet* NewAttributeSet = AcquireAttributeSet(AttributeSetClass);
+	check(IsValid(NewAttributeSet));
 
-			if (Entry.IsPermanent())
-			{
-				OutHandles.PermanentAttributes.Add(NewAttributeSet);
-				UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("Initialized permanent Attribute Set %s with %s."), *GetNameSafe(NewAttributeSet), *GetNameSafe(AttributeTable));
-			}
-			else
-			{
-				OutHandles.TemporaryAttributes.Add(NewAttributeSet);
-				UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("Initialized temporary Attribute Set %s with %s."), *GetNameSafe(NewAttributeSet), *GetNameSafe(AttributeTable));
-			}
+	if (IsValid(AttributeTable))
+	{
+		// Baked layouts avoid the per-property row lookups done by the engine.
+		const TSharedPtr<const FNinjaAttributeTableLayout> TableLayout = UNinjaGASGrantPlanSubsystem::FindOrBuildAttributeTableLayout(AttributeSetClass, AttributeTable);
+		if (TableLayout.IsValid())
+		{
+			TableLayout->Apply(NewAttributeSet);
 		}
-	}	
+		else
+		{
+			NewAttributeSet->InitFromMetaDataTable(AttributeTable);
+		}
+	}
+
+	RegisterAttributeSet(NewAttributeSet);
+
+	if (bPermanent)
+	{
+		OutHandles.PermanentAttributes.Add(NewAttributeSet);
+		UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("Initialized permanent Attribute Set %s with %s."), *GetNameSafe(NewAttributeSet), *GetNameSafe(AttributeTable));
+	}
+	else
+	{
+		OutHandles.TemporaryAttributes.Add(NewAttributeSet);
+		UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("Initialized temporary Attribute Set %s with %s."), *GetNameSafe(NewAttributeSet), *GetNameSafe(AttributeTable));
+	}
 }
 
 void UNinjaGASAbilitySystemComponent::InitializeGameplayEffects(const TArray<FDefaultGameplayEffect>& GameplayEffects, FAbilityDefaultHandles& OutHandles)
@@ -202,7 +579,8 @@ void UNinjaGASAbilitySystemComponent::InitializeGameplayEffects(const TArray<FDe
 	{
 		const int32 NewSize = OutHandles.DefaultEffectHandles.Num() + GameplayEffectCount;  
 		OutHandles.DefaultEffectHandles.Reserve(NewSize);
-		
+
+		FScopedNinjaDeferredAggregation DeferredAggregation(*this);
 		for (const FDefaultGameplayEffect& Entry : GameplayEffects)
 		{
 			const TSubclassOf<UGameplayEffect> GameplayEffectClass = Entry.GameplayEffectClass;
@@ -215,6 +593,35 @@ void UNinjaGASAbilitySystemComponent::InitializeGameplayEffects(const TArray<FDe
 	}
 }
 
+void UNinjaGASAbilitySystemComponent::InitializeGameplayEffects(const FNinjaAbilityGrantPlan& GrantPlan, FAbilityDefaultHandles& OutHandles)
+{
+	if (GrantPlan.GameplayEffects.IsEmpty())
+	{
+		return;
+	}
+	
+	FScopedNinjaDeferredAggregation DeferredAggregation(*this);
+	for (const FNinjaAbilityGrantPlan::FGameplayEffectEntry& Entry : GrantPlan.GameplayEffects)
+	{
+		FGameplayEffectContextHandle ContextHandle = MakeEffectContext();
+		ContextHandle.AddSourceObject(GetOwner());
+
+		const FGameplayEffectSpecHandle SpecHandle = MakeOutgoingSpec(Entry.GameplayEffectClass, Entry.Level, ContextHandle);
+		if (!SpecHandle.IsValid())
+		{
+			continue;
+		}
+		
+		FActiveGameplayEffectHandle Handle = ApplyGameplayEffectSpecToSelf(*SpecHandle.Data.Get());
+		if (Handle.IsValid() && Handle.WasSuccessfullyApplied())
+		{
+			OutHandles.DefaultEffectHandles.Add(Handle);
+			UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("[%s] Effect '%s' granted at level %f."),
+				*GetNameSafe(GetAvatarActor()), *GetNameSafe(Entry.GameplayEffectClass), Entry.Level);
+		}
+	}
+}
+
 void UNinjaGASAbilitySystemComponent::InitializeGameplayAbilities(const TArray<FDefaultGameplayAbility>& GameplayAbilities, FAbilityDefaultHandles& OutHandles)
 {
 	const int32 GameplayAbilityCount = GameplayAbilities.Num(); 
@@ -222,7 +629,8 @@ void UNinjaGASAbilitySystemComponent::InitializeGameplayAbilities(const TArray<F
 	{
 		const int32 NewSize = OutHandles.DefaultAbilityHandles.Num() + GameplayAbilityCount; 
 		OutHandles.DefaultAbilityHandles.Reserve(NewSize);
-		
+
+		FScopedNinjaAbilityBulkUpdate BulkUpdate(*this);
 		for (const FDefaultGameplayAbility& Entry : GameplayAbilities)
 		{
 			const TSubclassOf<UGameplayAbility> GameplayAbilityClass = Entry.GameplayAbilityClass;
@@ -235,6 +643,24 @@ void UNinjaGASAbilitySystemComponent::InitializeGameplayAbilities(const TArray<F
 	}
 }
 
+void UNinjaGASAbilitySystemComponent::InitializeGameplayAbilities(const FNinjaAbilityGrantPlan& GrantPlan, FAbilityDefaultHandles& OutHandles)
+{
+	if (GrantPlan.AbilitySpecTemplates.IsEmpty())
+	{
+		return;
+	}
+	
+	TArray<FGameplayAbilitySpec> NewAbilitySpecs(GrantPlan.AbilitySpecTemplates);
+	for (FGameplayAbilitySpec& NewAbilitySpec : NewAbilitySpecs)
+	{
+		// Each granted copy needs its own handle, since the template handle is shared.
+		NewAbilitySpec.Handle.GenerateNewHandle();
+		NewAbilitySpec.SourceObject = GetOwner();
+	}
+
+	GiveAbilitiesInBulk(NewAbilitySpecs, OutHandles.DefaultAbilityHandles);
+}
+
 FActiveGameplayEffectHandle UNinjaGASAbilitySystemComponent::ApplyGameplayEffectClassToSelf(const TSubclassOf<UGameplayEffect> EffectClass, const float Level)
 {
 	FActiveGameplayEffectHandle Handle;
@@ -266,15 +692,55 @@ FGameplayAbilitySpecHandle UNinjaGASAbilitySystemComponent::GiveAbilityFromClass
 		const FGameplayAbilitySpec NewAbilitySpec(FGameplayAbilitySpec(AbilityClass, Level, Input, GetOwner()));
 		Handle = GiveAbility(NewAbilitySpec);
 
-		UE_LOG(LogAbilitySystemComponent, Log, TEXT("[%s] Ability '%s' %s at level %d."),
-			*GetNameSafe(GetAvatarActor()), *GetNameSafe(AbilityClass),
-			Handle.IsValid() ? TEXT("successfully granted") : TEXT("failed to be granted"), Level);
+		if (BulkAbilityUpdateCount > 0)
+		{
+			// Bulk updates log a summary when they finish.
+			UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("[%s] Ability '%s' %s at level %d."),
+				*GetNameSafe(GetAvatarActor()), *GetNameSafe(AbilityClass),
+				Handle.IsValid() ? TEXT("successfully granted") : TEXT("failed to be granted"), Level);
+		}
+		else
+		{
+			UE_LOG(LogAbilitySystemComponent, Log, TEXT("[%s] Ability '%s' %s at level %d."),
+				*GetNameSafe(GetAvatarActor()), *GetNameSafe(AbilityClass),
+				Handle.IsValid() ? TEXT("successfully granted") : TEXT("failed to be granted"), Level);
+		}
 	}
 
 	return Handle;
 }
 
-bool UNinjaGASAbilitySystemComponent::TryBatchActivateAbility(const FGameplayAbilitySpecHandle AbilityHandle, const bool bEndAbilityImmediately)
+void UNinjaGASAbilitySystemComponent::GiveAbilitiesInBulk(const TConstArrayView<FGameplayAbilitySpec> AbilitySpecs, TArray<FGameplayAbilitySpecHandle>& OutHandles)
+{
+	OutHandles.Reserve(OutHandles.Num() + AbilitySpecs.Num());
+	FScopedNinjaAbilityBulkUpdate BulkUpdate(*this);
+	
+	for (const FGameplayAbilitySpec& AbilitySpec : AbilitySpecs)
+	{
+		FGameplayAbilitySpecHandle Handle = GiveAbility(AbilitySpec);
+		if (Handle.IsValid())
+		{
+			OutHandles.Add(Handle);
+		}
+		
+		UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("[%s] Ability '%s' %s at level %d."),
+			*GetNameSafe(GetAvatarActor()), *GetNameSafe(AbilitySpec.Ability),
+			Handle.IsValid() ? TEXT("successfully granted") : TEXT("failed to be granted"), AbilitySpec.Level);
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::RemoveAbilitiesInBulk(const TConstArrayView<FGameplayAbilitySpecHandle> AbilityHandles)
+{
+	// Inactive abilities are removed when the outermost lock is released, all together.
+	ABILITYLIST_SCOPE_LOCK();
+	
+	for (const FGameplayAbilitySpecHandle& Handle : AbilityHandles)
+	{
+		RemoveDefaultAbility(Handle);
+	}
+}
+
+bool UNinjaGASAbilitySystemComponent::TryBatchActivateAbility(const FGameplayAbilitySpecHandle AbilityHandle, const bool bEndAbilityImmediately)
 {
 	bool bAbilityActivated = false;
 	if (AbilityHandle.IsValid())
@@ -343,9 +809,96 @@ void UNinjaGASAbilitySystemComponent::ResetAbilitySystemComponent()
 	ClearDefaults(AvatarHandles, bRemovePermanentAttributes);
 }
 
+void UNinjaGASAbilitySystemComponent::ResetForRecycling()
+{
+	// Deferred aggregation scopes are not reset, since they close their batch when the stack unwinds.
+	BulkAbilityUpdateCount = 0;
+	PendingGivenAbilityHandles.Reset();
+
+	if (OwnerDefaultsHandle.IsValid())
+	{
+		OwnerDefaultsHandle->CancelHandle();
+		OwnerDefaultsHandle.Reset();
+	}
+
+	ResetAbilitySystemComponent();
+	ClearActorInfo();
+
+	// Anything granted by other sources would leak into the next owner.
+	ClearAllAbilities();
+	RemoveActiveEffects(FGameplayEffectQuery());
+	RemoveAllSpawnedAttributes();
+	PooledAttributeSets.Reset();
+	InvalidateAttributeSetIndex();
+	bHasIdleBaseline = false;
+	IdleBaselineTags.Reset();
+	IdleBaselineAttributeSets.Reset();
+	IdleBaselineAttributes.Reset();
+
+	LocalAnimMontageInfoForMeshes.Reset();
+	LocalAnimMontageSlotIndices.Reset();
+	RepAnimMontageInfoForMeshes.Entries.Reset();
+	RepAnimMontageInfoForMeshes.InvalidateEntryIndices();
+	RepAnimMontageInfoForMeshes.MarkArrayDirty();
+	MontageGroupFollowers.Reset();
+	PendingMontageReplications.Reset();
+	PendingMontageNetUpdateRequests = 0;
+
+	// Windows driven from montage time still hold whatever they applied.
+	TArray<FDrivenMontageNotifyWindows> ActiveNotifyWindows = MoveTemp(DrivenNotifyWindows);
+	for (FDrivenMontageNotifyWindows& Driven : ActiveNotifyWindows)
+	{
+		EndDrivenNotifyWindows(Driven);
+	}
+
+	DrivenNotifyWindows.Reset();
+
+	for (const TPair<TObjectKey<USkeletalMeshComponent>, FDeferredMontageCorrection>& Entry : DeferredMontageCorrections)
+	{
+		if (USkeletalMeshComponent* Mesh = Entry.Value.Mesh.Get())
+		{
+			Mesh->UnregisterOnBoneTransformsFinalizedDelegate(Entry.Value.EvaluatedHandle);
+		}
+	}
+
+	DeferredMontageCorrections.Reset();
+	PendingMontageCommands.Reset();
+	ThrottledMontageCommands.Reset();
+	NextMontageCommandSequence = 0;
+	LastMontageCommandSequence = 0;
+	bHasReceivedMontageCommands = false;
+
+	if (const UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearAllTimersForObject(this);
+	}
+}
+
 void UNinjaGASAbilitySystemComponent::ClearActorInfo()
 {
-	ClearDefaults(AvatarHandles);
+	if (AvatarDefaultsHandle.IsValid())
+	{
+		AvatarDefaultsHandle->CancelHandle();
+		AvatarDefaultsHandle.Reset();
+	}
+
+	if (UNinjaGASInitializationSubsystem* Scheduler = GetInitializationScheduler())
+	{
+		Scheduler->Dequeue(this);
+	}
+
+	bAbilitySystemInitialized = false;
+
+	// Setups swapped by difference are only suspended, so the next avatar only grants and revokes what changes.
+	if (bDiffDefaultsWhenAvatarChanges && IsValid(AvatarHandles.CurrentAbilitySetup))
+	{
+		SuspendDefaults(AvatarHandles);
+	}
+	else
+	{
+		ClearDefaults(AvatarHandles);
+	}
+	
 	Super::ClearActorInfo();
 }
 
@@ -391,29 +944,31 @@ bool UNinjaGASAbilitySystemComponent::ShouldDoServerAbilityRPCBatch() const
 void UNinjaGASAbilitySystemComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-	DOREPLIFETIME(ThisClass, RepAnimMontageInfoForMeshes);
+	
+	// Autonomous proxies play their own montages and ignore the replicated ones.
+	DOREPLIFETIME_CONDITION(ThisClass, RepAnimMontageInfoForMeshes, COND_SkipOwner);
 }
 
 bool UNinjaGASAbilitySystemComponent::GetShouldTick() const
 {
-	for (const FGameplayAbilityRepAnimMontageForMesh& RepMontageInfo : RepAnimMontageInfoForMeshes.Entries)
+	if (MontageReplicationUpdateMode == EMontageReplicationUpdateMode::Tick && HasPlayingReplicatedMontages())
 	{
-		const bool bHasReplicatedMontageInfoToUpdate = IsOwnerActorAuthoritative() && RepMontageInfo.RepMontageInfo.IsStopped == false;
-		if (bHasReplicatedMontageInfoToUpdate)
-		{
-			return true;
-		}
+		return true;
 	}
+	
 	return Super::GetShouldTick();
 }
 
 void UNinjaGASAbilitySystemComponent::TickComponent(float const DeltaTime, const ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
-	if (IsOwnerActorAuthoritative())
+	if (MontageReplicationUpdateMode == EMontageReplicationUpdateMode::Tick && IsOwnerActorAuthoritative())
 	{
 		for (const FGameplayAbilityLocalAnimMontageForMesh& MontageInfo : LocalAnimMontageInfoForMeshes)
 		{
-			AnimMontage_UpdateReplicatedDataForMesh(MontageInfo.Mesh);
+			if (IsValid(MontageInfo.Mesh))
+			{
+				AnimMontage_UpdateReplicatedDataForMesh(MontageInfo.Mesh);
+			}
 		}
 	}
 	
@@ -443,6 +998,11 @@ const UNinjaGASDataAsset* UNinjaGASAbilitySystemComponent::GetAbilityData() cons
 	return DefaultAbilitySetup;
 }
 
+TSoftObjectPtr<UNinjaGASDataAsset> UNinjaGASAbilitySystemComponent::GetSoftAbilityData() const
+{
+	return SoftAbilitySetup;
+}
+
 void UNinjaGASAbilitySystemComponent::DeferredSetBaseAttributeValueFromReplication(const FGameplayAttribute& Attribute, const float NewValue)
 {
 	const float OldValue = ActiveGameplayEffects.GetAttributeBaseValue(Attribute);
@@ -457,60 +1017,318 @@ void UNinjaGASAbilitySystemComponent::DeferredSetBaseAttributeValueFromReplicati
 	SetBaseAttributeValueFromReplication(Attribute, NewValue.GetBaseValue(), OldValue);
 }
 
-void UNinjaGASAbilitySystemComponent::ClearDefaults(FAbilityDefaultHandles& Handles, const bool bRemovePermanentAttributes)
+void UNinjaGASAbilitySystemComponent::DeferredSetBaseAttributeValuesFromReplication(const TConstArrayView<FPendingAttributeReplication> PendingAttributes)
 {
-	int32 TagCount = 0;
-	int32 AbilityHandleCount = 0;
-	int32 EffectHandleCount = 0;
-	int32 PermanentAttributeSetCount = 0;
-	int32 TemporaryAttributeSetCount = 0;
+	if (PendingAttributes.IsEmpty())
+	{
+		return;
+	}
+	
+	// All base values are written before notifying, so listeners observe the final state.
+	TArray<float, TInlineAllocator<16>> OldValues;
+	OldValues.Reserve(PendingAttributes.Num());
+	
+	for (const FPendingAttributeReplication& Pending : PendingAttributes)
+	{
+		OldValues.Add(ActiveGameplayEffects.GetAttributeBaseValue(Pending.Attribute));
+		ActiveGameplayEffects.SetAttributeBaseValue(Pending.Attribute, Pending.NewValue.GetBaseValue());
+	}
 
-	const bool bIsAuth = IsOwnerActorAuthoritative(); 
-	if (bIsAuth)
+	for (int32 Index = 0; Index < PendingAttributes.Num(); ++Index)
+	{
+		const FPendingAttributeReplication& Pending = PendingAttributes[Index];
+		SetBaseAttributeValueFromReplication(Pending.Attribute, Pending.NewValue.GetBaseValue(), OldValues[Index]);
+	}
+
+	PendingAttributesAppliedDelegate.Broadcast(PendingAttributes);
+
+	UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("Applied %d pending attributes from replication."), PendingAttributes.Num());
+}
+
+UAttributeSet* UNinjaGASAbilitySystemComponent::FindAttributeSetByClass(const TSubclassOf<UAttributeSet>& AttributeSetClass) const
+{
+	EnsureAttributeSetIndex();
+	UAttributeSet* const* AttributeSet = AttributeSetsByClass.Find(AttributeSetClass.Get());
+	return AttributeSet ? *AttributeSet : nullptr;
+}
+
+UAttributeSet* UNinjaGASAbilitySystemComponent::FindAttributeSetForAttribute(const FGameplayAttribute& Attribute) const
+{
+	if (!Attribute.IsValid())
+	{
+		return nullptr;
+	}
+	
+	EnsureAttributeSetIndex();
+	UAttributeSet* const* AttributeSet = AttributeSetsByOwnerClass.Find(Attribute.GetAttributeSetClass().Get());
+	return AttributeSet ? *AttributeSet : nullptr;
+}
+
+bool UNinjaGASAbilitySystemComponent::IsAttributeAvailable(const FGameplayAttribute& Attribute) const
+{
+	return Attribute.IsValid() && (Attribute.IsSystemAttribute() || FindAttributeSetForAttribute(Attribute) != nullptr);
+}
+
+void UNinjaGASAbilitySystemComponent::CaptureIdleBaseline()
+{
+	IdleBaselineTags = GameplayTagCountContainer.GetExplicitGameplayTags();
+	IdleBaselineAttributeSets.Reset();
+	IdleBaselineAttributes.Reset();
+
+	// Attributes are reflected once, so idle checks only read them back by offset.
+	const TArray<UAttributeSet*>& SpawnedAttributes = GetSpawnedAttributes();
+	for (int32 SetIndex = 0; SetIndex < SpawnedAttributes.Num(); ++SetIndex)
 	{
-		FGameplayTagContainer InitialGameplayTags = FGameplayTagContainer::EmptyContainer;  
-		if (IsValid(Handles.CurrentAbilitySetup))
+		const UAttributeSet* AttributeSet = SpawnedAttributes[SetIndex];
+		IdleBaselineAttributeSets.Add(AttributeSet);
+		
+		if (!IsValid(AttributeSet))
+		{
+			continue;
+		}
+
+		for (TFieldIterator<FProperty> It(AttributeSet->GetClass()); It; ++It)
 		{
-			InitialGameplayTags = Handles.CurrentAbilitySetup->InitialGameplayTags;
-			if (InitialGameplayTags.IsValid())
+			FProperty* Property = *It;
+			if (FGameplayAttribute::IsGameplayAttributeDataProperty(Property))
 			{
-				TagCount = InitialGameplayTags.Num();
+				const FGameplayAttributeData* Data = Property->ContainerPtrToValuePtr<FGameplayAttributeData>(AttributeSet);
+				IdleBaselineAttributes.Emplace(FGameplayAttribute(Property), SetIndex, Property->GetOffset_ForInternal(), *Data);
+			}
+		}
+	}
+	
+	bHasIdleBaseline = true;
+}
+
+bool UNinjaGASAbilitySystemComponent::IsIdle() const
+{
+	if (!bHasIdleBaseline || !bAbilitySystemInitialized || !HasIdleBaselineAttributeSets())
+	{
+		return false;
+	}
+
+	for (const FGameplayAbilitySpec& Spec : GetActivatableAbilities())
+	{
+		if (Spec.IsActive())
+		{
+			return false;
+		}
+	}
+
+	for (auto It = ActiveGameplayEffects.CreateConstIterator(); It; ++It)
+	{
+		if (!IsDefaultGameplayEffect(It->Handle))
+		{
+			return false;
+		}
+	}
+
+	if (GameplayTagCountContainer.GetExplicitGameplayTags() != IdleBaselineTags)
+	{
+		return false;
+	}
 
-				#if (ENGINE_MAJOR_VERSION > 5) || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 7)
-				RemoveLooseGameplayTags(InitialGameplayTags);
-				#else
-				RemoveReplicatedLooseGameplayTags(InitialGameplayTags);
-				#endif
-			}	
+	// Default effects may keep infinite modifiers, so current values are compared to the baseline instead of the base.
+	const TArray<UAttributeSet*>& SpawnedAttributes = GetSpawnedAttributes();
+	for (const FNinjaIdleAttributeBaseline& Baseline : IdleBaselineAttributes)
+	{
+		const FGameplayAttributeData& Current = Baseline.GetCurrentData(SpawnedAttributes[Baseline.AttributeSetIndex]);
+		if (!NinjaGAS::AbilitySystem::HasBaselineModifiers(Baseline.Value, Current))
+		{
+			return false;
 		}
+	}
+
+	return true;
+}
+
+void UNinjaGASAbilitySystemComponent::GetNonBaselineAttributes(TArray<FPendingAttributeReplication>& OutAttributes) const
+{
+	if (!bHasIdleBaseline || !HasIdleBaselineAttributeSets())
+	{
+		// Attribute Sets changed since the baseline, so every attribute is collected.
+		CollectAttributeData(OutAttributes);
+		return;
+	}
 	
-		for (auto It(Handles.DefaultAbilityHandles.CreateIterator()); It; ++It)
+	const TArray<UAttributeSet*>& SpawnedAttributes = GetSpawnedAttributes();
+	for (const FNinjaIdleAttributeBaseline& Baseline : IdleBaselineAttributes)
+	{
+		const FGameplayAttributeData& Current = Baseline.GetCurrentData(SpawnedAttributes[Baseline.AttributeSetIndex]);
+		if (!FMath::IsNearlyEqual(Baseline.Value.GetBaseValue(), Current.GetBaseValue()))
 		{
-			const FGameplayAbilitySpecHandle& Handle = *It;
-			const FGameplayAbilitySpec* Spec = FindAbilitySpecFromHandle(Handle);
-		
-			if (Spec && Spec->Ability->GetAssetTags().HasTagExact(Tag_GAS_Ability_Passive))
+			OutAttributes.Emplace(Baseline.Attribute, Current);
+		}
+	}
+}
+
+bool UNinjaGASAbilitySystemComponent::HasIdleBaselineAttributeSets() const
+{
+	const TArray<UAttributeSet*>& SpawnedAttributes = GetSpawnedAttributes();
+	if (SpawnedAttributes.Num() != IdleBaselineAttributeSets.Num())
+	{
+		return false;
+	}
+
+	for (int32 SetIndex = 0; SetIndex < SpawnedAttributes.Num(); ++SetIndex)
+	{
+		if (!IsValid(SpawnedAttributes[SetIndex]) || IdleBaselineAttributeSets[SetIndex] != TObjectKey<UAttributeSet>(SpawnedAttributes[SetIndex]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void UNinjaGASAbilitySystemComponent::CollectAttributeData(TArray<FPendingAttributeReplication>& OutAttributes) const
+{
+	for (const UAttributeSet* AttributeSet : GetSpawnedAttributes())
+	{
+		if (!IsValid(AttributeSet))
+		{
+			continue;
+		}
+
+		for (TFieldIterator<FProperty> It(AttributeSet->GetClass()); It; ++It)
+		{
+			FProperty* Property = *It;
+			if (FGameplayAttribute::IsGameplayAttributeDataProperty(Property))
 			{
-				// A passive ability will not end, so we need to deliberately cancel it first.
-				CancelAbilityHandle(Handle);
+				const FGameplayAttributeData* Data = Property->ContainerPtrToValuePtr<FGameplayAttributeData>(AttributeSet);
+				OutAttributes.Emplace(FPendingAttributeReplication(FGameplayAttribute(Property), *Data));
 			}
-		
-			SetRemoveAbilityOnEnd(Handle);	
-			It.RemoveCurrent();
-			++AbilityHandleCount;
 		}
+	}
+}
+
+bool UNinjaGASAbilitySystemComponent::IsDefaultGameplayEffect(const FActiveGameplayEffectHandle& Handle) const
+{
+	return OwnerHandles.DefaultEffectHandles.Contains(Handle) || AvatarHandles.DefaultEffectHandles.Contains(Handle);
+}
+
+void UNinjaGASAbilitySystemComponent::RegisterAttributeSet(UAttributeSet* AttributeSet)
+{
+	check(IsValid(AttributeSet));
+	
+	EnsureAttributeSetIndex();
+	AddAttributeSetSubobject(AttributeSet);
+	IndexAttributeSet(AttributeSet);
+	IndexedAttributeSetCount = GetSpawnedAttributes().Num();
+}
+
+void UNinjaGASAbilitySystemComponent::UnregisterAttributeSet(UAttributeSet* AttributeSet)
+{
+	RemoveSpawnedAttribute(AttributeSet);
+
+	// Another set in the same hierarchy may take over, so the index is rebuilt on the next query.
+	// This way, clearing all defaults at once only costs one rebuild.
+	InvalidateAttributeSetIndex();
+}
+
+UAttributeSet* UNinjaGASAbilitySystemComponent::AcquireAttributeSet(const TSubclassOf<UAttributeSet>& AttributeSetClass)
+{
+	if (bPoolAttributeSets)
+	{
+		FNinjaPooledAttributeSets* Pool = PooledAttributeSets.Find(AttributeSetClass.Get());
+		UAttributeSet* AttributeSet = Pool && !Pool->AttributeSets.IsEmpty() ? Pool->AttributeSets.Pop().Get() : nullptr;
 		
-		for (auto It(Handles.DefaultEffectHandles.CreateIterator()); It; ++It)
+		if (IsValid(AttributeSet))
 		{
-			RemoveActiveGameplayEffect(*It);
-			It.RemoveCurrent();
-			++EffectHandleCount;
+			// Pooled sets still hold values from their previous use, so restore the class defaults.
+			// Any attribute table is applied on top of this by the caller, just like for new sets.
+			TSharedPtr<const FNinjaAttributeTableLayout> DefaultsLayout = UNinjaGASGrantPlanSubsystem::FindOrBuildAttributeTableLayout(AttributeSetClass, nullptr);
+			if (!DefaultsLayout.IsValid())
+			{
+				DefaultsLayout = FNinjaAttributeTableLayout::Build(AttributeSetClass, nullptr);
+			}
+
+			DefaultsLayout->Apply(AttributeSet);
+
+			++AttributeSetPoolHits;
+			INC_DWORD_STAT(STAT_NinjaGAS_AttributeSetPoolHits);
+			return AttributeSet;
+		}
+
+		++AttributeSetPoolMisses;
+		INC_DWORD_STAT(STAT_NinjaGAS_AttributeSetPoolMisses);
+	}
+
+	return NewObject<UAttributeSet>(GetOwner(), AttributeSetClass);
+}
+
+void UNinjaGASAbilitySystemComponent::ReleaseAttributeSet(UAttributeSet* AttributeSet)
+{
+	UnregisterAttributeSet(AttributeSet);
+
+	if (bPoolAttributeSets && IsValid(AttributeSet))
+	{
+		FNinjaPooledAttributeSets& Pool = PooledAttributeSets.FindOrAdd(AttributeSet->GetClass());
+		if (Pool.AttributeSets.Num() < MaxPooledAttributeSetsPerClass)
+		{
+			Pool.AttributeSets.Add(AttributeSet);
+		}
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::EnsureAttributeSetIndex() const
+{
+	// Sets added or removed by the engine or external code change the count.
+	const TArray<UAttributeSet*>& SpawnedAttributes = GetSpawnedAttributes();
+	if (IndexedAttributeSetGeneration == AttributeSetGeneration && IndexedAttributeSetCount == SpawnedAttributes.Num())
+	{
+		return;
+	}
+
+	AttributeSetsByClass.Reset();
+	AttributeSetsByOwnerClass.Reset();
+	
+	for (UAttributeSet* AttributeSet : SpawnedAttributes)
+	{
+		if (IsValid(AttributeSet))
+		{
+			IndexAttributeSet(AttributeSet);
 		}
 	}
 
+	IndexedAttributeSetGeneration = AttributeSetGeneration;
+	IndexedAttributeSetCount = SpawnedAttributes.Num();
+}
+
+void UNinjaGASAbilitySystemComponent::InvalidateAttributeSetIndex()
+{
+	++AttributeSetGeneration;
+}
+
+void UNinjaGASAbilitySystemComponent::IndexAttributeSet(UAttributeSet* AttributeSet) const
+{
+	const UClass* AttributeSetClass = AttributeSet->GetClass();
+	AttributeSetsByClass.FindOrAdd(AttributeSetClass, AttributeSet);
+
+	for (const UClass* Class = AttributeSetClass; Class && Class != UAttributeSet::StaticClass(); Class = Class->GetSuperClass())
+	{
+		AttributeSetsByOwnerClass.FindOrAdd(Class, AttributeSet);
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::ClearDefaults(FAbilityDefaultHandles& Handles, const bool bRemovePermanentAttributes)
+{
+	int32 TagCount = 0;
+	int32 AbilityHandleCount = 0;
+	int32 EffectHandleCount = 0;
+	int32 PermanentAttributeSetCount = 0;
+	int32 TemporaryAttributeSetCount = 0;
+
+	const bool bIsAuth = IsOwnerActorAuthoritative(); 
+	if (bIsAuth)
+	{
+		RevokeGrantedDefaults(Handles, TagCount, AbilityHandleCount, EffectHandleCount);
+	}
+
 	for (auto It(Handles.TemporaryAttributes.CreateIterator()); It; ++It)
 	{
-		RemoveSpawnedAttribute(*It);
+		ReleaseAttributeSet(*It);
 		It.RemoveCurrent();
 		++TemporaryAttributeSetCount;
 	}
@@ -519,14 +1337,279 @@ void UNinjaGASAbilitySystemComponent::ClearDefaults(FAbilityDefaultHandles& Hand
 	{
 		for (auto It(Handles.PermanentAttributes.CreateIterator()); It; ++It)
 		{
-			RemoveSpawnedAttribute(*It);
+			ReleaseAttributeSet(*It);
 			It.RemoveCurrent();
 			++PermanentAttributeSetCount;
 		}
 	}
 
 	Handles.CurrentAbilitySetup = nullptr;
+	Handles.bSuspended = false;
 
 	UE_LOG(LogAbilitySystemComponent, Log, TEXT("Cleared Gameplay Elements on %s for %s: [ Permanent Attribute Sets: %d, Temporary Attribute Sets: %d, Effects: %d, Abilities: %d, Tags: %d ]."),
 		bIsAuth ? TEXT("auth") : TEXT("client"), *GetNameSafe(GetAvatarActor()), PermanentAttributeSetCount, TemporaryAttributeSetCount, EffectHandleCount, AbilityHandleCount, TagCount);
 }
+
+void UNinjaGASAbilitySystemComponent::SuspendDefaults(FAbilityDefaultHandles& Handles)
+{
+	int32 TagCount = 0;
+	int32 AbilityHandleCount = 0;
+	int32 EffectHandleCount = 0;
+
+	if (IsOwnerActorAuthoritative())
+	{
+		RevokeGrantedDefaults(Handles, TagCount, AbilityHandleCount, EffectHandleCount);
+	}
+
+	Handles.bSuspended = true;
+	
+	UE_LOG(LogAbilitySystemComponent, Log, TEXT("Suspended Gameplay Elements from %s for %s: [ Effects: %d, Abilities: %d, Tags: %d ]."),
+		*GetNameSafe(Handles.CurrentAbilitySetup), *GetNameSafe(GetAvatarActor()), EffectHandleCount, AbilityHandleCount, TagCount);
+}
+
+void UNinjaGASAbilitySystemComponent::RevokeGrantedDefaults(FAbilityDefaultHandles& Handles, int32& OutTagCount, int32& OutAbilityCount, int32& OutEffectCount)
+{
+	// Tags from a suspended setup were already removed.
+	if (IsValid(Handles.CurrentAbilitySetup) && !Handles.bSuspended)
+	{
+		const FGameplayTagContainer& InitialGameplayTags = Handles.CurrentAbilitySetup->InitialGameplayTags;
+		if (InitialGameplayTags.IsValid())
+		{
+			OutTagCount = InitialGameplayTags.Num();
+
+			#if (ENGINE_MAJOR_VERSION > 5) || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 7)
+			RemoveLooseGameplayTags(InitialGameplayTags);
+			#else
+			RemoveReplicatedLooseGameplayTags(InitialGameplayTags);
+			#endif
+		}	
+	}
+
+	OutAbilityCount = Handles.DefaultAbilityHandles.Num();
+	RemoveAbilitiesInBulk(Handles.DefaultAbilityHandles);
+	Handles.DefaultAbilityHandles.Reset();
+	
+	FScopedNinjaDeferredAggregation DeferredAggregation(*this);
+	for (auto It(Handles.DefaultEffectHandles.CreateIterator()); It; ++It)
+	{
+		RemoveActiveGameplayEffect(*It);
+		It.RemoveCurrent();
+		++OutEffectCount;
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::RemoveDefaultAbility(const FGameplayAbilitySpecHandle& Handle)
+{
+	const FGameplayAbilitySpec* Spec = FindAbilitySpecFromHandle(Handle);
+	if (Spec && Spec->Ability->GetAssetTags().HasTagExact(Tag_GAS_Ability_Passive))
+	{
+		// A passive ability will not end, so we need to deliberately cancel it first.
+		CancelAbilityHandle(Handle);
+	}
+
+	SetRemoveAbilityOnEnd(Handle);
+}
+
+void UNinjaGASAbilitySystemComponent::SwapDefaultsFromData(const UNinjaGASDataAsset* AbilityData, FAbilityDefaultHandles& Handles)
+{
+	const UNinjaGASDataAsset* PreviousData = Handles.CurrentAbilitySetup;
+	check(IsValid(PreviousData) && IsValid(AbilityData));
+
+	int32 KeptCount = 0;
+	int32 GrantedCount = 0;
+	int32 RemovedCount = 0;
+	const bool bIsAuth = IsOwnerActorAuthoritative();
+
+	// The difference is granted through the same plan helpers used by a full initialization.
+	const TSharedPtr<const FNinjaAbilityGrantPlan> CachedPlan = UNinjaGASGrantPlanSubsystem::FindOrCompileGrantPlan(AbilityData);
+	const TSharedRef<const FNinjaAbilityGrantPlan> GrantPlan = CachedPlan.IsValid() ? CachedPlan.ToSharedRef() : FNinjaAbilityGrantPlan::Compile(AbilityData);
+	FNinjaAbilityGrantPlan DiffPlan;
+
+	// Attribute Sets are kept when both setups use the same class and table, so they also keep their values.
+	// Sets from the previous setup are released before granting new ones, since a class may change its table.
+	{
+		TArray<TObjectPtr<UAttributeSet>> CurrentAttributeSets = MoveTemp(Handles.PermanentAttributes);
+		CurrentAttributeSets.Append(MoveTemp(Handles.TemporaryAttributes));
+		Handles.PermanentAttributes.Reset();
+		Handles.TemporaryAttributes.Reset();
+		
+		for (const FNinjaAbilityGrantPlan::FAttributeSetEntry& Entry : GrantPlan->AttributeSets)
+		{
+			if (!FNinjaAbilityGrantPlan::AppliesTo(Entry, bIsAuth))
+			{
+				continue;
+			}
+
+			const FDefaultAttributeSet* PreviousEntry = PreviousData->DefaultAttributeSets.FindByPredicate([&Entry](const FDefaultAttributeSet& Candidate)
+				{ return Candidate.AttributeSetClass == Entry.AttributeSetClass; });
+
+			const bool bSameSetup = PreviousEntry && PreviousEntry->AttributeTable == Entry.AttributeTable;
+			const int32 CurrentIndex = !bSameSetup ? INDEX_NONE : CurrentAttributeSets.IndexOfByPredicate([&Entry](const UAttributeSet* AttributeSet)
+				{ return IsValid(AttributeSet) && AttributeSet->GetClass() == Entry.AttributeSetClass; });
+			
+			if (CurrentIndex != INDEX_NONE)
+			{
+				TArray<TObjectPtr<UAttributeSet>>& TargetAttributes = Entry.bPermanent ? Handles.PermanentAttributes : Handles.TemporaryAttributes;
+				TargetAttributes.Add(CurrentAttributeSets[CurrentIndex]);
+				CurrentAttributeSets.RemoveAtSwap(CurrentIndex);
+				++KeptCount;
+			}
+			else
+			{
+				DiffPlan.AttributeSets.Add(Entry);
+			}
+		}
+
+		for (UAttributeSet* AttributeSet : CurrentAttributeSets)
+		{
+			ReleaseAttributeSet(AttributeSet);
+			++RemovedCount;
+		}
+
+		GrantedCount += DiffPlan.AttributeSets.Num();
+		InitializeAttributeSets(DiffPlan, Handles);
+	}
+
+	if (bIsAuth)
+	{
+		// Gameplay Effects are kept when the same class is active at the same level.
+		TArray<FActiveGameplayEffectHandle> CurrentEffectHandles = MoveTemp(Handles.DefaultEffectHandles);
+		Handles.DefaultEffectHandles.Reset();
+		
+		for (const FNinjaAbilityGrantPlan::FGameplayEffectEntry& Entry : GrantPlan->GameplayEffects)
+		{
+			const int32 CurrentIndex = CurrentEffectHandles.IndexOfByPredicate([this, &Entry](const FActiveGameplayEffectHandle& Handle)
+			{
+				const FActiveGameplayEffect* ActiveEffect = GetActiveGameplayEffect(Handle);
+				return ActiveEffect && ActiveEffect->Spec.Def == Entry.GameplayEffectDefinition
+					&& FMath::IsNearlyEqual(ActiveEffect->Spec.GetLevel(), Entry.Level);
+			});
+
+			if (CurrentIndex != INDEX_NONE)
+			{
+				Handles.DefaultEffectHandles.Add(CurrentEffectHandles[CurrentIndex]);
+				CurrentEffectHandles.RemoveAtSwap(CurrentIndex);
+				++KeptCount;
+			}
+			else
+			{
+				DiffPlan.GameplayEffects.Add(Entry);
+			}
+		}
+
+		{
+			FScopedNinjaDeferredAggregation DeferredAggregation(*this);
+			for (const FActiveGameplayEffectHandle& Handle : CurrentEffectHandles)
+			{
+				RemoveActiveGameplayEffect(Handle);
+				++RemovedCount;
+			}
+
+			GrantedCount += DiffPlan.GameplayEffects.Num();
+			InitializeGameplayEffects(DiffPlan, Handles);
+		}
+
+		// Gameplay Abilities are kept when the same class is granted with the same level and input.
+		TArray<FGameplayAbilitySpecHandle> CurrentAbilityHandles = MoveTemp(Handles.DefaultAbilityHandles);
+		Handles.DefaultAbilityHandles.Reset();
+
+		for (const FGameplayAbilitySpec& Template : GrantPlan->AbilitySpecTemplates)
+		{
+			const int32 CurrentIndex = CurrentAbilityHandles.IndexOfByPredicate([this, &Template](const FGameplayAbilitySpecHandle& Handle)
+			{
+				const FGameplayAbilitySpec* Spec = FindAbilitySpecFromHandle(Handle);
+				return Spec && Spec->Ability && Template.Ability && Spec->Ability->GetClass() == Template.Ability->GetClass()
+					&& Spec->Level == Template.Level && Spec->InputID == Template.InputID;
+			});
+
+			if (CurrentIndex != INDEX_NONE)
+			{
+				Handles.DefaultAbilityHandles.Add(CurrentAbilityHandles[CurrentIndex]);
+				CurrentAbilityHandles.RemoveAtSwap(CurrentIndex);
+				++KeptCount;
+			}
+			else
+			{
+				DiffPlan.AbilitySpecTemplates.Add(Template);
+			}
+		}
+
+		RemovedCount += CurrentAbilityHandles.Num();
+		RemoveAbilitiesInBulk(CurrentAbilityHandles);
+
+		GrantedCount += DiffPlan.AbilitySpecTemplates.Num();
+		InitializeGameplayAbilities(DiffPlan, Handles);
+
+		// Loose tags are only touched when they are exclusive to one of the setups.
+		// Suspended setups have no tags left, so every new tag is added.
+		const FGameplayTagContainer& PreviousTags = Handles.bSuspended ? FGameplayTagContainer::EmptyContainer : PreviousData->InitialGameplayTags;
+		const FGameplayTagContainer& NewTags = AbilityData->InitialGameplayTags;
+		
+		FGameplayTagContainer TagsToRemove;
+		for (const FGameplayTag& Tag : PreviousTags)
+		{
+			if (!NewTags.HasTagExact(Tag))
+			{
+				TagsToRemove.AddTag(Tag);
+			}
+		}
+
+		FGameplayTagContainer TagsToAdd;
+		for (const FGameplayTag& Tag : NewTags)
+		{
+			if (!PreviousTags.HasTagExact(Tag))
+			{
+				TagsToAdd.AddTag(Tag);
+			}
+		}
+
+		RemovedCount += TagsToRemove.Num();
+		GrantedCount += TagsToAdd.Num();
+
+		#if (ENGINE_MAJOR_VERSION > 5) || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 7)
+		RemoveLooseGameplayTags(TagsToRemove);
+		AddLooseGameplayTags(TagsToAdd);
+		#else
+		RemoveReplicatedLooseGameplayTags(TagsToRemove);
+		AddReplicatedLooseGameplayTags(TagsToAdd);
+		#endif
+	}
+
+	Handles.CurrentAbilitySetup = AbilityData;
+	Handles.bSuspended = false;
+	UE_LOG(LogAbilitySystemComponent, Log, TEXT("Swapped ASC defaults on %s from %s to %s: [ Kept: %d, Granted: %d, Removed: %d ]."),
+		bIsAuth ? TEXT("auth") : TEXT("client"), *GetNameSafe(PreviousData), *GetNameSafe(AbilityData), KeptCount, GrantedCount, RemovedCount);
+}
+
+FScopedNinjaAbilityBulkUpdate::FScopedNinjaAbilityBulkUpdate(UNinjaGASAbilitySystemComponent& InAbilitySystemComponent)
+	: AbilitySystemComponent(InAbilitySystemComponent)
+{
+	AbilitySystemComponent.BeginBulkAbilityUpdate();
+}
+
+FScopedNinjaAbilityBulkUpdate::~FScopedNinjaAbilityBulkUpdate()
+{
+	AbilitySystemComponent.EndBulkAbilityUpdate();
+}
+
+FScopedNinjaDeferredAggregation::FScopedNinjaDeferredAggregation(UNinjaGASAbilitySystemComponent& InAbilitySystemComponent)
+	: AbilitySystemComponent(InAbilitySystemComponent)
+{
+	if (AbilitySystemComponent.DeferredAggregationCount++ == 0 && CVarDeferredAggregationEnabled.GetValueOnGameThread())
+	{
+		AggregatorBatch.Emplace();
+	}
+}
+
+FScopedNinjaDeferredAggregation::~FScopedNinjaDeferredAggregation()
+{
+	check(AbilitySystemComponent.DeferredAggregationCount > 0);
+	--AbilitySystemComponent.DeferredAggregationCount;
+	
+	if (AggregatorBatch.IsSet())
+	{
+		// Dirty aggregators are evaluated here, broadcasting each attribute change once.
+		AggregatorBatch.Reset();
+		INC_DWORD_STAT(STAT_NinjaGAS_DeferredAggregationBatches);
+	}
+}
@@ -8,12 +8,21 @@
 // The full MIT license text is included in THIRD_PARTY_NOTICES.md.
 //
 #include "AbilitySystemLog.h"
+#include "NinjaGASFunctionLibrary.h"
+#include "NinjaGASMontageReplicationSubsystem.h"
+#include "NinjaGASStats.h"
 #include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
 #include "Animation/AnimInstance.h"
 #include "Animation/AnimMontage.h"
+#include "Animation/AnimNotifies/AnimNotifyState.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Data/NinjaGASDataAsset.h"
+#include "Engine/NetConnection.h"
 #include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "TimerManager.h"
 #include "Interfaces/AbilityAnimationMontageAwareInterface.h"
+#include "Interfaces/AbilityNotifyWindowInterface.h"
 
 static TAutoConsoleVariable<float> CVarReplayMontageErrorThreshold(
 	TEXT("AbilitySystem.replay.MontageErrorThreshold"),
@@ -21,6 +30,48 @@ static TAutoConsoleVariable<float> CVarReplayMontageErrorThreshold(
 	TEXT("Tolerance level for when montage playback position correction occurs in replays")
 );
 
+static TAutoConsoleVariable<bool> CVarMontageExtrapolation(
+	TEXT("NinjaGAS.MontageReplication.Extrapolation"),
+	true,
+	TEXT("When enabled, replicated montage positions are timestamped by the server and extrapolated by simulated proxies.")
+);
+
+static TAutoConsoleVariable<bool> CVarMontageBudgetAwareCorrections(
+	TEXT("NinjaGAS.MontageReplication.BudgetAwareCorrections"),
+	true,
+	TEXT("When enabled, montage corrections for throttled simulated proxies are deferred until their meshes are evaluated, with thresholds scaled by their update rate.")
+);
+
+static TAutoConsoleVariable<float> CVarMontageMaxExtrapolationSeconds(
+	TEXT("NinjaGAS.MontageReplication.MaxExtrapolationSeconds"),
+	0.5f,
+	TEXT("Maximum time used to extrapolate replicated montage positions. Older positions are extrapolated up to this limit.")
+);
+
+static TAutoConsoleVariable<float> CVarMontageExtrapolatedErrorThreshold(
+	TEXT("NinjaGAS.MontageReplication.ExtrapolatedErrorThreshold"),
+	0.25f,
+	TEXT("Position error, in seconds, tolerated by simulated proxies before correcting an extrapolated montage position.")
+);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Local Montage Slots"), STAT_NinjaGAS_LocalMontageSlots, STATGROUP_NinjaGAS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Montage Slots Pruned"), STAT_NinjaGAS_MontageSlotsPruned, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Dirty Marks Coalesced"), STAT_NinjaGAS_MontageDirtyMarksCoalesced, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Commands Sent"), STAT_NinjaGAS_MontageCommandsSent, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Command Batches Sent"), STAT_NinjaGAS_MontageCommandBatchesSent, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Commands Coalesced"), STAT_NinjaGAS_MontageCommandsCoalesced, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Position Corrections"), STAT_NinjaGAS_MontagePositionCorrections, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Corrections Deferred"), STAT_NinjaGAS_MontageCorrectionsDeferred, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Corrections Merged"), STAT_NinjaGAS_MontageCorrectionsMerged, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Notify Windows Driven"), STAT_NinjaGAS_NotifyWindowsDriven, STATGROUP_NinjaGAS);
+DECLARE_CYCLE_STAT(TEXT("Update Notify Windows"), STAT_NinjaGAS_UpdateNotifyWindows, STATGROUP_NinjaGAS);
+
+namespace NinjaGAS::MontageCommands
+{
+	/** Commands sent in a single batch. Larger batches are rejected by the server. */
+	static constexpr int32 MaxCommandsPerBatch = 32;
+}
+
 float UNinjaGASAbilitySystemComponent::PlayMontageForMesh(UGameplayAbility* AnimatingAbility, USkeletalMeshComponent* InMesh, 
 	FGameplayAbilityActivationInfo ActivationInfo, UAnimMontage* Montage, const float InPlayRate, const bool bOverrideBlendIn, 
 	const FMontageBlendSettings& BlendInOverride, const FName StartSectionName, const float StartTimeSeconds, const bool bReplicateMontage)
@@ -29,16 +80,18 @@ float UNinjaGASAbilitySystemComponent::PlayMontageForMesh(UGameplayAbility* Anim
 
 	float Duration = -1.f;
 
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(InMesh);
 	if (AnimInstance && Montage)
 	{
 		Duration = bOverrideBlendIn ?
 			AnimInstance->Montage_PlayWithBlendSettings(Montage, BlendInOverride, InPlayRate, EMontagePlayReturnType::MontageLength, StartTimeSeconds) :
 			AnimInstance->Montage_Play(Montage, InPlayRate, EMontagePlayReturnType::MontageLength, StartTimeSeconds);
 		
-		if (Duration > 0.f)
+		// Only valid meshes have local montage data.
+		FGameplayAbilityLocalAnimMontageForMesh* LocalMontageInfoForMesh = GetLocalAnimMontageInfoForMesh(InMesh);
+		if (Duration > 0.f && LocalMontageInfoForMesh)
 		{
-			FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+			FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = *LocalMontageInfoForMesh;
 
 			if (AnimMontageInfo.LocalMontageInfo.AnimatingAbility.IsValid() && AnimMontageInfo.LocalMontageInfo.AnimatingAbility != AnimatingAbility)
 			{
@@ -79,6 +132,13 @@ float UNinjaGASAbilitySystemComponent::PlayMontageForMesh(UGameplayAbility* Anim
 				AnimInstance->Montage_JumpToSection(StartSectionName, Montage);
 			}
 
+			if (ShouldDriveNotifyWindows())
+			{
+				StartNotifyWindowsForMesh(InMesh, Montage);
+			}
+
+			PlayMontageOnGroupFollowers(InMesh, Montage, InPlayRate, bOverrideBlendIn, BlendInOverride, StartTimeSeconds);
+
 			// Replicate to non owners.
 			if (IsOwnerActorAuthoritative())
 			{
@@ -88,7 +148,10 @@ float UNinjaGASAbilitySystemComponent::PlayMontageForMesh(UGameplayAbility* Anim
 					AbilityRepMontageInfo.RepMontageInfo.Animation = Montage;
 					AbilityRepMontageInfo.RepMontageInfo.bOverrideBlendIn = bOverrideBlendIn;
 					AbilityRepMontageInfo.RepMontageInfo.BlendInOverride = BlendInOverride;
-					MarkMontageReplicationDirtyForMesh(InMesh);
+					AbilityRepMontageInfo.RepMontageInfo.MontageInstanceId = AbilityRepMontageInfo.RepMontageInfo.MontageInstanceId < UINT8_MAX ? AbilityRepMontageInfo.RepMontageInfo.MontageInstanceId + 1 : 0;
+					
+					static constexpr bool bIsNewInstance = true;
+					MarkMontageReplicationDirtyForMesh(InMesh, bIsNewInstance);
 				}
 			}
 			else
@@ -111,28 +174,206 @@ float UNinjaGASAbilitySystemComponent::PlayMontageSimulatedForMesh(USkeletalMesh
 	const float StartTimeSeconds, FName StartSectionName)
 {
 	float Duration = -1.f;
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(InMesh);
 	if (AnimInstance && Montage)
 	{
 		Duration = bOverrideBlendIn ?
 			AnimInstance->Montage_PlayWithBlendSettings(Montage, BlendInOverride, InPlayRate, EMontagePlayReturnType::MontageLength, StartTimeSeconds) :
 			AnimInstance->Montage_Play(Montage, InPlayRate, EMontagePlayReturnType::MontageLength, StartTimeSeconds);
 		
-		if (Duration > 0.f)
+		FGameplayAbilityLocalAnimMontageForMesh* AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+		if (Duration > 0.f && AnimMontageInfo)
 		{
-			FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
-			AnimMontageInfo.LocalMontageInfo.AnimMontage = Montage;
+			AnimMontageInfo->LocalMontageInfo.AnimMontage = Montage;
+			PlayMontageOnGroupFollowers(InMesh, Montage, InPlayRate, bOverrideBlendIn, BlendInOverride, StartTimeSeconds);
 		}
 	}
 
 	return Duration;	
 }
 
+float UNinjaGASAbilitySystemComponent::PlayMontageForMeshGroup(UGameplayAbility* AnimatingAbility, USkeletalMeshComponent* Leader,
+	const TArray<USkeletalMeshComponent*>& Followers, const FGameplayAbilityActivationInfo ActivationInfo, UAnimMontage* Montage,
+	const float InPlayRate, const bool bOverrideBlendIn, const FMontageBlendSettings& BlendInOverride, const FName StartSectionName,
+	const float StartTimeSeconds, const bool bReplicateMontage)
+{
+	SetMontageGroup(Leader, Followers);
+	return PlayMontageForMesh(AnimatingAbility, Leader, ActivationInfo, Montage, InPlayRate, bOverrideBlendIn, BlendInOverride,
+		StartSectionName, StartTimeSeconds, bReplicateMontage);
+}
+
+void UNinjaGASAbilitySystemComponent::SetMontageGroup(USkeletalMeshComponent* Leader, const TArray<USkeletalMeshComponent*>& Followers)
+{
+	if (!IsValid(Leader))
+	{
+		return;
+	}
+
+	TArray<TWeakObjectPtr<USkeletalMeshComponent>> NewFollowers;
+	NewFollowers.Reserve(Followers.Num());
+	
+	for (USkeletalMeshComponent* Follower : Followers)
+	{
+		if (IsValid(Follower) && Follower != Leader)
+		{
+			NewFollowers.AddUnique(Follower);
+		}
+	}
+
+	if (NewFollowers.IsEmpty())
+	{
+		MontageGroupFollowers.Remove(Leader);
+	}
+	else
+	{
+		MontageGroupFollowers.Add(Leader, MoveTemp(NewFollowers));
+	}
+}
+
+TArray<USkeletalMeshComponent*> UNinjaGASAbilitySystemComponent::GetMontageGroupFollowers(const USkeletalMeshComponent* Leader) const
+{
+	TArray<USkeletalMeshComponent*> Followers;
+	if (const TArray<TWeakObjectPtr<USkeletalMeshComponent>>* GroupFollowers = MontageGroupFollowers.Find(Leader))
+	{
+		for (const TWeakObjectPtr<USkeletalMeshComponent>& Follower : *GroupFollowers)
+		{
+			if (Follower.IsValid())
+			{
+				Followers.Add(Follower.Get());
+			}
+		}
+	}
+
+	return Followers;
+}
+
+void UNinjaGASAbilitySystemComponent::PlayMontageOnGroupFollowers(USkeletalMeshComponent* Leader, UAnimMontage* Montage,
+	const float InPlayRate, const bool bOverrideBlendIn, const FMontageBlendSettings& BlendInOverride, const float StartTimeSeconds)
+{
+	if (!MontageGroupFollowers.Contains(Leader))
+	{
+		return;
+	}
+	
+	for (const USkeletalMeshComponent* Follower : GetMontageGroupFollowers(Leader))
+	{
+		if (UAnimInstance* FollowerAnimInstance = ResolveAnimInstanceForMesh(Follower))
+		{
+			if (bOverrideBlendIn)
+			{
+				FollowerAnimInstance->Montage_PlayWithBlendSettings(Montage, BlendInOverride, InPlayRate, EMontagePlayReturnType::MontageLength, StartTimeSeconds);
+			}
+			else
+			{
+				FollowerAnimInstance->Montage_Play(Montage, InPlayRate, EMontagePlayReturnType::MontageLength, StartTimeSeconds);
+			}
+		}
+	}
+
+	// Picks up the start section and anything else applied to the leader.
+	SyncMontageGroupFollowers(Leader);
+}
+
+void UNinjaGASAbilitySystemComponent::StopMontageOnGroupFollowers(const USkeletalMeshComponent* Leader, const UAnimMontage* Montage, const float BlendOutTime)
+{
+	if (!MontageGroupFollowers.Contains(Leader))
+	{
+		return;
+	}
+	
+	for (const USkeletalMeshComponent* Follower : GetMontageGroupFollowers(Leader))
+	{
+		UAnimInstance* FollowerAnimInstance = ResolveAnimInstanceForMesh(Follower);
+		if (FollowerAnimInstance && FollowerAnimInstance->Montage_IsPlaying(Montage))
+		{
+			FollowerAnimInstance->Montage_Stop(BlendOutTime, Montage);
+		}
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::SyncMontageGroupFollowers(USkeletalMeshComponent* Leader)
+{
+	if (!MontageGroupFollowers.Contains(Leader))
+	{
+		return;
+	}
+
+	UAnimInstance* LeaderAnimInstance;
+	const UAnimMontage* Montage = GetActiveMontageForMesh(Leader, LeaderAnimInstance);
+	const FAnimMontageInstance* LeaderMontageInstance = Montage ? LeaderAnimInstance->GetActiveInstanceForMontage(Montage) : nullptr;
+	if (LeaderMontageInstance == nullptr)
+	{
+		return;
+	}
+
+	const float LeaderPosition = LeaderMontageInstance->GetPosition();
+	const float LeaderPlayRate = LeaderMontageInstance->GetPlayRate();
+	const int32 SectionCount = Montage->CompositeSections.Num();
+
+	for (const USkeletalMeshComponent* Follower : GetMontageGroupFollowers(Leader))
+	{
+		UAnimInstance* FollowerAnimInstance = ResolveAnimInstanceForMesh(Follower);
+		FAnimMontageInstance* FollowerMontageInstance = FollowerAnimInstance ? FollowerAnimInstance->GetActiveInstanceForMontage(Montage) : nullptr;
+		if (FollowerMontageInstance == nullptr)
+		{
+			continue;
+		}
+
+		for (int32 SectionID = 0; SectionID < SectionCount; ++SectionID)
+		{
+			const int32 NextSectionID = LeaderAnimInstance->Montage_GetNextSectionID(Montage, SectionID);
+			if (FollowerAnimInstance->Montage_GetNextSectionID(Montage, SectionID) != NextSectionID)
+			{
+				const FName NextSectionName = NextSectionID != INDEX_NONE ? Montage->GetSectionName(NextSectionID) : NAME_None;
+				FollowerMontageInstance->SetNextSectionName(Montage->GetSectionName(SectionID), NextSectionName);
+			}
+		}
+
+		if (FollowerMontageInstance->GetPlayRate() != LeaderPlayRate)
+		{
+			FollowerMontageInstance->SetPlayRate(LeaderPlayRate);
+		}
+
+		if (!FMath::IsNearlyEqual(FollowerMontageInstance->GetPosition(), LeaderPosition))
+		{
+			FollowerMontageInstance->SetPosition(LeaderPosition);
+		}
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::UpdateReplicatedMontageGroup(FGameplayAbilityRepAnimMontageForMesh& Entry) const
+{
+	Entry.FollowerReferences.Reset();
+	for (USkeletalMeshComponent* Follower : GetMontageGroupFollowers(Entry.Mesh))
+	{
+		FNinjaRepMeshReference& FollowerReference = Entry.FollowerReferences.AddDefaulted_GetRef();
+		FollowerReference.Mesh = Follower;
+		FollowerReference.RegistryIndex = GetMeshRegistryIndex(Follower);
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::ApplyReplicatedMontageGroup(const FGameplayAbilityRepAnimMontageForMesh& Entry)
+{
+	TArray<USkeletalMeshComponent*> Followers;
+	Followers.Reserve(Entry.FollowerReferences.Num());
+	
+	for (const FNinjaRepMeshReference& FollowerReference : Entry.FollowerReferences)
+	{
+		USkeletalMeshComponent* Follower = FollowerReference.RegistryIndex != 0 ? GetRegisteredMesh(FollowerReference.RegistryIndex) : FollowerReference.Mesh.Get();
+		if (IsValid(Follower))
+		{
+			Followers.Add(Follower);
+		}
+	}
+
+	SetMontageGroup(Entry.Mesh, Followers);
+}
+
 void UNinjaGASAbilitySystemComponent::CurrentMontageStopForMesh(USkeletalMeshComponent* InMesh, const float OverrideBlendOutTime)
 {
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
-	const UAnimMontage* MontageToStop = AnimMontageInfo.LocalMontageInfo.AnimMontage;
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(InMesh);
+	const FGameplayAbilityLocalAnimMontageForMesh* AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	const UAnimMontage* MontageToStop = AnimMontageInfo ? AnimMontageInfo->LocalMontageInfo.AnimMontage : nullptr;
 	const bool bShouldStopMontage = AnimInstance && MontageToStop && !AnimInstance->Montage_GetIsStopped(MontageToStop);
 
 	if (bShouldStopMontage)
@@ -140,23 +381,34 @@ void UNinjaGASAbilitySystemComponent::CurrentMontageStopForMesh(USkeletalMeshCom
 		const float BlendOutTime = (OverrideBlendOutTime >= 0.0f ? OverrideBlendOutTime : MontageToStop->BlendOut.GetBlendTime());
 
 		AnimInstance->Montage_Stop(BlendOutTime, MontageToStop);
+		StopMontageOnGroupFollowers(InMesh, MontageToStop, BlendOutTime);
 		MarkMontageReplicationDirtyForMesh(InMesh);
 	}	
 }
 
 void UNinjaGASAbilitySystemComponent::StopAllCurrentMontages(const float OverrideBlendOutTime)
 {
+	// Meshes are copied, since stopping montages may add slots for group followers.
+	TArray<USkeletalMeshComponent*, TInlineAllocator<4>> Meshes;
 	for (const FGameplayAbilityLocalAnimMontageForMesh& GameplayAbilityLocalAnimMontageForMesh : LocalAnimMontageInfoForMeshes)
 	{
-		CurrentMontageStopForMesh(GameplayAbilityLocalAnimMontageForMesh.Mesh, OverrideBlendOutTime);
+		if (IsValid(GameplayAbilityLocalAnimMontageForMesh.Mesh))
+		{
+			Meshes.Add(GameplayAbilityLocalAnimMontageForMesh.Mesh);
+		}
+	}
+
+	for (USkeletalMeshComponent* Mesh : Meshes)
+	{
+		CurrentMontageStopForMesh(Mesh, OverrideBlendOutTime);
 	}	
 }
 
 void UNinjaGASAbilitySystemComponent::StopMontageIfCurrentForMesh(USkeletalMeshComponent* InMesh,
 	const UAnimMontage& Montage, const float OverrideBlendOutTime)
 {
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
-	if (&Montage == AnimMontageInfo.LocalMontageInfo.AnimMontage)
+	const FGameplayAbilityLocalAnimMontageForMesh* AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	if (AnimMontageInfo && &Montage == AnimMontageInfo->LocalMontageInfo.AnimMontage)
 	{
 		CurrentMontageStopForMesh(InMesh, OverrideBlendOutTime);
 	}	
@@ -182,11 +434,12 @@ void UNinjaGASAbilitySystemComponent::ClearAnimatingAbilityForAllMeshes(UGamepla
 
 void UNinjaGASAbilitySystemComponent::CurrentMontageJumpToSectionForMesh(USkeletalMeshComponent* InMesh, const FName SectionName)
 {
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
-	if ((SectionName != NAME_None) && AnimInstance && AnimMontageInfo.LocalMontageInfo.AnimMontage)
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(InMesh);
+	const FGameplayAbilityLocalAnimMontageForMesh* AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	if ((SectionName != NAME_None) && AnimInstance && AnimMontageInfo && AnimMontageInfo->LocalMontageInfo.AnimMontage)
 	{
-		AnimInstance->Montage_JumpToSection(SectionName, AnimMontageInfo.LocalMontageInfo.AnimMontage);
+		AnimInstance->Montage_JumpToSection(SectionName, AnimMontageInfo->LocalMontageInfo.AnimMontage);
+		SyncMontageGroupFollowers(InMesh);
 		
 		if (IsOwnerActorAuthoritative())
 		{
@@ -194,19 +447,23 @@ void UNinjaGASAbilitySystemComponent::CurrentMontageJumpToSectionForMesh(USkelet
 		}
 		else
 		{
-			ServerCurrentMontageJumpToSectionNameForMesh(InMesh, AnimMontageInfo.LocalMontageInfo.AnimMontage, SectionName);
+			FNinjaMontageCommand Command;
+			Command.Type = ENinjaMontageCommandType::JumpToSection;
+			Command.SectionName = SectionName;
+			QueueMontageCommand(InMesh, AnimMontageInfo.LocalMontageInfo.AnimMontage, Command);
 		}
 	}	
 }
 
 void UNinjaGASAbilitySystemComponent::CurrentMontageSetNextSectionNameForMesh(USkeletalMeshComponent* InMesh, const FName FromSectionName, const FName ToSectionName)
 {
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
-	if (AnimMontageInfo.LocalMontageInfo.AnimMontage && AnimInstance)
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(InMesh);
+	const FGameplayAbilityLocalAnimMontageForMesh* AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	if (AnimMontageInfo && AnimMontageInfo->LocalMontageInfo.AnimMontage && AnimInstance)
 	{
 		// Set Next Section Name. 
-		AnimInstance->Montage_SetNextSection(FromSectionName, ToSectionName, AnimMontageInfo.LocalMontageInfo.AnimMontage);
+		AnimInstance->Montage_SetNextSection(FromSectionName, ToSectionName, AnimMontageInfo->LocalMontageInfo.AnimMontage);
+		SyncMontageGroupFollowers(InMesh);
 
 		// Update replicated version for Simulated Proxies if we are on the server.
 		if (IsOwnerActorAuthoritative())
@@ -215,20 +472,25 @@ void UNinjaGASAbilitySystemComponent::CurrentMontageSetNextSectionNameForMesh(US
 		}
 		else
 		{
-			const float CurrentPosition = AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-			ServerCurrentMontageSetNextSectionNameForMesh(InMesh, AnimMontageInfo.LocalMontageInfo.AnimMontage, CurrentPosition, FromSectionName, ToSectionName);
+			FNinjaMontageCommand Command;
+			Command.Type = ENinjaMontageCommandType::SetNextSection;
+			Command.SectionName = FromSectionName;
+			Command.NextSectionName = ToSectionName;
+			Command.Position = AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+			QueueMontageCommand(InMesh, AnimMontageInfo.LocalMontageInfo.AnimMontage, Command);
 		}
 	}	
 }
 
 void UNinjaGASAbilitySystemComponent::CurrentMontageSetPlayRateForMesh(USkeletalMeshComponent* InMesh, float InPlayRate)
 {
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
-	if (AnimMontageInfo.LocalMontageInfo.AnimMontage && AnimInstance)
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(InMesh);
+	const FGameplayAbilityLocalAnimMontageForMesh* AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	if (AnimMontageInfo && AnimMontageInfo->LocalMontageInfo.AnimMontage && AnimInstance)
 	{
 		// Set Play Rate
-		AnimInstance->Montage_SetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage, InPlayRate);
+		AnimInstance->Montage_SetPlayRate(AnimMontageInfo->LocalMontageInfo.AnimMontage, InPlayRate);
+		SyncMontageGroupFollowers(InMesh);
 
 		// Update replicated version for Simulated Proxies if we are on the server.
 		if (IsOwnerActorAuthoritative())
@@ -237,14 +499,17 @@ void UNinjaGASAbilitySystemComponent::CurrentMontageSetPlayRateForMesh(USkeletal
 		}
 		else
 		{
-			ServerCurrentMontageSetPlayRateForMesh(InMesh, AnimMontageInfo.LocalMontageInfo.AnimMontage, InPlayRate);
+			FNinjaMontageCommand Command;
+			Command.Type = ENinjaMontageCommandType::SetPlayRate;
+			Command.PlayRate = InPlayRate;
+			QueueMontageCommand(InMesh, AnimMontageInfo.LocalMontageInfo.AnimMontage, Command);
 		}
 	}	
 }
 
 bool UNinjaGASAbilitySystemComponent::IsAnimatingAbilityForAnyMesh(const UGameplayAbility* Ability) const
 {
-	for (FGameplayAbilityLocalAnimMontageForMesh GameplayAbilityLocalAnimMontageForMesh : LocalAnimMontageInfoForMeshes)
+	for (const FGameplayAbilityLocalAnimMontageForMesh& GameplayAbilityLocalAnimMontageForMesh : LocalAnimMontageInfoForMeshes)
 	{
 		if (GameplayAbilityLocalAnimMontageForMesh.LocalMontageInfo.AnimatingAbility == Ability)
 		{
@@ -271,18 +536,17 @@ UGameplayAbility* UNinjaGASAbilitySystemComponent::GetAnimatingAbilityFromAnyMes
 
 UGameplayAbility* UNinjaGASAbilitySystemComponent::GetAnimatingAbilityFromMesh(USkeletalMeshComponent* InMesh)
 {
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
-	return AnimMontageInfo.LocalMontageInfo.AnimatingAbility.IsValid() ? AnimMontageInfo.LocalMontageInfo.AnimatingAbility.Get() : nullptr;	
+	const FGameplayAbilityLocalAnimMontageForMesh* AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	return AnimMontageInfo && AnimMontageInfo->LocalMontageInfo.AnimatingAbility.IsValid() ? AnimMontageInfo->LocalMontageInfo.AnimatingAbility.Get() : nullptr;	
 }
 
 TArray<UAnimMontage*> UNinjaGASAbilitySystemComponent::GetCurrentMontages() const
 {
 	TArray<UAnimMontage*> Montages;
 
-	for (FGameplayAbilityLocalAnimMontageForMesh GameplayAbilityLocalAnimMontageForMesh : LocalAnimMontageInfoForMeshes)
+	for (const FGameplayAbilityLocalAnimMontageForMesh& GameplayAbilityLocalAnimMontageForMesh : LocalAnimMontageInfoForMeshes)
 	{
-		const UAnimInstance* AnimInstance = IsValid(GameplayAbilityLocalAnimMontageForMesh.Mesh) 
-			&& GameplayAbilityLocalAnimMontageForMesh.Mesh->GetOwner() == AbilityActorInfo->AvatarActor ? GameplayAbilityLocalAnimMontageForMesh.Mesh->GetAnimInstance() : nullptr;
+		const UAnimInstance* AnimInstance = GetAnimInstanceForSlot(GameplayAbilityLocalAnimMontageForMesh);
 
 		if (GameplayAbilityLocalAnimMontageForMesh.LocalMontageInfo.AnimMontage && AnimInstance 
 			&& AnimInstance->Montage_IsActive(GameplayAbilityLocalAnimMontageForMesh.LocalMontageInfo.AnimMontage))
@@ -296,13 +560,19 @@ TArray<UAnimMontage*> UNinjaGASAbilitySystemComponent::GetCurrentMontages() cons
 
 UAnimMontage* UNinjaGASAbilitySystemComponent::GetCurrentMontageForMesh(USkeletalMeshComponent* InMesh)
 {
-	const UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	UAnimInstance* AnimInstance;
+	return GetActiveMontageForMesh(InMesh, AnimInstance);
+}
+
+UAnimMontage* UNinjaGASAbilitySystemComponent::GetActiveMontageForMesh(USkeletalMeshComponent* InMesh, UAnimInstance*& OutAnimInstance)
+{
+	const FGameplayAbilityLocalAnimMontageForMesh* AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	OutAnimInstance = AnimMontageInfo ? GetAnimInstanceForSlot(*AnimMontageInfo) : nullptr;
 
-	if (AnimMontageInfo.LocalMontageInfo.AnimMontage && AnimInstance
-		&& AnimInstance->Montage_IsActive(AnimMontageInfo.LocalMontageInfo.AnimMontage))
+	if (OutAnimInstance && AnimMontageInfo->LocalMontageInfo.AnimMontage
+		&& OutAnimInstance->Montage_IsActive(AnimMontageInfo->LocalMontageInfo.AnimMontage))
 	{
-		return AnimMontageInfo.LocalMontageInfo.AnimMontage;
+		return AnimMontageInfo->LocalMontageInfo.AnimMontage;
 	}
 
 	return nullptr;	
@@ -310,8 +580,8 @@ UAnimMontage* UNinjaGASAbilitySystemComponent::GetCurrentMontageForMesh(USkeleta
 
 int32 UNinjaGASAbilitySystemComponent::GetCurrentMontageSectionIDForMesh(USkeletalMeshComponent* InMesh)
 {
-	const UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	const UAnimMontage* CurrentAnimMontage = GetCurrentMontageForMesh(InMesh);
+	UAnimInstance* AnimInstance;
+	const UAnimMontage* CurrentAnimMontage = GetActiveMontageForMesh(InMesh, AnimInstance);
 
 	if (CurrentAnimMontage && AnimInstance)
 	{
@@ -324,8 +594,8 @@ int32 UNinjaGASAbilitySystemComponent::GetCurrentMontageSectionIDForMesh(USkelet
 
 FName UNinjaGASAbilitySystemComponent::GetCurrentMontageSectionNameForMesh(USkeletalMeshComponent* InMesh)
 {
-	const UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	const UAnimMontage* CurrentAnimMontage = GetCurrentMontageForMesh(InMesh);
+	UAnimInstance* AnimInstance;
+	const UAnimMontage* CurrentAnimMontage = GetActiveMontageForMesh(InMesh, AnimInstance);
 
 	if (CurrentAnimMontage && AnimInstance)
 	{
@@ -340,12 +610,12 @@ FName UNinjaGASAbilitySystemComponent::GetCurrentMontageSectionNameForMesh(USkel
 
 float UNinjaGASAbilitySystemComponent::GetCurrentMontageSectionLengthForMesh(USkeletalMeshComponent* InMesh)
 {
-	const UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	UAnimMontage* CurrentAnimMontage = GetCurrentMontageForMesh(InMesh);
+	UAnimInstance* AnimInstance;
+	UAnimMontage* CurrentAnimMontage = GetActiveMontageForMesh(InMesh, AnimInstance);
 
 	if (CurrentAnimMontage && AnimInstance)
 	{
-		const int32 CurrentSectionID = GetCurrentMontageSectionIDForMesh(InMesh);
+		const int32 CurrentSectionID = CurrentAnimMontage->GetSectionIndexFromPosition(AnimInstance->Montage_GetPosition(CurrentAnimMontage));
 		if (CurrentSectionID != INDEX_NONE)
 		{
 			TArray<FCompositeSection>& CompositeSections = CurrentAnimMontage->CompositeSections;
@@ -371,10 +641,10 @@ float UNinjaGASAbilitySystemComponent::GetCurrentMontageSectionLengthForMesh(USk
 
 float UNinjaGASAbilitySystemComponent::GetCurrentMontageSectionTimeLeftForMesh(USkeletalMeshComponent* InMesh)
 {
-	const UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	UAnimMontage* CurrentAnimMontage = GetCurrentMontageForMesh(InMesh);
+	UAnimInstance* AnimInstance;
+	const UAnimMontage* CurrentAnimMontage = GetActiveMontageForMesh(InMesh, AnimInstance);
 
-	if (CurrentAnimMontage && AnimInstance && AnimInstance->Montage_IsActive(CurrentAnimMontage))
+	if (CurrentAnimMontage && AnimInstance)
 	{
 		const float CurrentPosition = AnimInstance->Montage_GetPosition(CurrentAnimMontage);
 		return CurrentAnimMontage->GetSectionTimeLeftFromPos(CurrentPosition);
@@ -390,23 +660,21 @@ void UNinjaGASAbilitySystemComponent::SynchronizeRepAnimMontageInfo(const FGamep
 
 void UNinjaGASAbilitySystemComponent::PostAnimationEntryChange(FGameplayAbilityRepAnimMontageForMesh& Entry)
 {
-	FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(Entry.Mesh);
-
-	const UWorld* World = GetWorld();
 	if (Entry.RepMontageInfo.bSkipPlayRate)
 	{
 		Entry.RepMontageInfo.PlayRate = 1.f;
 	}
 
-	const bool bIsPlayingReplay = World && World->IsPlayingReplay();
-	const float MONTAGE_REP_POS_ERR_THRESH = bIsPlayingReplay ? CVarReplayMontageErrorThreshold.GetValueOnGameThread() : 0.1f;
-
-	UAnimInstance* AnimInstance = IsValid(Entry.Mesh) && Entry.Mesh->GetOwner() == AbilityActorInfo->AvatarActor ? Entry.Mesh->GetAnimInstance() : nullptr;
+	// Meshes may not be resolved yet, or be gone, so the entry is applied once they are available.
+	FGameplayAbilityLocalAnimMontageForMesh* LocalMontageInfoForMesh = GetLocalAnimMontageInfoForMesh(Entry.Mesh);
+	UAnimInstance* AnimInstance = LocalMontageInfoForMesh ? GetAnimInstanceForSlot(*LocalMontageInfoForMesh) : nullptr;
 	if (AnimInstance == nullptr || !IsReadyForReplicatedMontageForMesh())
 	{
 		bPendingMontageRep = true;
 		return;
 	}
+
+	FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = *LocalMontageInfoForMesh;
 	
 	bPendingMontageRep = false;
 	if (!AbilityActorInfo->IsLocallyControlled())
@@ -432,6 +700,7 @@ void UNinjaGASAbilitySystemComponent::PostAnimationEntryChange(FGameplayAbilityR
 			const bool bIsNewInstance = AnimMontageInfo.LocalMontageInfo.AnimMontage != Entry.RepMontageInfo.Animation || !Entry.IsSynchronized();
 			if (bIsNewInstance)
 			{
+				ApplyReplicatedMontageGroup(Entry);
 				PlayMontageSimulatedForMesh(Entry.Mesh, Entry.RepMontageInfo.GetAnimMontage(), Entry.RepMontageInfo.PlayRate,
 					Entry.RepMontageInfo.bOverrideBlendIn, Entry.RepMontageInfo.BlendInOverride);
 			}
@@ -443,7 +712,8 @@ void UNinjaGASAbilitySystemComponent::PostAnimationEntryChange(FGameplayAbilityR
 			}
 
 			// Play Rate has changed.
-			if (AnimInstance->Montage_GetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage) != Entry.RepMontageInfo.PlayRate)
+			const bool bPlayRateChanged = AnimInstance->Montage_GetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage) != Entry.RepMontageInfo.PlayRate;
+			if (bPlayRateChanged)
 			{
 				AnimInstance->Montage_SetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage, Entry.RepMontageInfo.PlayRate);
 			}
@@ -486,245 +756,1168 @@ void UNinjaGASAbilitySystemComponent::PostAnimationEntryChange(FGameplayAbilityR
 					}
 				}
 
-				// Update Position. If error is too great, jump to replicated position.
-				const float CurrentPosition = AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-				const int32 CurrentSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(CurrentPosition);
-				const float DeltaPosition = Entry.RepMontageInfo.Position - CurrentPosition;
-
-				// Only check threshold if we are located in the same section. Different sections require a bit more work as we could be jumping around the timeline.
-				// And therefore DeltaPosition is not as trivial to determine.
-				if ((CurrentSectionID == RepSectionID) && (FMath::Abs(DeltaPosition) > MONTAGE_REP_POS_ERR_THRESH) && (Entry.RepMontageInfo.IsStopped == 0))
+				// Throttled meshes may not be evaluated this frame, so fast-forwarding them is deferred and merged.
+				const bool bStrictThreshold = bIsNewInstance || bPlayRateChanged;
+				if (!Entry.RepMontageInfo.bReducedFidelity && ShouldDeferMontageCorrectionForMesh(Entry.Mesh))
 				{
-					// fast-forward to server position and trigger notifies
-					if (FAnimMontageInstance* MontageInstance = AnimInstance->GetActiveInstanceForMontage(Entry.RepMontageInfo.GetAnimMontage()))
-					{
-						// Skip triggering notifies if we're going backwards in time, we've already triggered them.
-						const float DeltaTime = !FMath::IsNearlyZero(Entry.RepMontageInfo.PlayRate) ? (DeltaPosition / Entry.RepMontageInfo.PlayRate) : 0.f;
-						if (DeltaTime >= 0.f)
-						{
-							MontageInstance->UpdateWeight(DeltaTime);
-							MontageInstance->HandleEvents(CurrentPosition, Entry.RepMontageInfo.Position, nullptr);
-							AnimInstance->TriggerAnimNotifies(DeltaTime);
-						}
-					}
-					AnimInstance->Montage_SetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage, Entry.RepMontageInfo.Position);
+					DeferMontageCorrectionForMesh(Entry.Mesh, bStrictThreshold);
+				}
+				else
+				{
+					CorrectReplicatedMontagePositionForMesh(Entry, AnimInstance, bStrictThreshold);
 				}
 			}
+
+			// Followers are corrected along with the leader, instead of replicating their own state.
+			SyncMontageGroupFollowers(Entry.Mesh);
 		}
 	}
 }
 
-FGameplayAbilityLocalAnimMontageForMesh& UNinjaGASAbilitySystemComponent::GetLocalAnimMontageInfoForMesh(USkeletalMeshComponent* InMesh)
+void UNinjaGASAbilitySystemComponent::CorrectReplicatedMontagePositionForMesh(const FGameplayAbilityRepAnimMontageForMesh& Entry, UAnimInstance* AnimInstance, const bool bStrictThreshold)
 {
-	for (FGameplayAbilityLocalAnimMontageForMesh& MontageInfo : LocalAnimMontageInfoForMeshes)
+	// Entries with reduced fidelity keep sections in sync, but their positions are not accurate enough to correct.
+	UAnimMontage* AnimMontage = Entry.RepMontageInfo.GetAnimMontage();
+	if (!IsValid(AnimMontage) || Entry.RepMontageInfo.IsStopped || Entry.RepMontageInfo.SkipPositionCorrection || Entry.RepMontageInfo.bReducedFidelity)
 	{
-		if (MontageInfo.Mesh == InMesh)
-		{
-			return MontageInfo;
-		}
+		return;
 	}
 
-	const FGameplayAbilityLocalAnimMontageForMesh MontageInfo = FGameplayAbilityLocalAnimMontageForMesh(InMesh);
-	LocalAnimMontageInfoForMeshes.Add(MontageInfo);
-	return LocalAnimMontageInfoForMeshes.Last();	
-}
-
-void UNinjaGASAbilitySystemComponent::MarkMontageReplicationDirtyForMesh(USkeletalMeshComponent* InMesh)
-{
-	if (!IsOwnerActorAuthoritative() || !IsValid(InMesh))
+	FAnimMontageInstance* MontageInstance = AnimInstance->GetActiveInstanceForMontage(AnimMontage);
+	if (MontageInstance == nullptr)
 	{
 		return;
 	}
+	
+	const UWorld* World = GetWorld();
+	const bool bIsPlayingReplay = World && World->IsPlayingReplay();
+	const float MONTAGE_REP_POS_ERR_THRESH = bIsPlayingReplay ? CVarReplayMontageErrorThreshold.GetValueOnGameThread() : 0.1f;
+	const int32 RepSectionID = AnimMontage->GetSectionIndexFromPosition(Entry.RepMontageInfo.Position);
 
-	FGameplayAbilityRepAnimMontageForMesh& RepEntry = RepAnimMontageInfoForMeshes.GetGameplayAbilityRepAnimMontageForMesh(InMesh);
+	// Timestamped positions are extrapolated, so latency is not mistaken for an error. Since they are
+	// accurate, they are only corrected when the play rate changes or the error is large.
+	const bool bExtrapolate = !bIsPlayingReplay && Entry.RepMontageInfo.bHasServerTimestamp && CVarMontageExtrapolation.GetValueOnGameThread();
+	const float ExpectedPosition = bExtrapolate
+		? GetExtrapolatedMontagePosition(Entry.RepMontageInfo, AnimMontage, RepSectionID)
+		: Entry.RepMontageInfo.Position;
 
-	AnimMontage_UpdateReplicatedDataForMesh(RepEntry);
-	RepAnimMontageInfoForMeshes.MarkMontageDirty(RepEntry);
+	float PositionErrorThreshold = bExtrapolate && !bStrictThreshold
+		? FMath::Max(CVarMontageExtrapolatedErrorThreshold.GetValueOnGameThread(), MONTAGE_REP_POS_ERR_THRESH)
+		: MONTAGE_REP_POS_ERR_THRESH;
 
-	if (AbilityActorInfo->AvatarActor != nullptr)
+	// Meshes updated at a lower rate drift further between updates, and cannot show small corrections anyway.
+	PositionErrorThreshold *= GetMontageCorrectionThresholdScale(Entry.Mesh);
+	
+	// Update Position. If error is too great, jump to replicated position.
+	const float CurrentPosition = AnimInstance->Montage_GetPosition(AnimMontage);
+	const int32 CurrentSectionID = AnimMontage->GetSectionIndexFromPosition(CurrentPosition);
+	const float DeltaPosition = ExpectedPosition - CurrentPosition;
+
+	// Only check threshold if we are located in the same section. Different sections require a bit more work as we could be jumping around the timeline.
+	// And therefore DeltaPosition is not as trivial to determine.
+	if ((CurrentSectionID == RepSectionID) && (FMath::Abs(DeltaPosition) > PositionErrorThreshold))
 	{
-		AbilityActorInfo->AvatarActor->ForceNetUpdate();
+		INC_DWORD_STAT(STAT_NinjaGAS_MontagePositionCorrections);
+		
+		// fast-forward to server position and trigger notifies
+		// Skip triggering notifies if we're going backwards in time, we've already triggered them.
+		const float DeltaTime = !FMath::IsNearlyZero(Entry.RepMontageInfo.PlayRate) ? (DeltaPosition / Entry.RepMontageInfo.PlayRate) : 0.f;
+		if (DeltaTime >= 0.f)
+		{
+			MontageInstance->UpdateWeight(DeltaTime);
+			MontageInstance->HandleEvents(CurrentPosition, ExpectedPosition, nullptr);
+			AnimInstance->TriggerAnimNotifies(DeltaTime);
+		}
+		
+		AnimInstance->Montage_SetPosition(AnimMontage, ExpectedPosition);
 	}
 }
 
-void UNinjaGASAbilitySystemComponent::OnPredictiveMontageRejectedForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* PredictiveMontage)
+bool UNinjaGASAbilitySystemComponent::ShouldDeferMontageCorrectionForMesh(const USkeletalMeshComponent* InMesh) const
 {
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	if (AnimInstance && PredictiveMontage && AnimInstance->Montage_IsPlaying(PredictiveMontage))
+	if (!IsValid(InMesh) || !CVarMontageBudgetAwareCorrections.GetValueOnGameThread())
 	{
-		static constexpr float MONTAGE_PREDICTION_REJECT_FADE_TIME = 0.25f;
-		AnimInstance->Montage_Stop(MONTAGE_PREDICTION_REJECT_FADE_TIME, PredictiveMontage);
-	}	
+		return false;
+	}
+
+	// Meshes only ticking their pose when rendered are not evaluated until they are visible again.
+	if (InMesh->VisibilityBasedAnimTickOption == EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered && !InMesh->WasRecentlyRendered())
+	{
+		return true;
+	}
+
+	// Update rate optimizations, also driven by the Animation Budget Allocator, skip updates for throttled meshes.
+	const FAnimUpdateRateParameters* UpdateRateParams = InMesh->AnimUpdateRateParams;
+	return InMesh->ShouldUseUpdateRateOptimizations() && UpdateRateParams && UpdateRateParams->ShouldSkipUpdate();
 }
 
-void UNinjaGASAbilitySystemComponent::AnimMontage_UpdateReplicatedDataForMesh(USkeletalMeshComponent* InMesh)
+float UNinjaGASAbilitySystemComponent::GetMontageCorrectionThresholdScale(const USkeletalMeshComponent* InMesh) const
 {
-	check(IsOwnerActorAuthoritative());
-	AnimMontage_UpdateReplicatedDataForMesh(RepAnimMontageInfoForMeshes.GetGameplayAbilityRepAnimMontageForMesh(InMesh));
+	if (!IsValid(InMesh) || !InMesh->ShouldUseUpdateRateOptimizations() || !CVarMontageBudgetAwareCorrections.GetValueOnGameThread())
+	{
+		return 1.f;
+	}
+
+	const FAnimUpdateRateParameters* UpdateRateParams = InMesh->AnimUpdateRateParams;
+	return UpdateRateParams ? static_cast<float>(FMath::Max(UpdateRateParams->UpdateRate, 1)) : 1.f;
 }
 
-void UNinjaGASAbilitySystemComponent::AnimMontage_UpdateReplicatedDataForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo)
+void UNinjaGASAbilitySystemComponent::DeferMontageCorrectionForMesh(USkeletalMeshComponent* InMesh, const bool bStrictThreshold)
 {
-	const UAnimInstance* AnimInstance = IsValid(OutRepAnimMontageInfo.Mesh) && OutRepAnimMontageInfo.Mesh->GetOwner() == AbilityActorInfo->AvatarActor ? OutRepAnimMontageInfo.Mesh->GetAnimInstance() : nullptr;
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(OutRepAnimMontageInfo.Mesh);
+	FDeferredMontageCorrection& Correction = DeferredMontageCorrections.FindOrAdd(InMesh);
+	Correction.bStrictThreshold |= bStrictThreshold;
 
-	if (AnimInstance && AnimMontageInfo.LocalMontageInfo.AnimMontage)
+	if (Correction.EvaluatedHandle.IsValid())
 	{
-		OutRepAnimMontageInfo.RepMontageInfo.Animation = AnimMontageInfo.LocalMontageInfo.AnimMontage;
+		INC_DWORD_STAT(STAT_NinjaGAS_MontageCorrectionsMerged);
+		return;
+	}
 
-		// Compressed Flags
-		const bool bIsStopped = AnimInstance->Montage_GetIsStopped(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-		if (!bIsStopped)
-		{
-			OutRepAnimMontageInfo.RepMontageInfo.PlayRate = AnimInstance->Montage_GetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-			OutRepAnimMontageInfo.RepMontageInfo.Position = AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-			OutRepAnimMontageInfo.RepMontageInfo.BlendTime = AnimInstance->Montage_GetBlendTime(AnimMontageInfo.LocalMontageInfo.AnimMontage);
-		}
+	Correction.Mesh = InMesh;
+	Correction.EvaluatedHandle = InMesh->RegisterOnBoneTransformsFinalizedDelegate(
+		FOnBoneTransformsFinalizedMultiCast::FDelegate::CreateUObject(this, &ThisClass::ApplyDeferredMontageCorrection, Correction.Mesh));
+	
+	INC_DWORD_STAT(STAT_NinjaGAS_MontageCorrectionsDeferred);
+}
 
-		if (OutRepAnimMontageInfo.RepMontageInfo.IsStopped != bIsStopped)
-		{
-			// Set this prior to calling UpdateShouldTick, so we start ticking if we are playing a Montage
-			OutRepAnimMontageInfo.RepMontageInfo.IsStopped = bIsStopped;
+void UNinjaGASAbilitySystemComponent::ApplyDeferredMontageCorrection(const TWeakObjectPtr<USkeletalMeshComponent> WeakMesh)
+{
+	USkeletalMeshComponent* Mesh = WeakMesh.Get();
+	FDeferredMontageCorrection Correction;
+	if (!IsValid(Mesh) || !DeferredMontageCorrections.RemoveAndCopyValue(Mesh, Correction))
+	{
+		return;
+	}
 
-			// When we start or stop an animation, update the clients right away for the Avatar Actor
-			if (AbilityActorInfo->AvatarActor != nullptr)
-			{
-				AbilityActorInfo->AvatarActor->ForceNetUpdate();
-			}
+	Mesh->UnregisterOnBoneTransformsFinalizedDelegate(Correction.EvaluatedHandle);
 
-			// When this changes, we should update whether we should be ticking or not.
-			UpdateShouldTick();
-		}
+	// Uses the latest replicated data, which may have changed since the correction was deferred.
+	const FGameplayAbilityRepAnimMontageForMesh* Entry = RepAnimMontageInfoForMeshes.FindGameplayAbilityRepAnimMontageForMesh(Mesh);
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(Mesh);
+	if (Entry && AnimInstance)
+	{
+		CorrectReplicatedMontagePositionForMesh(*Entry, AnimInstance, Correction.bStrictThreshold);
+		SyncMontageGroupFollowers(Mesh);
+	}
+}
 
-		// Replicate NextSectionID to keep it in sync.
-		// We actually replicate NextSectionID+1 on a BYTE to put INDEX_NONE in there.
-		const int32 CurrentSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(OutRepAnimMontageInfo.RepMontageInfo.Position);
-		if (CurrentSectionID != INDEX_NONE)
-		{
-			const int32 NextSectionID = AnimInstance->Montage_GetNextSectionID(AnimMontageInfo.LocalMontageInfo.AnimMontage, CurrentSectionID);
-			if (NextSectionID >= (256 - 1))
-			{
-				ABILITY_LOG(Error, TEXT("AnimMontage_UpdateReplicatedData. NextSectionID = %d.  RepAnimMontageInfo.Position: %.2f, CurrentSectionID: %d. LocalAnimMontageInfo.AnimMontage %s"), NextSectionID, OutRepAnimMontageInfo.RepMontageInfo.Position, CurrentSectionID, *GetNameSafe(AnimMontageInfo.LocalMontageInfo.AnimMontage));
-				ensure(NextSectionID < (256 - 1));
-			}
-			OutRepAnimMontageInfo.RepMontageInfo.NextSectionID = static_cast<uint8>(NextSectionID + 1);
-		}
-		else
+FGameplayAbilityLocalAnimMontageForMesh* UNinjaGASAbilitySystemComponent::GetLocalAnimMontageInfoForMesh(USkeletalMeshComponent* InMesh)
+{
+	if (!IsValid(InMesh))
+	{
+		return nullptr;
+	}
+	
+	const int32 SlotIndex = FindLocalAnimMontageSlot(InMesh);
+	if (SlotIndex != INDEX_NONE)
+	{
+		return &LocalAnimMontageInfoForMeshes[SlotIndex];
+	}
+
+	// Slots from destroyed meshes are only reclaimed when the avatar changes, so existing indices stay stable.
+	const int32 NewSlotIndex = LocalAnimMontageInfoForMeshes.Add(FGameplayAbilityLocalAnimMontageForMesh(InMesh));
+	LocalAnimMontageSlotIndices.Add(InMesh, NewSlotIndex);
+	INC_DWORD_STAT(STAT_NinjaGAS_LocalMontageSlots);
+	
+	return &LocalAnimMontageInfoForMeshes[NewSlotIndex];	
+}
+
+int32 UNinjaGASAbilitySystemComponent::FindLocalAnimMontageSlot(const USkeletalMeshComponent* InMesh) const
+{
+	if (const int32* SlotIndex = LocalAnimMontageSlotIndices.Find(InMesh))
+	{
+		if (LocalAnimMontageInfoForMeshes.IsValidIndex(*SlotIndex) && LocalAnimMontageInfoForMeshes[*SlotIndex].Mesh == InMesh)
 		{
-			OutRepAnimMontageInfo.RepMontageInfo.NextSectionID = 0;
+			return *SlotIndex;
 		}
-	}	
+	}
+	else
+	{
+		// Slots are indexed when added and only move when pruned, so this mesh is not in use.
+		return INDEX_NONE;
+	}
+
+	RebuildLocalAnimMontageSlotIndices();
+	
+	const int32* SlotIndex = LocalAnimMontageSlotIndices.Find(InMesh);
+	return SlotIndex ? *SlotIndex : INDEX_NONE;
 }
 
-void UNinjaGASAbilitySystemComponent::AnimMontage_UpdateForcedPlayFlagsForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo)
+void UNinjaGASAbilitySystemComponent::RebuildLocalAnimMontageSlotIndices() const
 {
-	FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(OutRepAnimMontageInfo.Mesh);	
+	LocalAnimMontageSlotIndices.Reset();
+	for (int32 Idx = 0; Idx < LocalAnimMontageInfoForMeshes.Num(); ++Idx)
+	{
+		LocalAnimMontageSlotIndices.Add(LocalAnimMontageInfoForMeshes[Idx].Mesh, Idx);
+	}
 }
 
-bool UNinjaGASAbilitySystemComponent::IsReadyForReplicatedMontageForMesh()
+int32 UNinjaGASAbilitySystemComponent::PruneLocalAnimMontageSlots()
 {
-	/** Children may want to override this for additional checks (e.g, "has skin been applied") */
-	return true;	
+	const int32 RemovedCount = LocalAnimMontageInfoForMeshes.RemoveAll([](const FGameplayAbilityLocalAnimMontageForMesh& MontageInfo)
+	{
+		return !IsValid(MontageInfo.Mesh);
+	});
+
+	if (RemovedCount > 0)
+	{
+		RebuildLocalAnimMontageSlotIndices();
+		DEC_DWORD_STAT_BY(STAT_NinjaGAS_LocalMontageSlots, RemovedCount);
+		INC_DWORD_STAT_BY(STAT_NinjaGAS_MontageSlotsPruned, RemovedCount);
+	}
+
+	return RemovedCount;
 }
 
-void UNinjaGASAbilitySystemComponent::ServerCurrentMontageSetNextSectionNameForMesh_Implementation(
-	USkeletalMeshComponent* InMesh, UAnimMontage* ClientAnimMontage, const float ClientPosition, const FName SectionName,
-	const FName NextSectionName)
+void UNinjaGASAbilitySystemComponent::PruneMontageSlots()
 {
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	PruneLocalAnimMontageSlots();
+	
+	for (const FGameplayAbilityLocalAnimMontageForMesh& MontageInfo : LocalAnimMontageInfoForMeshes)
+	{
+		MontageInfo.CachedAnimInstance.Reset();
+	}
 
-	if (AnimInstance)
+	// Delegates for deferred corrections are gone along with their meshes.
+	for (auto It(DeferredMontageCorrections.CreateIterator()); It; ++It)
 	{
-		const UAnimMontage* CurrentAnimMontage = AnimMontageInfo.LocalMontageInfo.AnimMontage;
-		if (ClientAnimMontage == CurrentAnimMontage)
+		if (!It.Value().Mesh.IsValid())
 		{
-			// Set NextSectionName
-			AnimInstance->Montage_SetNextSection(SectionName, NextSectionName, CurrentAnimMontage);
+			It.RemoveCurrent();
+		}
+	}
 
-			// Correct position if we are in an invalid section
-			const float CurrentPosition = AnimInstance->Montage_GetPosition(CurrentAnimMontage);
-			const int32 CurrentSectionID = CurrentAnimMontage->GetSectionIndexFromPosition(CurrentPosition);
-			const FName CurrentSectionName = CurrentAnimMontage->GetSectionName(CurrentSectionID);
+	if (IsOwnerActorAuthoritative())
+	{
+		const int32 RemovedCount = RepAnimMontageInfoForMeshes.RemoveInvalidMeshes();
+		INC_DWORD_STAT_BY(STAT_NinjaGAS_MontageSlotsPruned, RemovedCount);
+	}
+}
 
-			const int32 ClientSectionID = CurrentAnimMontage->GetSectionIndexFromPosition(ClientPosition);
-			const FName ClientCurrentSectionName = CurrentAnimMontage->GetSectionName(ClientSectionID);
-			if ((CurrentSectionName != ClientCurrentSectionName) || (CurrentSectionName != SectionName))
+UAnimInstance* UNinjaGASAbilitySystemComponent::GetAnimInstanceForMesh(const USkeletalMeshComponent* InMesh) const
+{
+	const int32 SlotIndex = FindLocalAnimMontageSlot(InMesh);
+	if (SlotIndex != INDEX_NONE)
+	{
+		return GetAnimInstanceForSlot(LocalAnimMontageInfoForMeshes[SlotIndex]);
+	}
+
+	return ResolveAnimInstanceForMesh(InMesh);
+}
+
+UAnimInstance* UNinjaGASAbilitySystemComponent::GetAnimInstanceForSlot(const FGameplayAbilityLocalAnimMontageForMesh& Slot) const
+{
+	// Anim Instances are recreated when the Anim Class changes, invalidating the cached one.
+	UAnimInstance* AnimInstance = Slot.CachedAnimInstance.Get();
+	if (!IsValid(AnimInstance))
+	{
+		AnimInstance = ResolveAnimInstanceForMesh(Slot.Mesh);
+		Slot.CachedAnimInstance = AnimInstance;
+	}
+
+	return AnimInstance;
+}
+
+UAnimInstance* UNinjaGASAbilitySystemComponent::ResolveAnimInstanceForMesh(const USkeletalMeshComponent* InMesh) const
+{
+	if (!IsValid(InMesh) || !AbilityActorInfo.IsValid() || InMesh->GetOwner() != AbilityActorInfo->AvatarActor)
+	{
+		return nullptr;
+	}
+
+	return InMesh->GetAnimInstance();
+}
+
+void UNinjaGASAbilitySystemComponent::MarkMontageReplicationDirtyForMesh(USkeletalMeshComponent* InMesh, const bool bIsNewInstance)
+{
+	if (!IsOwnerActorAuthoritative() || !IsValid(InMesh))
+	{
+		return;
+	}
+
+	if (UNinjaGASMontageReplicationSubsystem* Scheduler = GetMontageReplicationScheduler())
+	{
+		FPendingMontageReplication* PendingReplication = PendingMontageReplications.FindByPredicate([InMesh](const FPendingMontageReplication& Pending)
+		{
+			return Pending.Mesh == InMesh;
+		});
+
+		if (PendingReplication)
+		{
+			// New instances must keep their blend settings, even if other changes follow.
+			PendingReplication->bIsNewInstance |= bIsNewInstance;
+			INC_DWORD_STAT(STAT_NinjaGAS_MontageDirtyMarksCoalesced);
+		}
+		else
+		{
+			PendingMontageReplications.Add({ InMesh, bIsNewInstance });
+		}
+
+		++PendingMontageNetUpdateRequests;
+		Scheduler->QueueFlush(this);
+		return;
+	}
+
+	UpdateMontageReplicationForMesh(InMesh, bIsNewInstance);
+	RequestMontageNetUpdate();
+}
+
+void UNinjaGASAbilitySystemComponent::UpdateMontageReplicationForMesh(USkeletalMeshComponent* InMesh, const bool bIsNewInstance)
+{
+	FGameplayAbilityRepAnimMontageForMesh& RepEntry = RepAnimMontageInfoForMeshes.GetGameplayAbilityRepAnimMontageForMesh(InMesh);
+	if (bIsNewInstance)
+	{
+		UpdateReplicatedMontageGroup(RepEntry);
+	}
+
+	AnimMontage_UpdateReplicatedDataForMesh(RepEntry);
+	RepAnimMontageInfoForMeshes.MarkMontageDirty(RepEntry);
+}
+
+void UNinjaGASAbilitySystemComponent::RequestMontageNetUpdate()
+{
+	if (bFlushingMontageReplication)
+	{
+		// Collected by the flush, which forces a single update.
+		++PendingMontageNetUpdateRequests;
+		return;
+	}
+
+	if (UNinjaGASMontageReplicationSubsystem* Scheduler = GetMontageReplicationScheduler())
+	{
+		++PendingMontageNetUpdateRequests;
+		Scheduler->QueueFlush(this);
+		return;
+	}
+
+	if (AbilityActorInfo.IsValid() && AbilityActorInfo->AvatarActor != nullptr)
+	{
+		AbilityActorInfo->AvatarActor->ForceNetUpdate();
+	}
+}
+
+int32 UNinjaGASAbilitySystemComponent::FlushMontageReplication()
+{
+	TGuardValue<bool> FlushingGuard(bFlushingMontageReplication, true);
+	SendMontageCommands();
+
+	if (IsOwnerActorAuthoritative())
+	{
+		ApplyThrottledMontageCommands();
+	}
+	
+	TArray<FPendingMontageReplication> PendingReplications = MoveTemp(PendingMontageReplications);
+	PendingMontageReplications.Reset();
+
+	for (const FPendingMontageReplication& PendingReplication : PendingReplications)
+	{
+		USkeletalMeshComponent* Mesh = PendingReplication.Mesh.Get();
+		if (IsValid(Mesh) && IsOwnerActorAuthoritative())
+		{
+			UpdateMontageReplicationForMesh(Mesh, PendingReplication.bIsNewInstance);
+		}
+	}
+
+	const int32 RequestCount = PendingMontageNetUpdateRequests;
+	PendingMontageNetUpdateRequests = 0;
+	return RequestCount;
+}
+
+UNinjaGASMontageReplicationSubsystem* UNinjaGASAbilitySystemComponent::GetMontageReplicationScheduler() const
+{
+	if (bFlushingMontageReplication || !UNinjaGASMontageReplicationSubsystem::IsCoalescingEnabled())
+	{
+		return nullptr;
+	}
+
+	const UWorld* World = GetWorld();
+	return IsValid(World) ? World->GetSubsystem<UNinjaGASMontageReplicationSubsystem>() : nullptr;
+}
+
+void UNinjaGASAbilitySystemComponent::OnPredictiveMontageRejectedForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* PredictiveMontage)
+{
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(InMesh);
+	if (AnimInstance && PredictiveMontage && AnimInstance->Montage_IsPlaying(PredictiveMontage))
+	{
+		static constexpr float MONTAGE_PREDICTION_REJECT_FADE_TIME = 0.25f;
+		AnimInstance->Montage_Stop(MONTAGE_PREDICTION_REJECT_FADE_TIME, PredictiveMontage);
+		StopMontageOnGroupFollowers(InMesh, PredictiveMontage, MONTAGE_PREDICTION_REJECT_FADE_TIME);
+	}	
+}
+
+void UNinjaGASAbilitySystemComponent::AnimMontage_UpdateReplicatedDataForMesh(USkeletalMeshComponent* InMesh)
+{
+	check(IsOwnerActorAuthoritative());
+	AnimMontage_UpdateReplicatedDataForMesh(RepAnimMontageInfoForMeshes.GetGameplayAbilityRepAnimMontageForMesh(InMesh));
+}
+
+void UNinjaGASAbilitySystemComponent::AnimMontage_UpdateReplicatedDataForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo)
+{
+	const FGameplayAbilityLocalAnimMontageForMesh* LocalMontageInfoForMesh = GetLocalAnimMontageInfoForMesh(OutRepAnimMontageInfo.Mesh);
+	if (LocalMontageInfoForMesh == nullptr)
+	{
+		return;
+	}
+	
+	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = *LocalMontageInfoForMesh;
+	const UAnimInstance* AnimInstance = GetAnimInstanceForSlot(AnimMontageInfo);
+
+	if (AnimInstance && AnimMontageInfo.LocalMontageInfo.AnimMontage)
+	{
+		OutRepAnimMontageInfo.RepMontageInfo.Animation = AnimMontageInfo.LocalMontageInfo.AnimMontage;
+		OutRepAnimMontageInfo.RepMontageInfo.MontageRegistryIndex = GetMontageRegistryIndex(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+
+		// Compressed Flags
+		const bool bIsStopped = AnimInstance->Montage_GetIsStopped(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+		if (!bIsStopped)
+		{
+			OutRepAnimMontageInfo.RepMontageInfo.PlayRate = AnimInstance->Montage_GetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+			OutRepAnimMontageInfo.RepMontageInfo.Position = AnimInstance->Montage_GetPosition(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+			OutRepAnimMontageInfo.RepMontageInfo.BlendTime = AnimInstance->Montage_GetBlendTime(AnimMontageInfo.LocalMontageInfo.AnimMontage);
+			OutRepAnimMontageInfo.RepMontageInfo.ServerTimestamp = GetCompactServerTime();
+			OutRepAnimMontageInfo.RepMontageInfo.bHasServerTimestamp = CVarMontageExtrapolation.GetValueOnGameThread();
+		}
+
+		if (OutRepAnimMontageInfo.RepMontageInfo.IsStopped != bIsStopped)
+		{
+			// Set this prior to calling UpdateShouldTick, so we start ticking if we are playing a Montage
+			OutRepAnimMontageInfo.RepMontageInfo.IsStopped = bIsStopped;
+
+			// When we start or stop an animation, update the clients right away for the Avatar Actor
+			RequestMontageNetUpdate();
+
+			// When this changes, we should update whether we should be ticking or not.
+			UpdateShouldTick();
+			UpdateMontageReplicationTimer();
+		}
+
+		// Replicate NextSectionID to keep it in sync.
+		// We actually replicate NextSectionID+1 on a BYTE to put INDEX_NONE in there.
+		const int32 CurrentSectionID = AnimMontageInfo.LocalMontageInfo.AnimMontage->GetSectionIndexFromPosition(OutRepAnimMontageInfo.RepMontageInfo.Position);
+		if (CurrentSectionID != INDEX_NONE)
+		{
+			const int32 NextSectionID = AnimInstance->Montage_GetNextSectionID(AnimMontageInfo.LocalMontageInfo.AnimMontage, CurrentSectionID);
+			if (NextSectionID >= (256 - 1))
 			{
-				// We are in an invalid section, jump to client's position.
-				AnimInstance->Montage_SetPosition(CurrentAnimMontage, ClientPosition);
+				ABILITY_LOG(Error, TEXT("AnimMontage_UpdateReplicatedData. NextSectionID = %d.  RepAnimMontageInfo.Position: %.2f, CurrentSectionID: %d. LocalAnimMontageInfo.AnimMontage %s"), NextSectionID, OutRepAnimMontageInfo.RepMontageInfo.Position, CurrentSectionID, *GetNameSafe(AnimMontageInfo.LocalMontageInfo.AnimMontage));
+				ensure(NextSectionID < (256 - 1));
 			}
+			OutRepAnimMontageInfo.RepMontageInfo.NextSectionID = static_cast<uint8>(NextSectionID + 1);
+		}
+		else
+		{
+			OutRepAnimMontageInfo.RepMontageInfo.NextSectionID = 0;
+		}
+	}	
+}
 
-			// Update replicated version for Simulated Proxies if we are on the server.
-			if (IsOwnerActorAuthoritative())
+void UNinjaGASAbilitySystemComponent::AnimMontage_UpdateForcedPlayFlagsForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo)
+{
+}
+
+bool UNinjaGASAbilitySystemComponent::HasPlayingReplicatedMontages() const
+{
+	if (!IsOwnerActorAuthoritative())
+	{
+		return false;
+	}
+	
+	// Entries for destroyed meshes are never sampled, so they must not keep the timer alive.
+	return RepAnimMontageInfoForMeshes.Entries.ContainsByPredicate([](const FGameplayAbilityRepAnimMontageForMesh& Entry)
+	{
+		return IsValid(Entry.Mesh) && Entry.RepMontageInfo.IsStopped == false;
+	});
+}
+
+void UNinjaGASAbilitySystemComponent::UpdateMontageReplicationTimer()
+{
+	const UWorld* World = GetWorld();
+	if (!IsValid(World))
+	{
+		return;
+	}
+
+	FTimerManager& TimerManager = World->GetTimerManager();
+	const bool bShouldSample = MontageReplicationUpdateMode == EMontageReplicationUpdateMode::Timer
+		&& MontageReplicationUpdateRate > 0.f && HasPlayingReplicatedMontages();
+
+	if (!bShouldSample)
+	{
+		TimerManager.ClearTimer(MontageReplicationTimerHandle);
+	}
+	else if (!TimerManager.IsTimerActive(MontageReplicationTimerHandle))
+	{
+		static constexpr bool bLoop = true;
+		TimerManager.SetTimer(MontageReplicationTimerHandle, this, &ThisClass::SampleReplicatedMontages, 1.f / MontageReplicationUpdateRate, bLoop);
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::SampleReplicatedMontages()
+{
+	if (!IsOwnerActorAuthoritative())
+	{
+		return;
+	}
+
+	for (FGameplayAbilityRepAnimMontageForMesh& Entry : RepAnimMontageInfoForMeshes.Entries)
+	{
+		// Meshes may have been destroyed with their equipment, and stopped entries have nothing to sample.
+		if (!IsValid(Entry.Mesh) || Entry.RepMontageInfo.IsStopped)
+		{
+			continue;
+		}
+
+		const uint8 PreviousNextSectionID = Entry.RepMontageInfo.NextSectionID;
+		AnimMontage_UpdateReplicatedDataForMesh(Entry);
+
+		// Sections reached naturally and montages ending on their own are sent as events.
+		if (Entry.RepMontageInfo.IsStopped || Entry.RepMontageInfo.NextSectionID != PreviousNextSectionID)
+		{
+			RepAnimMontageInfoForMeshes.MarkMontageDirty(Entry);
+		}
+	}
+
+	UpdateMontageReplicationTimer();
+}
+
+EMontageReplicationLOD UNinjaGASAbilitySystemComponent::GetMontageReplicationLOD(const UNetConnection* Connection) const
+{
+	// Replays and connections without a view target keep full fidelity.
+	if (MontageReplicationLODDistance <= 0.f || !IsValid(Connection) || Connection->IsReplay() || !IsValid(Connection->ViewTarget))
+	{
+		return EMontageReplicationLOD::Full;
+	}
+
+	const AActor* AvatarActor = GetAvatarActor_Direct();
+	if (!IsValid(AvatarActor))
+	{
+		return EMontageReplicationLOD::Full;
+	}
+
+	const double DistanceSquared = FVector::DistSquared(AvatarActor->GetActorLocation(), Connection->ViewTarget->GetActorLocation());
+	return DistanceSquared > FMath::Square(MontageReplicationLODDistance) ? EMontageReplicationLOD::Reduced : EMontageReplicationLOD::Full;
+}
+
+bool UNinjaGASAbilitySystemComponent::IsNotifyWindowDrivenForMesh(const USkeletalMeshComponent* InMesh, const UAnimNotifyState* NotifyState)
+{
+	if (!IsValid(InMesh) || !IsValid(NotifyState))
+	{
+		return false;
+	}
+
+	const UNinjaGASAbilitySystemComponent* AbilitySystemComponent = Cast<UNinjaGASAbilitySystemComponent>(UNinjaGASFunctionLibrary::PeekAbilitySystemComponentFromActor(InMesh->GetOwner()));
+	if (!IsValid(AbilitySystemComponent))
+	{
+		return false;
+	}
+
+	return AbilitySystemComponent->DrivenNotifyWindows.ContainsByPredicate([InMesh, NotifyState](const FDrivenMontageNotifyWindows& Driven)
+	{
+		return Driven.Mesh == InMesh && Driven.Windows.ContainsByPredicate([NotifyState](const FMontageNotifyWindow& Window)
+		{
+			return Window.NotifyState == NotifyState;
+		});
+	});
+}
+
+bool UNinjaGASAbilitySystemComponent::ShouldDriveNotifyWindows() const
+{
+	return bDriveNotifyWindowsFromMontageTime && IsOwnerActorAuthoritative();
+}
+
+void UNinjaGASAbilitySystemComponent::ExtractNotifyWindows(const UAnimMontage* Montage, TArray<FMontageNotifyWindow>& OutWindows)
+{
+	if (!IsValid(Montage))
+	{
+		return;
+	}
+
+	auto AddWindow = [&OutWindows](const FAnimNotifyEvent& NotifyEvent, const UAnimSequenceBase* Animation, const float StartTime, const float EndTime)
+	{
+		if (IsValid(NotifyEvent.NotifyStateClass) && NotifyEvent.NotifyStateClass->Implements<UAbilityNotifyWindowInterface>())
+		{
+			FMontageNotifyWindow& Window = OutWindows.AddDefaulted_GetRef();
+			Window.NotifyState = NotifyEvent.NotifyStateClass;
+			Window.Animation = const_cast<UAnimSequenceBase*>(Animation);
+			Window.StartTime = StartTime;
+			Window.EndTime = EndTime;
+		}
+	};
+
+	for (const FAnimNotifyEvent& NotifyEvent : Montage->Notifies)
+	{
+		AddWindow(NotifyEvent, Montage, NotifyEvent.GetTriggerTime(), NotifyEvent.GetEndTriggerTime());
+	}
+
+	for (const FSlotAnimationTrack& SlotTrack : Montage->SlotAnimTracks)
+	{
+		for (const FAnimSegment& Segment : SlotTrack.AnimTrack.AnimSegments)
+		{
+			// Segments playing backwards are not mapped, since their windows would be reversed.
+			const UAnimSequenceBase* SegmentAnimation = Segment.GetAnimReference();
+			if (!IsValid(SegmentAnimation) || Segment.AnimPlayRate <= 0.f)
 			{
-				MarkMontageReplicationDirtyForMesh(InMesh);
+				continue;
+			}
+
+			const float LoopLength = (Segment.AnimEndTime - Segment.AnimStartTime) / Segment.AnimPlayRate;
+			for (int32 LoopIndex = 0; LoopIndex < FMath::Max(Segment.LoopingCount, 1); ++LoopIndex)
+			{
+				const float LoopStartTime = Segment.StartPos + LoopIndex * LoopLength;
+				for (const FAnimNotifyEvent& NotifyEvent : SegmentAnimation->Notifies)
+				{
+					const float StartTime = FMath::Max(NotifyEvent.GetTriggerTime(), Segment.AnimStartTime);
+					const float EndTime = FMath::Min(NotifyEvent.GetEndTriggerTime(), Segment.AnimEndTime);
+					if (StartTime <= EndTime)
+					{
+						AddWindow(NotifyEvent, SegmentAnimation,
+							LoopStartTime + (StartTime - Segment.AnimStartTime) / Segment.AnimPlayRate,
+							LoopStartTime + (EndTime - Segment.AnimStartTime) / Segment.AnimPlayRate);
+					}
+				}
 			}
 		}
-	}	
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::StartNotifyWindowsForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* Montage)
+{
+	// Only one montage is tracked per mesh, so windows from the previous one end now.
+	const int32 ExistingIndex = DrivenNotifyWindows.IndexOfByPredicate([InMesh](const FDrivenMontageNotifyWindows& Driven)
+	{
+		return Driven.Mesh == InMesh;
+	});
+
+	if (ExistingIndex != INDEX_NONE)
+	{
+		FDrivenMontageNotifyWindows Existing = MoveTemp(DrivenNotifyWindows[ExistingIndex]);
+		DrivenNotifyWindows.RemoveAtSwap(ExistingIndex);
+		EndDrivenNotifyWindows(Existing);
+	}
+
+	FDrivenMontageNotifyWindows Driven;
+	ExtractNotifyWindows(Montage, Driven.Windows);
+	if (Driven.Windows.IsEmpty())
+	{
+		return;
+	}
+
+	const UAnimInstance* AnimInstance = GetAnimInstanceForMesh(InMesh);
+	Driven.Mesh = InMesh;
+	Driven.Montage = Montage;
+	Driven.Position = AnimInstance ? AnimInstance->Montage_GetPosition(Montage) : 0.f;
+	Driven.ObservedPosition = Driven.Position;
+	Driven.UpdateTime = GetWorld()->GetTimeSeconds();
+
+	// Windows at the start position begin right away, as they would on the first animation update.
+	// They may start another montage on the mesh, which then replaces this one.
+	const bool bIsPlaying = UpdateDrivenNotifyWindows(Driven, Driven.UpdateTime);
+	const bool bWasReplaced = DrivenNotifyWindows.ContainsByPredicate([InMesh](const FDrivenMontageNotifyWindows& Other)
+	{
+		return Other.Mesh == InMesh;
+	});
+
+	if (!bIsPlaying || bWasReplaced)
+	{
+		EndDrivenNotifyWindows(Driven);
+		return;
+	}
+
+	DrivenNotifyWindows.Add(MoveTemp(Driven));
+
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	if (!TimerManager.IsTimerActive(NotifyWindowTimerHandle))
+	{
+		static constexpr bool bLoop = true;
+		TimerManager.SetTimer(NotifyWindowTimerHandle, this, &ThisClass::UpdateNotifyWindows, 1.f / FMath::Max(NotifyWindowUpdateRate, 1.f), bLoop);
+	}
 }
 
-bool UNinjaGASAbilitySystemComponent::ServerCurrentMontageSetNextSectionNameForMesh_Validate(
-	USkeletalMeshComponent* InMesh, UAnimMontage* ClientAnimMontage, float ClientPosition, FName SectionName,
-	FName NextSectionName)
+bool UNinjaGASAbilitySystemComponent::UpdateDrivenNotifyWindows(FDrivenMontageNotifyWindows& Driven, const double CurrentTime)
 {
-	return true;
+	USkeletalMeshComponent* Mesh = Driven.Mesh.Get();
+	const UAnimMontage* Montage = Driven.Montage.Get();
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(Mesh);
+	
+	const FAnimMontageInstance* MontageInstance = AnimInstance && Montage ? AnimInstance->GetActiveInstanceForMontage(Montage) : nullptr;
+	if (MontageInstance == nullptr || MontageInstance->IsStopped())
+	{
+		return false;
+	}
+
+	// Montages advanced by their meshes report their own position. Otherwise, it is extrapolated from the play rate.
+	const float PreviousPosition = Driven.Position;
+	const float ObservedPosition = MontageInstance->GetPosition();
+	if (ObservedPosition != Driven.ObservedPosition)
+	{
+		Driven.Position = ObservedPosition;
+	}
+	else if (MontageInstance->IsPlaying())
+	{
+		Driven.Position += static_cast<float>(CurrentTime - Driven.UpdateTime) * MontageInstance->GetPlayRate();
+	}
+
+	Driven.ObservedPosition = ObservedPosition;
+	Driven.UpdateTime = CurrentTime;
+
+	for (FMontageNotifyWindow& Window : Driven.Windows)
+	{
+		IAbilityNotifyWindowInterface* NotifyWindow = Cast<IAbilityNotifyWindowInterface>(Window.NotifyState.Get());
+		if (NotifyWindow == nullptr)
+		{
+			continue;
+		}
+
+		// Windows shorter than an update still begin and end, as they would with animation events.
+		const bool bShouldBeActive = Driven.Position >= Window.StartTime && Driven.Position < Window.EndTime;
+		const bool bSkippedOver = PreviousPosition < Window.StartTime && Driven.Position >= Window.EndTime;
+
+		if (!Window.bActive && (bShouldBeActive || bSkippedOver))
+		{
+			Window.bActive = true;
+			NotifyWindow->BeginNotifyWindow(Mesh, Window.Animation.Get());
+			INC_DWORD_STAT(STAT_NinjaGAS_NotifyWindowsDriven);
+		}
+
+		if (Window.bActive && !bShouldBeActive)
+		{
+			Window.bActive = false;
+			NotifyWindow->EndNotifyWindow(Mesh, Window.Animation.Get());
+		}
+	}
+
+	// Montages that are not advanced by their meshes never end on their own.
+	return Driven.Position < Montage->GetPlayLength();
+}
+
+void UNinjaGASAbilitySystemComponent::EndDrivenNotifyWindows(FDrivenMontageNotifyWindows& Driven)
+{
+	for (FMontageNotifyWindow& Window : Driven.Windows)
+	{
+		IAbilityNotifyWindowInterface* NotifyWindow = Cast<IAbilityNotifyWindowInterface>(Window.NotifyState.Get());
+		if (Window.bActive && NotifyWindow)
+		{
+			NotifyWindow->EndNotifyWindow(Driven.Mesh.Get(), Window.Animation.Get());
+		}
+
+		Window.bActive = false;
+	}
 }
 
-void UNinjaGASAbilitySystemComponent::ServerCurrentMontageJumpToSectionNameForMesh_Implementation(
-	USkeletalMeshComponent* InMesh, UAnimMontage* ClientAnimMontage, FName SectionName)
+void UNinjaGASAbilitySystemComponent::UpdateNotifyWindows()
 {
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	SCOPE_CYCLE_COUNTER(STAT_NinjaGAS_UpdateNotifyWindows);
+	
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+
+	// Windows may start other montages, so entries are updated outside of the array.
+	TArray<FDrivenMontageNotifyWindows> UpdatingWindows = MoveTemp(DrivenNotifyWindows);
+	DrivenNotifyWindows.Reset();
 
-	if (AnimInstance)
+	for (FDrivenMontageNotifyWindows& Driven : UpdatingWindows)
 	{
-		const UAnimMontage* CurrentAnimMontage = AnimMontageInfo.LocalMontageInfo.AnimMontage;
-		if (ClientAnimMontage == CurrentAnimMontage)
+		const bool bIsPlaying = UpdateDrivenNotifyWindows(Driven, CurrentTime);
+		const bool bWasReplaced = DrivenNotifyWindows.ContainsByPredicate([&Driven](const FDrivenMontageNotifyWindows& Other)
 		{
-			// Set NextSectionName
-			AnimInstance->Montage_JumpToSection(SectionName, CurrentAnimMontage);
+			return Other.Mesh == Driven.Mesh;
+		});
 
-			// Update replicated version for Simulated Proxies if we are on the server.
-			if (IsOwnerActorAuthoritative())
+		if (!bIsPlaying || bWasReplaced)
+		{
+			EndDrivenNotifyWindows(Driven);
+			continue;
+		}
+
+		DrivenNotifyWindows.Add(MoveTemp(Driven));
+	}
+
+	if (DrivenNotifyWindows.IsEmpty())
+	{
+		GetWorld()->GetTimerManager().ClearTimer(NotifyWindowTimerHandle);
+	}
+}
+
+uint16 UNinjaGASAbilitySystemComponent::GetCompactServerTime() const
+{
+	const UWorld* World = GetWorld();
+	if (!IsValid(World))
+	{
+		return 0;
+	}
+
+	// Clients approximate the server time from the Game State, which accounts for latency.
+	const AGameStateBase* GameState = World->GetGameState();
+	const double ServerTime = IsValid(GameState) ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+	return static_cast<uint16>(FMath::FloorToInt64(ServerTime * 1000.) & MAX_uint16);
+}
+
+float UNinjaGASAbilitySystemComponent::GetExtrapolatedMontagePosition(const FPlayTagGameplayAbilityRepAnimMontage& RepMontageInfo, const UAnimMontage* AnimMontage, const int32 RepSectionID) const
+{
+	if (!IsValid(AnimMontage) || !AnimMontage->IsValidSectionIndex(RepSectionID))
+	{
+		return RepMontageInfo.Position;
+	}
+
+	// Wrapped subtraction gives the elapsed time, and negative values when the local estimate is behind.
+	const int32 ElapsedMilliseconds = FMath::Max<int32>(static_cast<int16>(GetCompactServerTime() - RepMontageInfo.ServerTimestamp), 0);
+	const float MaxElapsedSeconds = FMath::Max(CVarMontageMaxExtrapolationSeconds.GetValueOnGameThread(), 0.f);
+	const float ElapsedSeconds = FMath::Min(ElapsedMilliseconds / 1000.f, MaxElapsedSeconds);
+
+	const float SectionStartTime = AnimMontage->GetAnimCompositeSection(RepSectionID).GetTime();
+	const float SectionEndTime = SectionStartTime + AnimMontage->GetSectionLength(RepSectionID);
+	return FMath::Clamp(RepMontageInfo.Position + ElapsedSeconds * RepMontageInfo.PlayRate, SectionStartTime, SectionEndTime);
+}
+
+void UNinjaGASAbilitySystemComponent::RebuildMontageRegistry()
+{
+	RegisteredMontages.Reset();
+	MontageRegistryIndices.Reset();
+	RegisteredMeshes.Reset();
+	MeshRegistryIndices.Reset();
+	
+	if (!bUseMontageRegistry)
+	{
+		return;
+	}
+
+	// Same sources used for defaults: the owner, or this component, followed by the avatar.
+	const AActor* OwnerActor = GetOwnerActor();
+	const AActor* AvatarActor = GetAvatarActor();
+	
+	const IAbilitySystemDefaultsInterface* OwnerDefaults = Cast<IAbilitySystemDefaultsInterface>(OwnerActor);
+	if (!OwnerDefaults || !OwnerDefaults->HasAbilityData())
+	{
+		OwnerDefaults = this;
+	}
+
+	const IAbilitySystemDefaultsInterface* AvatarDefaults = AvatarActor != OwnerActor ? Cast<IAbilitySystemDefaultsInterface>(AvatarActor) : nullptr;
+	for (const IAbilitySystemDefaultsInterface* Defaults : { OwnerDefaults, AvatarDefaults })
+	{
+		const UNinjaGASDataAsset* AbilityData = Defaults ? Defaults->GetAbilityData() : nullptr;
+		if (!IsValid(AbilityData) && Defaults)
+		{
+			// Data provided asynchronously is only available once its soft reference is loaded.
+			AbilityData = Defaults->GetSoftAbilityData().Get();
+		}
+
+		if (IsValid(AbilityData))
+		{
+			RegisteredMontages.Append(AbilityData->ReplicatedMontages);
+		}
+	}
+
+	if (RegisteredMontages.Num() >= UINT16_MAX)
+	{
+		UE_LOG(LogAbilitySystemComponent, Warning, TEXT("[%s] %d montages registered, only the first %d are replicated by index."),
+			*GetNameSafe(AvatarActor), RegisteredMontages.Num(), UINT16_MAX - 1);
+	}
+
+	// Montages registered more than once keep their first index.
+	const int32 MontageCount = FMath::Min(RegisteredMontages.Num(), UINT16_MAX - 1);
+	MontageRegistryIndices.Reserve(MontageCount);
+	for (int32 Idx = 0; Idx < MontageCount; ++Idx)
+	{
+		const UAnimMontage* Montage = RegisteredMontages[Idx];
+		if (Montage && !MontageRegistryIndices.Contains(Montage))
+		{
+			MontageRegistryIndices.Add(Montage, static_cast<uint16>(Idx + 1));
+		}
+	}
+
+	// Only the first mesh with each tag is registered, and meshes with many tags keep their first index.
+	if (IsValid(AvatarActor) && !MontageRegistryMeshTags.IsEmpty())
+	{
+		TInlineComponentArray<USkeletalMeshComponent*> Meshes(AvatarActor);
+		const int32 TagCount = FMath::Min(MontageRegistryMeshTags.Num(), static_cast<int32>(UINT8_MAX));
+		RegisteredMeshes.Reserve(TagCount);
+		
+		for (int32 Idx = 0; Idx < TagCount; ++Idx)
+		{
+			const FName& MeshTag = MontageRegistryMeshTags[Idx];
+			USkeletalMeshComponent* const* Mesh = Meshes.FindByPredicate([&MeshTag](const USkeletalMeshComponent* Candidate)
+			{
+				return Candidate->ComponentHasTag(MeshTag);
+			});
+
+			USkeletalMeshComponent* RegisteredMesh = Mesh ? *Mesh : nullptr;
+			RegisteredMeshes.Add(RegisteredMesh);
+			
+			if (RegisteredMesh && !MeshRegistryIndices.Contains(RegisteredMesh))
 			{
-				MarkMontageReplicationDirtyForMesh(InMesh);
+				MeshRegistryIndices.Add(RegisteredMesh, static_cast<uint8>(Idx + 1));
 			}
 		}
-	}	
+	}
+
+	if (IsOwnerActorAuthoritative())
+	{
+		return;
+	}
+
+	// Entries received before their data was loaded can be resolved now.
+	bool bResolvedEntries = false;
+	for (FGameplayAbilityRepAnimMontageForMesh& Entry : RepAnimMontageInfoForMeshes.Entries)
+	{
+		const bool bMissingMontage = Entry.RepMontageInfo.MontageRegistryIndex != 0 && Entry.RepMontageInfo.Animation == nullptr;
+		const bool bMissingMesh = Entry.MeshReference.RegistryIndex != 0 && Entry.Mesh == nullptr;
+		if (bMissingMontage || bMissingMesh)
+		{
+			ResolveMontageRegistryReferences(Entry);
+			bResolvedEntries = true;
+		}
+	}
+
+	if (bResolvedEntries)
+	{
+		RepAnimMontageInfoForMeshes.InvalidateEntryIndices();
+		for (FGameplayAbilityRepAnimMontageForMesh& Entry : RepAnimMontageInfoForMeshes.Entries)
+		{
+			if (IsValid(Entry.Mesh) && Entry.RepMontageInfo.Animation != nullptr)
+			{
+				PostAnimationEntryChange(Entry);
+			}
+		}
+	}
+}
+
+void UNinjaGASAbilitySystemComponent::ResolveMontageRegistryReferences(FGameplayAbilityRepAnimMontageForMesh& Entry) const
+{
+	Entry.Mesh = Entry.MeshReference.RegistryIndex != 0 ? GetRegisteredMesh(Entry.MeshReference.RegistryIndex) : Entry.MeshReference.Mesh.Get();
+	
+	if (Entry.RepMontageInfo.MontageRegistryIndex != 0)
+	{
+		Entry.RepMontageInfo.Animation = GetRegisteredMontage(Entry.RepMontageInfo.MontageRegistryIndex);
+	}
+}
+
+uint16 UNinjaGASAbilitySystemComponent::GetMontageRegistryIndex(const UAnimSequenceBase* Animation) const
+{
+	if (!bUseMontageRegistry || Animation == nullptr)
+	{
+		return 0;
+	}
+
+	const uint16* RegistryIndex = MontageRegistryIndices.Find(Animation);
+	return RegistryIndex ? *RegistryIndex : 0;
+}
+
+UAnimMontage* UNinjaGASAbilitySystemComponent::GetRegisteredMontage(const uint16 RegistryIndex) const
+{
+	const int32 Index = static_cast<int32>(RegistryIndex) - 1;
+	return RegisteredMontages.IsValidIndex(Index) ? RegisteredMontages[Index].Get() : nullptr;
+}
+
+uint8 UNinjaGASAbilitySystemComponent::GetMeshRegistryIndex(const USkeletalMeshComponent* InMesh) const
+{
+	if (!bUseMontageRegistry || !IsValid(InMesh))
+	{
+		return 0;
+	}
+
+	const uint8* RegistryIndex = MeshRegistryIndices.Find(InMesh);
+	return RegistryIndex ? *RegistryIndex : 0;
+}
+
+USkeletalMeshComponent* UNinjaGASAbilitySystemComponent::GetRegisteredMesh(const uint8 RegistryIndex) const
+{
+	const int32 Index = static_cast<int32>(RegistryIndex) - 1;
+	return RegisteredMeshes.IsValidIndex(Index) ? RegisteredMeshes[Index].Get() : nullptr;
+}
+
+bool UNinjaGASAbilitySystemComponent::IsReadyForReplicatedMontageForMesh()
+{
+	/** Children may want to override this for additional checks (e.g, "has skin been applied") */
+	return true;	
 }
 
-bool UNinjaGASAbilitySystemComponent::ServerCurrentMontageJumpToSectionNameForMesh_Validate(
-	USkeletalMeshComponent* InMesh, UAnimMontage* ClientAnimMontage, FName SectionName)
+void UNinjaGASAbilitySystemComponent::QueueMontageCommand(USkeletalMeshComponent* InMesh, UAnimMontage* AnimMontage, FNinjaMontageCommand& Command)
 {
-	return true;
+	Command.MeshReference.Mesh = InMesh;
+	Command.MeshReference.RegistryIndex = GetMeshRegistryIndex(InMesh);
+	Command.Montage = AnimMontage;
+	Command.MontageRegistryIndex = GetMontageRegistryIndex(AnimMontage);
+
+	// Commands for the mesh are applied in order, so only the latest one can be replaced.
+	const int32 LastIndex = PendingMontageCommands.FindLastByPredicate([InMesh](const FNinjaMontageCommand& Pending)
+	{
+		return Pending.MeshReference.Mesh == InMesh;
+	});
+
+	if (LastIndex != INDEX_NONE && Command.Supersedes(PendingMontageCommands[LastIndex]))
+	{
+		PendingMontageCommands[LastIndex] = Command;
+		INC_DWORD_STAT(STAT_NinjaGAS_MontageCommandsCoalesced);
+	}
+	else
+	{
+		PendingMontageCommands.Add(Command);
+	}
+
+	if (UNinjaGASMontageReplicationSubsystem* Scheduler = GetMontageReplicationScheduler())
+	{
+		Scheduler->QueueFlush(this);
+		return;
+	}
+
+	SendMontageCommands();
 }
 
-void UNinjaGASAbilitySystemComponent::ServerCurrentMontageSetPlayRateForMesh_Implementation(
-	USkeletalMeshComponent* InMesh, UAnimMontage* ClientAnimMontage, float InPlayRate)
+void UNinjaGASAbilitySystemComponent::SendMontageCommands()
 {
-	UAnimInstance* AnimInstance = IsValid(InMesh) && InMesh->GetOwner() == AbilityActorInfo->AvatarActor ? InMesh->GetAnimInstance() : nullptr;
-	const FGameplayAbilityLocalAnimMontageForMesh& AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	const int32 CommandCount = PendingMontageCommands.Num();
+	if (CommandCount == 0)
+	{
+		return;
+	}
 
-	if (AnimInstance)
+	if (CommandCount <= NinjaGAS::MontageCommands::MaxCommandsPerBatch)
+	{
+		ServerApplyMontageCommands(NextMontageCommandSequence++, PendingMontageCommands);
+		INC_DWORD_STAT(STAT_NinjaGAS_MontageCommandBatchesSent);
+	}
+	else
 	{
-		const UAnimMontage* CurrentAnimMontage = AnimMontageInfo.LocalMontageInfo.AnimMontage;
-		if (ClientAnimMontage == CurrentAnimMontage)
+		// Batches are capped, so valid clients never fail validation.
+		for (int32 StartIndex = 0; StartIndex < CommandCount; StartIndex += NinjaGAS::MontageCommands::MaxCommandsPerBatch)
 		{
-			// Set PlayRate
-			AnimInstance->Montage_SetPlayRate(AnimMontageInfo.LocalMontageInfo.AnimMontage, InPlayRate);
+			const int32 BatchSize = FMath::Min(NinjaGAS::MontageCommands::MaxCommandsPerBatch, CommandCount - StartIndex);
+			const TArray<FNinjaMontageCommand> Batch(PendingMontageCommands.GetData() + StartIndex, BatchSize);
+			ServerApplyMontageCommands(NextMontageCommandSequence++, Batch);
+			INC_DWORD_STAT(STAT_NinjaGAS_MontageCommandBatchesSent);
+		}
+	}
 
-			// Update replicated version for Simulated Proxies if we are on the server.
-			if (IsOwnerActorAuthoritative())
+	INC_DWORD_STAT_BY(STAT_NinjaGAS_MontageCommandsSent, CommandCount);
+	PendingMontageCommands.Reset();
+}
+
+void UNinjaGASAbilitySystemComponent::ApplyMontageCommand(const FNinjaMontageCommand& Command)
+{
+	USkeletalMeshComponent* InMesh = Command.MeshReference.RegistryIndex != 0 ? GetRegisteredMesh(Command.MeshReference.RegistryIndex) : Command.MeshReference.Mesh.Get();
+	const UAnimMontage* ClientAnimMontage = Command.MontageRegistryIndex != 0 ? GetRegisteredMontage(Command.MontageRegistryIndex) : Command.Montage.Get();
+	
+	UAnimInstance* AnimInstance = GetAnimInstanceForMesh(InMesh);
+	if (!AnimInstance || !ClientAnimMontage)
+	{
+		return;
+	}
+
+	const FGameplayAbilityLocalAnimMontageForMesh* AnimMontageInfo = GetLocalAnimMontageInfoForMesh(InMesh);
+	const UAnimMontage* CurrentAnimMontage = AnimMontageInfo ? AnimMontageInfo->LocalMontageInfo.AnimMontage : nullptr;
+	if (ClientAnimMontage != CurrentAnimMontage)
+	{
+		return;
+	}
+
+	switch (Command.Type)
+	{
+		case ENinjaMontageCommandType::JumpToSection:
+		{
+			AnimInstance->Montage_JumpToSection(Command.SectionName, CurrentAnimMontage);
+			break;
+		}
+
+		case ENinjaMontageCommandType::SetNextSection:
+		{
+			AnimInstance->Montage_SetNextSection(Command.SectionName, Command.NextSectionName, CurrentAnimMontage);
+
+			// Correct position if we are in an invalid section
+			const float CurrentPosition = AnimInstance->Montage_GetPosition(CurrentAnimMontage);
+			const int32 CurrentSectionID = CurrentAnimMontage->GetSectionIndexFromPosition(CurrentPosition);
+			const FName CurrentSectionName = CurrentAnimMontage->GetSectionName(CurrentSectionID);
+
+			const int32 ClientSectionID = CurrentAnimMontage->GetSectionIndexFromPosition(Command.Position);
+			const FName ClientCurrentSectionName = CurrentAnimMontage->GetSectionName(ClientSectionID);
+			if ((CurrentSectionName != ClientCurrentSectionName) || (CurrentSectionName != Command.SectionName))
 			{
-				MarkMontageReplicationDirtyForMesh(InMesh);
+				// We are in an invalid section, jump to client's position.
+				AnimInstance->Montage_SetPosition(CurrentAnimMontage, Command.Position);
 			}
+			break;
 		}
-	}	
+
+		case ENinjaMontageCommandType::SetPlayRate:
+		{
+			AnimInstance->Montage_SetPlayRate(CurrentAnimMontage, Command.PlayRate);
+			break;
+		}
+	}
+
+	SyncMontageGroupFollowers(InMesh);
+	
+	// Update replicated version for Simulated Proxies.
+	MarkMontageReplicationDirtyForMesh(InMesh);
+}
+
+void UNinjaGASAbilitySystemComponent::ServerApplyMontageCommands_Implementation(const uint16 Sequence, const TArray<FNinjaMontageCommand>& Commands)
+{
+	// Batches are reliable and ordered, so anything that is not newer is a duplicate.
+	if (bHasReceivedMontageCommands && static_cast<int16>(Sequence - LastMontageCommandSequence) <= 0)
+	{
+		UE_LOG(LogAbilitySystemComponent, Verbose, TEXT("Ignoring montage commands for %s with stale sequence %d, last received was %d."),
+			*GetNameSafe(GetOwner()), Sequence, LastMontageCommandSequence);
+		return;
+	}
+
+	bHasReceivedMontageCommands = true;
+	LastMontageCommandSequence = Sequence;
+
+	// The owner does not receive replicated montages, so commands cannot be dropped without desyncing it.
+	// Everything goes through the throttled queue instead, keeping the order from the client.
+	ThrottledMontageCommands.Append(Commands);
+	ApplyThrottledMontageCommands();
+}
+
+void UNinjaGASAbilitySystemComponent::ApplyThrottledMontageCommands()
+{
+	if (ThrottledMontageCommands.IsEmpty())
+	{
+		return;
+	}
+	
+	int32 AllowedCount = ThrottledMontageCommands.Num();
+	const UWorld* World = GetWorld();
+	UNinjaGASMontageReplicationSubsystem* Subsystem = IsValid(World) ? World->GetSubsystem<UNinjaGASMontageReplicationSubsystem>() : nullptr;
+	if (IsValid(Subsystem))
+	{
+		AllowedCount = Subsystem->ConsumeMontageCommandBudget(GetOwner()->GetNetConnection(), ThrottledMontageCommands.Num());
+	}
+
+	// Swapped out while applying, since applying commands may flush and retry this queue.
+	TArray<FNinjaMontageCommand> Commands = MoveTemp(ThrottledMontageCommands);
+	for (int32 Idx = 0; Idx < AllowedCount; ++Idx)
+	{
+		ApplyMontageCommand(Commands[Idx]);
+	}
+
+	Commands.RemoveAt(0, AllowedCount);
+	Commands.Append(MoveTemp(ThrottledMontageCommands));
+	ThrottledMontageCommands = MoveTemp(Commands);
+
+	if (!ThrottledMontageCommands.IsEmpty() && IsValid(Subsystem))
+	{
+		Subsystem->QueueFlush(this);
+	}
 }
 
-bool UNinjaGASAbilitySystemComponent::ServerCurrentMontageSetPlayRateForMesh_Validate(USkeletalMeshComponent* InMesh,
-	UAnimMontage* ClientAnimMontage, float InPlayRate)
+bool UNinjaGASAbilitySystemComponent::ServerApplyMontageCommands_Validate(const uint16 Sequence, const TArray<FNinjaMontageCommand>& Commands)
 {
-	return true;
-}
\ No newline at end of file
+	if (Commands.Num() > NinjaGAS::MontageCommands::MaxCommandsPerBatch)
+	{
+		return false;
+	}
+
+	// Clients that keep sending over the rate limit would otherwise grow the throttled queue forever.
+	const int32 MaxBacklog = FMath::Max(UNinjaGASMontageReplicationSubsystem::GetMaxMontageCommandBacklog(), NinjaGAS::MontageCommands::MaxCommandsPerBatch);
+	if (ThrottledMontageCommands.Num() + Commands.Num() > MaxBacklog)
+	{
+		UE_LOG(LogAbilitySystemComponent, Warning, TEXT("Rejecting montage commands for %s: %d commands are already waiting for the rate limit."),
+			*GetNameSafe(GetOwner()), ThrottledMontageCommands.Num());
+		return false;
+	}
+
+	return !Commands.ContainsByPredicate([](const FNinjaMontageCommand& Command)
+	{
+		return !FMath::IsFinite(Command.Position) || !FMath::IsFinite(Command.PlayRate);
+	});
+}
@@ -2,8 +2,9 @@
 #include "Animation/States/AnimNotifyState_ApplyGameplayEffect.h"
 
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemGlobals.h"
+#include "NinjaGASFunctionLibrary.h"
 #include "GameplayEffect.h"
+#include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 
 void UAnimNotifyState_ApplyGameplayEffect::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
@@ -11,18 +12,38 @@ void UAnimNotifyState_ApplyGameplayEffect::NotifyBegin(USkeletalMeshComponent* M
 {
 	Super::NotifyBegin(MeshComp, Animation, TotalDuration, EventReference);
 
+	// The Ability System Component may be driving this window from montage time instead.
+	if (!UNinjaGASAbilitySystemComponent::IsNotifyWindowDrivenForMesh(MeshComp, this))
+	{
+		BeginNotifyWindow(MeshComp, Animation);
+	}
+}
+
+void UAnimNotifyState_ApplyGameplayEffect::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
+	const FAnimNotifyEventReference& EventReference)
+{
+	Super::NotifyEnd(MeshComp, Animation, EventReference);
+
+	if (!UNinjaGASAbilitySystemComponent::IsNotifyWindowDrivenForMesh(MeshComp, this))
+	{
+		EndNotifyWindow(MeshComp, Animation);
+	}
+}
+
+void UAnimNotifyState_ApplyGameplayEffect::BeginNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
+{
 	if (!IsValid(MeshComp) || !IsValid(GameplayEffectClass))
 	{
 		return;
 	}
 
-	const AActor* Owner = MeshComp->GetOwner();
+	AActor* Owner = MeshComp->GetOwner();
 	if (!IsValid(Owner))
 	{
 		return;
 	}
 
-	UAbilitySystemComponent* AbilitySystem = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Owner);
+	UAbilitySystemComponent* AbilitySystem = UNinjaGASFunctionLibrary::EnsureAbilitySystemComponentFromActor(Owner);
 	if (!IsValid(AbilitySystem))
 	{
 		return;
@@ -46,10 +67,8 @@ void UAnimNotifyState_ApplyGameplayEffect::NotifyBegin(USkeletalMeshComponent* M
 	}
 }
 
-void UAnimNotifyState_ApplyGameplayEffect::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation,
-	const FAnimNotifyEventReference& EventReference)
+void UAnimNotifyState_ApplyGameplayEffect::EndNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
 {
-	Super::NotifyEnd(MeshComp, Animation, EventReference);
 	RemoveGameplayEffect(MeshComp);
 }
 
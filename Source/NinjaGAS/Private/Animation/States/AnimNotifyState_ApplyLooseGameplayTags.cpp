@@ -2,8 +2,9 @@
 #include "Animation/States/AnimNotifyState_ApplyLooseGameplayTags.h"
 
 #include "AbilitySystemComponent.h"
-#include "AbilitySystemGlobals.h"
+#include "NinjaGASFunctionLibrary.h"
 #include "GameplayTagContainer.h"
+#include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 
 void UAnimNotifyState_ApplyLooseGameplayTags::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, 
@@ -11,6 +12,26 @@ void UAnimNotifyState_ApplyLooseGameplayTags::NotifyBegin(USkeletalMeshComponent
 {
 	Super::NotifyBegin(MeshComp, Animation, TotalDuration, EventReference);
 
+	// The Ability System Component may be driving this window from montage time instead.
+	if (!UNinjaGASAbilitySystemComponent::IsNotifyWindowDrivenForMesh(MeshComp, this))
+	{
+		BeginNotifyWindow(MeshComp, Animation);
+	}
+}
+
+void UAnimNotifyState_ApplyLooseGameplayTags::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, 
+	const FAnimNotifyEventReference& EventReference)
+{
+	Super::NotifyEnd(MeshComp, Animation, EventReference);
+
+	if (!UNinjaGASAbilitySystemComponent::IsNotifyWindowDrivenForMesh(MeshComp, this))
+	{
+		EndNotifyWindow(MeshComp, Animation);
+	}
+}
+
+void UAnimNotifyState_ApplyLooseGameplayTags::BeginNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
+{
 	if (!IsValid(MeshComp) || GameplayTags.IsEmpty())
 	{
 		return;
@@ -22,7 +43,8 @@ void UAnimNotifyState_ApplyLooseGameplayTags::NotifyBegin(USkeletalMeshComponent
 		return;
 	}
 
-	UAbilitySystemComponent* AbilitySystem = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Owner);
+	// Loose tags only matter to components that were initialized already, so lazy components are not created.
+	UAbilitySystemComponent* AbilitySystem = UNinjaGASFunctionLibrary::PeekAbilitySystemComponentFromActor(Owner);
 	if (!IsValid(AbilitySystem))
 	{
 		return;
@@ -34,10 +56,8 @@ void UAnimNotifyState_ApplyLooseGameplayTags::NotifyBegin(USkeletalMeshComponent
 	ActiveGameplayTags.Add(MeshComp, FAppliedLooseGameplayTagsInfo{ AbilitySystem, GameplayTags });
 }
 
-void UAnimNotifyState_ApplyLooseGameplayTags::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, 
-	const FAnimNotifyEventReference& EventReference)
+void UAnimNotifyState_ApplyLooseGameplayTags::EndNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
 {
-	Super::NotifyEnd(MeshComp, Animation, EventReference);
 	RemoveGameplayTags(MeshComp);
 }
 
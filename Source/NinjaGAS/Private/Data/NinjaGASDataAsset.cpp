@@ -4,6 +4,7 @@
 #include "GameplayTagContainer.h"
 
 FPrimaryAssetType UNinjaGASDataAsset::AssetType = TEXT("AbilityBundleData");
+FName UNinjaGASDataAsset::AbilitiesBundle = TEXT("Abilities");
 
 UNinjaGASDataAsset::UNinjaGASDataAsset()
 {
@@ -1,10 +1,12 @@
 ﻿// Ninja Bear Studio Inc. 2024, all rights reserved.
 #include "GameFramework/NinjaGASActor.h"
 
-#include "NinjaGASFunctionLibrary.h"
+#include "NinjaGASComponentPoolSubsystem.h"
+#include "NinjaGASIdleDemotionSubsystem.h"
 #include "NinjaGASLog.h"
 #include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
 #include "Components/GameFrameworkComponentManager.h"
+#include "Engine/World.h"
 #include "Net/UnrealNetwork.h"
 #include "Runtime/Launch/Resources/Version.h"
 
@@ -25,6 +27,10 @@ ANinjaGASActor::ANinjaGASActor(const FObjectInitializer& ObjectInitializer) : Su
 	AbilitySystemInitializationMode = ELazyAbilitySystemInitializationMode::Lazy;
 	AbilityReplicationMode = EGameplayEffectReplicationMode::Minimal;
 	AbilitySystemComponentClass = UNinjaGASAbilitySystemComponent::StaticClass();
+	bUseAbilitySystemComponentPool = false;
+	bDemoteIdleAbilitySystemComponent = false;
+	IdleDemotionDelay = 30.f;
+	bAbilitySystemComponentFromPool = false;
 }
 
 void ANinjaGASActor::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
@@ -86,19 +92,39 @@ void ANinjaGASActor::BeginPlay()
 	// Doing this is useful as it makes this class compatible with both a gameplay feature and the
 	// ASC interface, avoiding the component lookup.
 	//
-	ActorAbilities = UNinjaGASFunctionLibrary::GetCustomAbilitySystemComponentFromActor(this);
+	// Components are looked up directly, so lazy components are not created here.
+	//
+	if (!IsValid(ActorAbilities))
+	{
+		ActorAbilities = FindComponentByClass<UNinjaGASAbilitySystemComponent>();
+	}
+	
 	if (IsValid(ActorAbilities))
 	{
 		GAS_LOG_ARGS(Verbose, "Actor '%s' received a valid ASC (probably from a Game Feature?).", *GetNameSafe(this));
 		ActorAbilities->InitAbilityActorInfo(this, this);
 		ForceNetUpdate();
 	}
+	else if (AbilitySystemInitializationMode == ELazyAbilitySystemInitializationMode::Lazy)
+	{
+		// Moves the construction cost to the first actor using the pool, instead of the first activation.
+		if (UNinjaGASComponentPoolSubsystem* ComponentPool = GetAbilitySystemComponentPool())
+		{
+			ComponentPool->WarmUp(AbilitySystemComponentClass, AbilityReplicationMode);
+		}
+	}
 }
 
 void ANinjaGASActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	UGameFrameworkComponentManager::RemoveGameFrameworkComponentReceiver(this);
 	Super::EndPlay(EndPlayReason);
+
+	// Streamed out actors may come back, so only destroyed actors return their component.
+	if (EndPlayReason == EEndPlayReason::Destroyed && bAbilitySystemComponentFromPool && IsValid(ActorAbilities))
+	{
+		ReleaseAbilitySystemComponent();
+	}
 }
 
 UAbilitySystemComponent* ANinjaGASActor::GetAbilitySystemComponent() const
@@ -118,25 +144,123 @@ UNinjaGASDataAsset* ANinjaGASActor::GetAbilityData() const
 	return DefaultAbilitySetup;
 }
 
+TSoftObjectPtr<UNinjaGASDataAsset> ANinjaGASActor::GetSoftAbilityData() const
+{
+	return SoftAbilitySetup;
+}
+
 ELazyAbilitySystemInitializationMode ANinjaGASActor::GetAbilitySystemInitializationMode() const
 {
 	return AbilitySystemInitializationMode;
 }
 
+UAbilitySystemComponent* ANinjaGASActor::PeekAbilitySystemComponent() const
+{
+	return ActorAbilities;
+}
+
+UAbilitySystemComponent* ANinjaGASActor::EnsureAbilitySystemComponent()
+{
+	return GetAbilitySystemComponent();
+}
+
 void ANinjaGASActor::SetPendingAttributeFromReplication(const FGameplayAttribute& Attribute, const FGameplayAttributeData& NewValue)
 {
-	PendingAttributeReplications.Emplace(FPendingAttributeReplication(Attribute, NewValue));
-	GAS_LOG_ARGS(Verbose, "Added pending attribute '%s' with base/current value: %f/%f.", *Attribute.GetName(), NewValue.GetBaseValue(), NewValue.GetCurrentValue());
+	FPendingAttributeReplication::AddOrReplace(PendingAttributeReplications, Attribute, NewValue);
+	GAS_LOG_ARGS(Verbose, "Set pending attribute '%s' with base/current value: %f/%f.", *Attribute.GetName(), NewValue.GetBaseValue(), NewValue.GetCurrentValue());
 }
 
 void ANinjaGASActor::InitializeAbilitySystemComponent()
 {
-	ActorAbilities = NewObject<UNinjaGASAbilitySystemComponent>(this, AbilitySystemComponentClass);
+	if (UNinjaGASComponentPoolSubsystem* ComponentPool = GetAbilitySystemComponentPool())
+	{
+		ActorAbilities = ComponentPool->Acquire(this, AbilitySystemComponentClass, AbilityReplicationMode);
+		bAbilitySystemComponentFromPool = true;
+	}
+	else
+	{
+		ActorAbilities = NewObject<UNinjaGASAbilitySystemComponent>(this, AbilitySystemComponentClass);
+	}
+	
 	ActorAbilities->SetIsReplicated(true);
 	ActorAbilities->SetReplicationMode(AbilityReplicationMode);
 	ActorAbilities->RegisterComponent();
 	ActorAbilities->InitAbilityActorInfo(this, this);
 	GAS_LOG_ARGS(Log, "Initialized Ability System Component for actor '%s'.", *GetNameSafe(this));
+
+	// Defaults may be granted later, so the baseline and demoted attributes wait for the initialization.
+	if (HasAuthority() && (bDemoteIdleAbilitySystemComponent || !DemotedAttributes.IsEmpty()))
+	{
+		if (ActorAbilities->IsAbilitySystemInitialized())
+		{
+			HandleAbilitySystemInitialized();
+		}
+
+		AbilitySystemInitializedHandle = ActorAbilities->OnInitialized().AddUObject(this, &ThisClass::HandleAbilitySystemInitialized);
+	}
+
+	if (UNinjaGASIdleDemotionSubsystem* Scheduler = GetIdleDemotionScheduler())
+	{
+		Scheduler->Register(this);
+	}
+}
+
+void ANinjaGASActor::HandleAbilitySystemInitialized()
+{
+	// Captured before restoring, so restored attributes are kept again if the component is demoted.
+	ActorAbilities->CaptureIdleBaseline();
+
+	if (DemotedAttributes.Num() > 0)
+	{
+		for (const FPendingAttributeReplication& Demoted : DemotedAttributes)
+		{
+			if (ActorAbilities->IsAttributeAvailable(Demoted.Attribute))
+			{
+				ActorAbilities->SetNumericAttributeBase(Demoted.Attribute, Demoted.NewValue.GetBaseValue());
+			}
+		}
+
+		GAS_LOG_ARGS(Verbose, "Restored %d demoted attributes for actor '%s'.", DemotedAttributes.Num(), *GetNameSafe(this));
+		DemotedAttributes.Empty();
+	}
+}
+
+bool ANinjaGASActor::IsAbilitySystemComponentIdle() const
+{
+	return IsValid(ActorAbilities) && ActorAbilities->IsIdle();
+}
+
+void ANinjaGASActor::DemoteAbilitySystemComponent()
+{
+	check(IsValid(ActorAbilities));
+
+	DemotedAttributes.Reset();
+	ActorAbilities->GetNonBaselineAttributes(DemotedAttributes);
+	ReleaseAbilitySystemComponent();
+	ForceNetUpdate();
+
+	GAS_LOG_ARGS(Log, "Demoted idle Ability System Component for actor '%s', keeping %d attributes.", *GetNameSafe(this), DemotedAttributes.Num());
+}
+
+void ANinjaGASActor::ReleaseAbilitySystemComponent()
+{
+	ActorAbilities->OnInitialized().Remove(AbilitySystemInitializedHandle);
+	AbilitySystemInitializedHandle.Reset();
+
+	UNinjaGASComponentPoolSubsystem* ComponentPool = GetWorld()->GetSubsystem<UNinjaGASComponentPoolSubsystem>();
+	if (bAbilitySystemComponentFromPool && IsValid(ComponentPool))
+	{
+		ComponentPool->Release(ActorAbilities);
+	}
+	else
+	{
+		ActorAbilities->DestroyComponent();
+	}
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ReplicatedActorAbilities, this);
+	ActorAbilities = nullptr;
+	ReplicatedActorAbilities = nullptr;
+	bAbilitySystemComponentFromPool = false;
 }
 
 void ANinjaGASActor::ApplyPendingAttributesFromReplication()
@@ -144,21 +268,48 @@ void ANinjaGASActor::ApplyPendingAttributesFromReplication()
 	checkf(ActorAbilities, TEXT("Attempted to apply pending attributes without an ASC!"));
 	if (PendingAttributeReplications.Num() > 0)
 	{
-		for (const FPendingAttributeReplication& Pending : PendingAttributeReplications) 
-		{
-			ActorAbilities->DeferredSetBaseAttributeValueFromReplication(Pending.Attribute, Pending.NewValue);
-		}
-		
+		ActorAbilities->DeferredSetBaseAttributeValuesFromReplication(PendingAttributeReplications);
 		PendingAttributeReplications.Empty();
 	}
 }
 
 void ANinjaGASActor::OnRep_ReplicatedActorAbilities()
 {
-	ActorAbilities = ReplicatedActorAbilities;
+	// The replicated component is hydrated in place. Begin Play may have found it already.
+	if (ActorAbilities != ReplicatedActorAbilities)
+	{
+		ActorAbilities = ReplicatedActorAbilities;
+		if (ActorAbilities)
+		{
+			ActorAbilities->InitAbilityActorInfo(this, this);
+		}
+	}
+
 	if (ActorAbilities)
 	{
-		InitializeAbilitySystemComponent();
 		ApplyPendingAttributesFromReplication();
 	}
 }
+
+UNinjaGASComponentPoolSubsystem* ANinjaGASActor::GetAbilitySystemComponentPool() const
+{
+	const UWorld* World = GetWorld();
+	if (!bUseAbilitySystemComponentPool || !IsValid(World) || !HasAuthority() || !UNinjaGASComponentPoolSubsystem::IsPoolingEnabled())
+	{
+		return nullptr;
+	}
+
+	return World->GetSubsystem<UNinjaGASComponentPoolSubsystem>();
+}
+
+UNinjaGASIdleDemotionSubsystem* ANinjaGASActor::GetIdleDemotionScheduler() const
+{
+	const UWorld* World = GetWorld();
+	if (!bDemoteIdleAbilitySystemComponent || AbilitySystemInitializationMode != ELazyAbilitySystemInitializationMode::Lazy
+		|| !IsValid(World) || !HasAuthority() || !UNinjaGASIdleDemotionSubsystem::IsDemotionEnabled())
+	{
+		return nullptr;
+	}
+
+	return World->GetSubsystem<UNinjaGASIdleDemotionSubsystem>();
+}
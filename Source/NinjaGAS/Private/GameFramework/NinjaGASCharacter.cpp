@@ -1,11 +1,12 @@
 ﻿// Ninja Bear Studio Inc. 2024, all rights reserved.
 #include "GameFramework/NinjaGASCharacter.h"
 
-#include "NinjaGASFunctionLibrary.h"
+#include "NinjaGASLog.h"
 #include "TimerManager.h"
 #include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
 #include "Components/GameFrameworkComponentManager.h"
 #include "GameFramework/PlayerState.h"
+#include "Net/UnrealNetwork.h"
 #include "Runtime/Launch/Resources/Version.h"
 
 FName ANinjaGASCharacter::AbilitySystemComponentName = TEXT("AbilitySystemComponent");
@@ -26,6 +27,8 @@ ANinjaGASCharacter::ANinjaGASCharacter(const FObjectInitializer& ObjectInitializ
 	
 	AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
 	AbilityReplicationMode = EGameplayEffectReplicationMode::Minimal;
+	AbilitySystemInitializationMode = ELazyAbilitySystemInitializationMode::Eager;
+	AbilitySystemComponentClass = UNinjaGASAbilitySystemComponent::StaticClass();
 
 	CharacterAbilities = CreateOptionalDefaultSubobject<UNinjaGASAbilitySystemComponent>(AbilitySystemComponentName);
 	if (IsValid(CharacterAbilities))
@@ -35,6 +38,27 @@ ANinjaGASCharacter::ANinjaGASCharacter(const FObjectInitializer& ObjectInitializ
 	}
 }
 
+void ANinjaGASCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+	if (!ReplicatedCharacterAbilities && CharacterAbilities)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ReplicatedCharacterAbilities, this);
+		ReplicatedCharacterAbilities = CharacterAbilities;
+		GAS_LOG(Log, "Synchronized Ability System for replication.");
+	}	
+}
+
+void ANinjaGASCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, ReplicatedCharacterAbilities, Params);
+}
+
 void ANinjaGASCharacter::PostInitProperties()
 {
 	Super::PostInitProperties();
@@ -52,6 +76,14 @@ void ANinjaGASCharacter::PreInitializeComponents()
 {
 	Super::PreInitializeComponents();
 	UGameFrameworkComponentManager::AddGameFrameworkComponentReceiver(this);
+
+	// Components created as default subobjects are already available, regardless of the initialization mode.
+	if (bInitializeAbilityComponentOnBeginPlay && !CharacterAbilities && AbilitySystemInitializationMode == ELazyAbilitySystemInitializationMode::Eager && GetNetMode() != NM_Client)
+	{
+		GAS_LOG_ARGS(Verbose, "Eagerly initializing the ASC for '%s'.", *GetNameSafe(this));
+		InitializeAbilitySystemComponent();
+		ForceNetUpdate();
+	}
 }
 
 void ANinjaGASCharacter::BeginPlay()
@@ -66,7 +98,13 @@ void ANinjaGASCharacter::BeginPlay()
 		// Doing this is useful as it makes this class compatible with both a gameplay feature and the
 		// ASC interface, avoiding the component lookup.
 		//
-		CharacterAbilities = UNinjaGASFunctionLibrary::GetCustomAbilitySystemComponentFromActor(this);
+		// Components are looked up directly, so lazy components are not created here.
+		//
+		if (!IsValid(CharacterAbilities))
+		{
+			CharacterAbilities = FindComponentByClass<UNinjaGASAbilitySystemComponent>();
+		}
+		
 		if (IsValid(CharacterAbilities))
 		{
 			SetupAbilitySystemComponent(this);
@@ -82,17 +120,78 @@ void ANinjaGASCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 
 UAbilitySystemComponent* ANinjaGASCharacter::GetAbilitySystemComponent() const
 {
+	if (!CharacterAbilities && bInitializeAbilityComponentOnBeginPlay && HasAuthority() && AbilitySystemInitializationMode == ELazyAbilitySystemInitializationMode::Lazy && GetWorld() && !IsUnreachable())
+	{
+		ANinjaGASCharacter* MutableCharacter = const_cast<ANinjaGASCharacter*>(this);
+		MutableCharacter->InitializeAbilitySystemComponent();
+		MutableCharacter->ForceNetUpdate();
+	}
+	
 	return CharacterAbilities;
 }
 
+ELazyAbilitySystemInitializationMode ANinjaGASCharacter::GetAbilitySystemInitializationMode() const
+{
+	return AbilitySystemInitializationMode;
+}
+
+UAbilitySystemComponent* ANinjaGASCharacter::PeekAbilitySystemComponent() const
+{
+	// Subclasses that do not own their component never initialize it, so their own lookup is safe.
+	return bInitializeAbilityComponentOnBeginPlay ? CharacterAbilities : GetAbilitySystemComponent();
+}
+
+UAbilitySystemComponent* ANinjaGASCharacter::EnsureAbilitySystemComponent()
+{
+	return GetAbilitySystemComponent();
+}
+
+void ANinjaGASCharacter::InitializeAbilitySystemComponent()
+{
+	CharacterAbilities = NewObject<UNinjaGASAbilitySystemComponent>(this, AbilitySystemComponentClass);
+	CharacterAbilities->SetIsReplicated(true);
+	CharacterAbilities->SetReplicationMode(AbilityReplicationMode);
+	CharacterAbilities->RegisterComponent();
+
+	// Otherwise, the actor info is initialized on Begin Play.
+	if (HasActorBegunPlay())
+	{
+		SetupAbilitySystemComponent(this);
+	}
+	
+	GAS_LOG_ARGS(Log, "Initialized Ability System Component for character '%s'.", *GetNameSafe(this));
+}
+
+void ANinjaGASCharacter::SetPendingAttributeFromReplication(const FGameplayAttribute& Attribute, const FGameplayAttributeData& NewValue)
+{
+	FPendingAttributeReplication::AddOrReplace(PendingAttributeReplications, Attribute, NewValue);
+	GAS_LOG_ARGS(Verbose, "Set pending attribute '%s' with base/current value: %f/%f.", *Attribute.GetName(), NewValue.GetBaseValue(), NewValue.GetCurrentValue());
+}
+
+void ANinjaGASCharacter::ApplyPendingAttributesFromReplication()
+{
+	checkf(CharacterAbilities, TEXT("Attempted to apply pending attributes without an ASC!"));
+	if (PendingAttributeReplications.Num() > 0)
+	{
+		CharacterAbilities->DeferredSetBaseAttributeValuesFromReplication(PendingAttributeReplications);
+		PendingAttributeReplications.Empty();
+	}
+}
+
 UNinjaGASDataAsset* ANinjaGASCharacter::GetAbilityData() const
 {
 	return DefaultAbilitySetup;
 }
 
+TSoftObjectPtr<UNinjaGASDataAsset> ANinjaGASCharacter::GetSoftAbilityData() const
+{
+	return SoftAbilitySetup;
+}
+
 void ANinjaGASCharacter::GetOwnedGameplayTags(FGameplayTagContainer& TagContainer) const
 {
-	const UAbilitySystemComponent* MyAbilities = GetAbilitySystemComponent();
+	// Tag queries never initialize lazy components, which would not have any tags yet.
+	const UAbilitySystemComponent* MyAbilities = PeekAbilitySystemComponent();
 	if (IsValid(MyAbilities))
 	{
 		MyAbilities->GetOwnedGameplayTags(TagContainer);
@@ -146,3 +245,29 @@ void ANinjaGASCharacter::InitializeFromPlayerState()
 	
 	SetupAbilitySystemComponent(MyState);	
 }
+
+void ANinjaGASCharacter::OnRep_ReplicatedCharacterAbilities()
+{
+	// Components created as default subobjects are already set on clients.
+	if (!bInitializeAbilityComponentOnBeginPlay)
+	{
+		return;
+	}
+
+	// The replicated component is hydrated in place. Begin Play may have found it already.
+	if (CharacterAbilities != ReplicatedCharacterAbilities)
+	{
+		CharacterAbilities = ReplicatedCharacterAbilities;
+		
+		// Otherwise, the actor info is initialized on Begin Play.
+		if (CharacterAbilities && HasActorBegunPlay())
+		{
+			SetupAbilitySystemComponent(this);
+		}
+	}
+
+	if (CharacterAbilities)
+	{
+		ApplyPendingAttributesFromReplication();
+	}
+}
@@ -1,11 +1,12 @@
 ﻿// Ninja Bear Studio Inc. 2024, all rights reserved.
 #include "GameFramework/NinjaGASPawn.h"
 
-#include "NinjaGASFunctionLibrary.h"
+#include "NinjaGASLog.h"
 #include "TimerManager.h"
 #include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
 #include "Components/GameFrameworkComponentManager.h"
 #include "GameFramework/PlayerState.h"
+#include "Net/UnrealNetwork.h"
 #include "Runtime/Launch/Resources/Version.h"
 
 FName ANinjaGASPawn::AbilitySystemComponentName = TEXT("AbilitySystemComponent");
@@ -16,6 +17,8 @@ ANinjaGASPawn::ANinjaGASPawn(const FObjectInitializer& ObjectInitializer) : Supe
 	bInitializeAbilityComponentOnBeginPlay = true;
 	NetPriority = 2.f;
 	AbilityReplicationMode = EGameplayEffectReplicationMode::Minimal;
+	AbilitySystemInitializationMode = ELazyAbilitySystemInitializationMode::Eager;
+	AbilitySystemComponentClass = UNinjaGASAbilitySystemComponent::StaticClass();
 	
 #if ENGINE_MINOR_VERSION < 5
 	MinNetUpdateFrequency = 11.f;
@@ -33,6 +36,27 @@ ANinjaGASPawn::ANinjaGASPawn(const FObjectInitializer& ObjectInitializer) : Supe
 	}
 }
 
+void ANinjaGASPawn::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+	if (!ReplicatedPawnAbilities && PawnAbilities)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ReplicatedPawnAbilities, this);
+		ReplicatedPawnAbilities = PawnAbilities;
+		GAS_LOG(Log, "Synchronized Ability System for replication.");
+	}	
+}
+
+void ANinjaGASPawn::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, ReplicatedPawnAbilities, Params);
+}
+
 void ANinjaGASPawn::PostInitProperties()
 {
 	Super::PostInitProperties();
@@ -48,6 +72,14 @@ void ANinjaGASPawn::PreInitializeComponents()
 {
 	Super::PreInitializeComponents();
 	UGameFrameworkComponentManager::AddGameFrameworkComponentReceiver(this);
+
+	// Components created as default subobjects are already available, regardless of the initialization mode.
+	if (bInitializeAbilityComponentOnBeginPlay && !PawnAbilities && AbilitySystemInitializationMode == ELazyAbilitySystemInitializationMode::Eager && GetNetMode() != NM_Client)
+	{
+		GAS_LOG_ARGS(Verbose, "Eagerly initializing the ASC for '%s'.", *GetNameSafe(this));
+		InitializeAbilitySystemComponent();
+		ForceNetUpdate();
+	}
 }
 
 void ANinjaGASPawn::BeginPlay()
@@ -61,7 +93,13 @@ void ANinjaGASPawn::BeginPlay()
 		// Doing this is useful as it makes this class compatible with both a gameplay feature and the
 		// ASC interface, avoiding the component lookup.
 		//
-		PawnAbilities = UNinjaGASFunctionLibrary::GetCustomAbilitySystemComponentFromActor(this);
+		// Components are looked up directly, so lazy components are not created here.
+		//
+		if (!IsValid(PawnAbilities))
+		{
+			PawnAbilities = FindComponentByClass<UNinjaGASAbilitySystemComponent>();
+		}
+		
 		if (IsValid(PawnAbilities))
 		{
 			PawnAbilities->InitAbilityActorInfo(this, this);
@@ -77,9 +115,64 @@ void ANinjaGASPawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
 
 UAbilitySystemComponent* ANinjaGASPawn::GetAbilitySystemComponent() const
 {
+	if (!PawnAbilities && bInitializeAbilityComponentOnBeginPlay && HasAuthority() && AbilitySystemInitializationMode == ELazyAbilitySystemInitializationMode::Lazy && GetWorld() && !IsUnreachable())
+	{
+		ANinjaGASPawn* MutablePawn = const_cast<ANinjaGASPawn*>(this);
+		MutablePawn->InitializeAbilitySystemComponent();
+		MutablePawn->ForceNetUpdate();
+	}
+	
 	return PawnAbilities;
 }
 
+ELazyAbilitySystemInitializationMode ANinjaGASPawn::GetAbilitySystemInitializationMode() const
+{
+	return AbilitySystemInitializationMode;
+}
+
+UAbilitySystemComponent* ANinjaGASPawn::PeekAbilitySystemComponent() const
+{
+	// Subclasses that do not own their component never initialize it, so their own lookup is safe.
+	return bInitializeAbilityComponentOnBeginPlay ? PawnAbilities : GetAbilitySystemComponent();
+}
+
+UAbilitySystemComponent* ANinjaGASPawn::EnsureAbilitySystemComponent()
+{
+	return GetAbilitySystemComponent();
+}
+
+void ANinjaGASPawn::InitializeAbilitySystemComponent()
+{
+	PawnAbilities = NewObject<UNinjaGASAbilitySystemComponent>(this, AbilitySystemComponentClass);
+	PawnAbilities->SetIsReplicated(true);
+	PawnAbilities->SetReplicationMode(AbilityReplicationMode);
+	PawnAbilities->RegisterComponent();
+
+	// Otherwise, the actor info is initialized on Begin Play.
+	if (HasActorBegunPlay())
+	{
+		SetupAbilitySystemComponent(this);
+	}
+	
+	GAS_LOG_ARGS(Log, "Initialized Ability System Component for pawn '%s'.", *GetNameSafe(this));
+}
+
+void ANinjaGASPawn::SetPendingAttributeFromReplication(const FGameplayAttribute& Attribute, const FGameplayAttributeData& NewValue)
+{
+	FPendingAttributeReplication::AddOrReplace(PendingAttributeReplications, Attribute, NewValue);
+	GAS_LOG_ARGS(Verbose, "Set pending attribute '%s' with base/current value: %f/%f.", *Attribute.GetName(), NewValue.GetBaseValue(), NewValue.GetCurrentValue());
+}
+
+void ANinjaGASPawn::ApplyPendingAttributesFromReplication()
+{
+	checkf(PawnAbilities, TEXT("Attempted to apply pending attributes without an ASC!"));
+	if (PendingAttributeReplications.Num() > 0)
+	{
+		PawnAbilities->DeferredSetBaseAttributeValuesFromReplication(PendingAttributeReplications);
+		PendingAttributeReplications.Empty();
+	}
+}
+
 void ANinjaGASPawn::SetupAbilitySystemComponent(AActor* AbilitySystemOwner)
 {
 	if (IsValid(PawnAbilities))
@@ -123,3 +216,29 @@ void ANinjaGASPawn::InitializeFromPlayerState()
 
 	SetupAbilitySystemComponent(MyState);	
 }
+
+void ANinjaGASPawn::OnRep_ReplicatedPawnAbilities()
+{
+	// Components created as default subobjects are already set on clients.
+	if (!bInitializeAbilityComponentOnBeginPlay)
+	{
+		return;
+	}
+
+	// The replicated component is hydrated in place. Begin Play may have found it already.
+	if (PawnAbilities != ReplicatedPawnAbilities)
+	{
+		PawnAbilities = ReplicatedPawnAbilities;
+		
+		// Otherwise, the actor info is initialized on Begin Play.
+		if (PawnAbilities && HasActorBegunPlay())
+		{
+			SetupAbilitySystemComponent(this);
+		}
+	}
+
+	if (PawnAbilities)
+	{
+		ApplyPendingAttributesFromReplication();
+	}
+}
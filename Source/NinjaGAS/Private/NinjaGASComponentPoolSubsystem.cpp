@@ -0,0 +1,181 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#include "NinjaGASComponentPoolSubsystem.h"
+
+#include "NinjaGASLog.h"
+#include "NinjaGASStats.h"
+#include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Ability System Components"), STAT_NinjaGAS_PooledAbilitySystemComponents, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ability System Component Pool Hits"), STAT_NinjaGAS_AbilitySystemComponentPoolHits, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ability System Component Pool Misses"), STAT_NinjaGAS_AbilitySystemComponentPoolMisses, STATGROUP_NinjaGAS);
+
+static TAutoConsoleVariable<bool> CVarComponentPoolEnabled(
+	TEXT("NinjaGAS.ComponentPool.Enabled"),
+	true,
+	TEXT("When enabled, lazy actors set to use the component pool borrow their Ability System Components from it. On networked worlds, the pool is only a warm-up cache.")
+);
+
+static TAutoConsoleVariable<int32> CVarComponentPoolMaxSize(
+	TEXT("NinjaGAS.ComponentPool.MaxSize"),
+	64,
+	TEXT("Maximum number of available components kept for each class and replication mode.")
+);
+
+static TAutoConsoleVariable<int32> CVarComponentPoolWarmUpCount(
+	TEXT("NinjaGAS.ComponentPool.WarmUpCount"),
+	8,
+	TEXT("Number of components created for each class and replication mode, when the first actor using them begins play.")
+);
+
+static constexpr ERenameFlags PooledComponentRenameFlags = REN_DontCreateRedirectors | REN_DoNotDirty | REN_NonTransactional;
+
+bool UNinjaGASComponentPoolSubsystem::IsPoolingEnabled()
+{
+	return CVarComponentPoolEnabled.GetValueOnGameThread();
+}
+
+void UNinjaGASComponentPoolSubsystem::Deinitialize()
+{
+	PooledComponents.Reset();
+	PooledCount = 0;
+	WarmedUpPools.Reset();
+	SET_DWORD_STAT(STAT_NinjaGAS_PooledAbilitySystemComponents, 0);
+	Super::Deinitialize();
+}
+
+UNinjaGASAbilitySystemComponent* UNinjaGASComponentPoolSubsystem::Acquire(AActor* Owner, const TSubclassOf<UNinjaGASAbilitySystemComponent>& ComponentClass, const EGameplayEffectReplicationMode ReplicationMode)
+{
+	check(IsValid(Owner) && ComponentClass);
+
+	UNinjaGASAbilitySystemComponent* AbilitySystemComponent = PopPooledComponent(FNinjaComponentPoolKey(ComponentClass, ReplicationMode));
+	if (AbilitySystemComponent == nullptr)
+	{
+		INC_DWORD_STAT(STAT_NinjaGAS_AbilitySystemComponentPoolMisses);
+		return NewObject<UNinjaGASAbilitySystemComponent>(Owner, ComponentClass);
+	}
+
+	// Names are only unique within the outer, so a new one is used for the actor.
+	const FName ComponentName = MakeUniqueObjectName(Owner, ComponentClass);
+	AbilitySystemComponent->Rename(*ComponentName.ToString(), Owner, PooledComponentRenameFlags);
+	
+	INC_DWORD_STAT(STAT_NinjaGAS_AbilitySystemComponentPoolHits);
+	SET_DWORD_STAT(STAT_NinjaGAS_PooledAbilitySystemComponents, PooledCount);
+	return AbilitySystemComponent;
+}
+
+void UNinjaGASComponentPoolSubsystem::Release(UNinjaGASAbilitySystemComponent* AbilitySystemComponent)
+{
+	if (!IsValid(AbilitySystemComponent))
+	{
+		return;
+	}
+
+	const FNinjaComponentPoolKey PoolKey(AbilitySystemComponent->GetClass(), AbilitySystemComponent->ReplicationMode);
+	const int32 MaxPoolSize = FMath::Max(CVarComponentPoolMaxSize.GetValueOnGameThread(), 0);
+	
+	if (!CanRecycle(AbilitySystemComponent) || CountPooledComponents(PoolKey) >= MaxPoolSize)
+	{
+		AbilitySystemComponent->DestroyComponent();
+		return;
+	}
+
+	AbilitySystemComponent->ResetForRecycling();
+
+	if (AbilitySystemComponent->IsRegistered())
+	{
+		AbilitySystemComponent->UnregisterComponent();
+	}
+
+	// The owner uninitializes components after they are removed, so the next owner would skip it.
+	if (AbilitySystemComponent->HasBeenInitialized())
+	{
+		AbilitySystemComponent->UninitializeComponent();
+	}
+
+	AbilitySystemComponent->SetIsReplicated(false);
+	AbilitySystemComponent->Rename(nullptr, this, PooledComponentRenameFlags);
+	PooledComponents.FindOrAdd(PoolKey).Components.Add(AbilitySystemComponent);
+	++PooledCount;
+
+	SET_DWORD_STAT(STAT_NinjaGAS_PooledAbilitySystemComponents, PooledCount);
+}
+
+void UNinjaGASComponentPoolSubsystem::WarmUp(const TSubclassOf<UNinjaGASAbilitySystemComponent>& ComponentClass, const EGameplayEffectReplicationMode ReplicationMode)
+{
+	if (!ComponentClass)
+	{
+		return;
+	}
+
+	const FNinjaComponentPoolKey PoolKey(ComponentClass.Get(), ReplicationMode);
+	
+	bool bIsAlreadyWarm = false;
+	WarmedUpPools.Add(PoolKey, &bIsAlreadyWarm);
+	if (bIsAlreadyWarm)
+	{
+		return;
+	}
+
+	const int32 WarmUpCount = FMath::Min(CVarComponentPoolWarmUpCount.GetValueOnGameThread(), CVarComponentPoolMaxSize.GetValueOnGameThread());
+	const int32 MissingCount = WarmUpCount - CountPooledComponents(PoolKey);
+
+	if (MissingCount > 0)
+	{
+		TArray<TObjectPtr<UNinjaGASAbilitySystemComponent>>& Components = PooledComponents.FindOrAdd(PoolKey).Components;
+		Components.Reserve(Components.Num() + MissingCount);
+		
+		for (int32 Index = 0; Index < MissingCount; ++Index)
+		{
+			Components.Add(CreatePooledComponent(ComponentClass, ReplicationMode));
+		}
+
+		PooledCount += MissingCount;
+	}
+
+	SET_DWORD_STAT(STAT_NinjaGAS_PooledAbilitySystemComponents, PooledCount);
+	UE_LOG(LogNinjaGAS, Verbose, TEXT("Warmed up %d Ability System Components of class %s."), FMath::Max(MissingCount, 0), *GetNameSafe(ComponentClass));
+}
+
+UNinjaGASAbilitySystemComponent* UNinjaGASComponentPoolSubsystem::PopPooledComponent(const FNinjaComponentPoolKey& PoolKey)
+{
+	FNinjaPooledAbilitySystemComponents* Pool = PooledComponents.Find(PoolKey);
+	if (Pool == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Components destroyed while pooled, such as by a level transition, are skipped.
+	while (!Pool->Components.IsEmpty())
+	{
+		UNinjaGASAbilitySystemComponent* AbilitySystemComponent = Pool->Components.Pop();
+		--PooledCount;
+		
+		if (IsValid(AbilitySystemComponent))
+		{
+			return AbilitySystemComponent;
+		}
+	}
+
+	return nullptr;
+}
+
+int32 UNinjaGASComponentPoolSubsystem::CountPooledComponents(const FNinjaComponentPoolKey& PoolKey) const
+{
+	const FNinjaPooledAbilitySystemComponents* Pool = PooledComponents.Find(PoolKey);
+	return Pool ? Pool->Components.Num() : 0;
+}
+
+UNinjaGASAbilitySystemComponent* UNinjaGASComponentPoolSubsystem::CreatePooledComponent(UClass* ComponentClass, const EGameplayEffectReplicationMode ReplicationMode)
+{
+	UNinjaGASAbilitySystemComponent* AbilitySystemComponent = NewObject<UNinjaGASAbilitySystemComponent>(this, ComponentClass);
+	AbilitySystemComponent->SetReplicationMode(ReplicationMode);
+	return AbilitySystemComponent;
+}
+
+bool UNinjaGASComponentPoolSubsystem::CanRecycle(const UNinjaGASAbilitySystemComponent* AbilitySystemComponent) const
+{
+	const UWorld* World = GetWorld();
+	return IsValid(World) && (World->GetNetMode() == NM_Standalone || !AbilitySystemComponent->GetIsReplicated());
+}
@@ -4,13 +4,34 @@
 #include "AbilitySystemComponent.h"
 #include "AbilitySystemGlobals.h"
 #include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
+#include "Interfaces/LazyAbilitySystemComponentOwnerInterface.h"
 
 UNinjaGASAbilitySystemComponent* UNinjaGASFunctionLibrary::GetCustomAbilitySystemComponentFromActor(AActor* Owner)
 {
-	UAbilitySystemComponent* ASC = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Owner);
+	UAbilitySystemComponent* ASC = EnsureAbilitySystemComponentFromActor(Owner);
 	return Cast<UNinjaGASAbilitySystemComponent>(ASC);	
 }
 
+UAbilitySystemComponent* UNinjaGASFunctionLibrary::PeekAbilitySystemComponentFromActor(const AActor* Owner)
+{
+	if (const ILazyAbilitySystemComponentOwnerInterface* LazyComponentOwner = Cast<ILazyAbilitySystemComponentOwnerInterface>(Owner))
+	{
+		return LazyComponentOwner->PeekAbilitySystemComponent();
+	}
+
+	return UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Owner);
+}
+
+UAbilitySystemComponent* UNinjaGASFunctionLibrary::EnsureAbilitySystemComponentFromActor(AActor* Owner)
+{
+	if (ILazyAbilitySystemComponentOwnerInterface* LazyComponentOwner = Cast<ILazyAbilitySystemComponentOwnerInterface>(Owner))
+	{
+		return LazyComponentOwner->EnsureAbilitySystemComponent();
+	}
+
+	return UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Owner);
+}
+
 int32 UNinjaGASFunctionLibrary::SendGameplayEventToActor(const AActor* AbilityOwner, const FGameplayTag EventTag, const FGameplayEventData& EventData)
 {
 	UAbilitySystemComponent* AbilityComponent = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(AbilityOwner);
@@ -35,7 +56,7 @@ void UNinjaGASFunctionLibrary::AddGameplayCueLocally(AActor* Target, const FGame
 		return;
 	}
 	
-	const UNinjaGASAbilitySystemComponent* AbilityComponent = GetCustomAbilitySystemComponentFromActor(Target);
+	const UNinjaGASAbilitySystemComponent* AbilityComponent = Cast<UNinjaGASAbilitySystemComponent>(PeekAbilitySystemComponentFromActor(Target));
 	if (IsValid(AbilityComponent))
 	{
 		AbilityComponent->AddGameplayCueLocally(GameplayCueTag, GameplayCueParameters);
@@ -50,7 +71,7 @@ void UNinjaGASFunctionLibrary::RemoveGameplayCueLocally(AActor* Target, const FG
 		return;
 	}
 
-	const UNinjaGASAbilitySystemComponent* AbilityComponent = GetCustomAbilitySystemComponentFromActor(Target);
+	const UNinjaGASAbilitySystemComponent* AbilityComponent = Cast<UNinjaGASAbilitySystemComponent>(PeekAbilitySystemComponentFromActor(Target));
 	if (IsValid(AbilityComponent))
 	{
 		AbilityComponent->RemoveGameplayCueLocally(GameplayCueTag, GameplayCueParameters);
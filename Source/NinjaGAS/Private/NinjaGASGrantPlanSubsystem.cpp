@@ -0,0 +1,249 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#include "NinjaGASGrantPlanSubsystem.h"
+
+#include "NinjaGASStats.h"
+#include "Data/NinjaGASDataAsset.h"
+#include "Engine/DataTable.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/PackageReload.h"
+#include "UObject/UObjectGlobals.h"
+
+DECLARE_CYCLE_STAT(TEXT("Compile Grant Plan"), STAT_NinjaGAS_CompileGrantPlan, STATGROUP_NinjaGAS);
+DECLARE_CYCLE_STAT(TEXT("Build Attribute Table Layout"), STAT_NinjaGAS_BuildAttributeTableLayout, STATGROUP_NinjaGAS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Grant Plans"), STAT_NinjaGAS_CachedGrantPlans, STATGROUP_NinjaGAS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Attribute Table Layouts"), STAT_NinjaGAS_CachedAttributeTableLayouts, STATGROUP_NinjaGAS);
+
+static TAutoConsoleVariable<bool> CVarGrantPlanEnabled(
+	TEXT("NinjaGAS.GrantPlan.Enabled"),
+	true,
+	TEXT("When enabled, Ability System defaults are granted from cached plans compiled once per data asset.")
+);
+
+static TAutoConsoleVariable<bool> CVarAttributeTableLayoutEnabled(
+	TEXT("NinjaGAS.AttributeTableLayout.Enabled"),
+	true,
+	TEXT("When enabled, Attribute Sets are initialized from baked table layouts instead of InitFromMetaDataTable.")
+);
+
+TSharedPtr<const FNinjaAbilityGrantPlan> UNinjaGASGrantPlanSubsystem::FindOrCompileGrantPlan(const UNinjaGASDataAsset* AbilityData)
+{
+	if (!IsValid(AbilityData) || !CVarGrantPlanEnabled.GetValueOnGameThread() || !GEngine)
+	{
+		return nullptr;
+	}
+
+	UNinjaGASGrantPlanSubsystem* Subsystem = GEngine->GetEngineSubsystem<UNinjaGASGrantPlanSubsystem>();
+	if (!IsValid(Subsystem))
+	{
+		return nullptr;
+	}
+
+	return Subsystem->GetGrantPlan(AbilityData);
+}
+
+TSharedPtr<const FNinjaAttributeTableLayout> UNinjaGASGrantPlanSubsystem::FindOrBuildAttributeTableLayout(const UClass* AttributeSetClass, const UDataTable* AttributeTable)
+{
+	if (!IsValid(AttributeSetClass) || !CVarAttributeTableLayoutEnabled.GetValueOnGameThread() || !GEngine)
+	{
+		return nullptr;
+	}
+
+	UNinjaGASGrantPlanSubsystem* Subsystem = GEngine->GetEngineSubsystem<UNinjaGASGrantPlanSubsystem>();
+	if (!IsValid(Subsystem))
+	{
+		return nullptr;
+	}
+
+	return Subsystem->GetAttributeTableLayout(AttributeSetClass, AttributeTable);
+}
+
+void UNinjaGASGrantPlanSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &ThisClass::HandlePostGarbageCollect);
+	ObjectsReplacedHandle = FCoreUObjectDelegates::OnObjectsReplaced.AddUObject(this, &ThisClass::HandleObjectsReplaced);
+
+#if WITH_EDITOR
+	ObjectPropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddUObject(this, &ThisClass::HandleObjectPropertyChanged);
+	PackageReloadedHandle = FCoreUObjectDelegates::OnPackageReloaded.AddUObject(this, &ThisClass::HandlePackageReloaded);
+#endif
+}
+
+void UNinjaGASGrantPlanSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+	FCoreUObjectDelegates::OnObjectsReplaced.Remove(ObjectsReplacedHandle);
+
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(ObjectPropertyChangedHandle);
+	FCoreUObjectDelegates::OnPackageReloaded.Remove(PackageReloadedHandle);
+#endif
+
+	InvalidateAllGrantPlans();
+	AttributeTableLayouts.Reset();
+
+#if WITH_EDITOR
+	for (const TObjectKey<const UDataTable>& TableKey : ObservedTables)
+	{
+		if (UDataTable* AttributeTable = const_cast<UDataTable*>(TableKey.ResolveObjectPtr()))
+		{
+			AttributeTable->OnDataTableChanged().RemoveAll(this);
+		}
+	}
+	ObservedTables.Reset();
+#endif
+	
+	Super::Deinitialize();
+}
+
+TSharedRef<const FNinjaAbilityGrantPlan> UNinjaGASGrantPlanSubsystem::GetGrantPlan(const UNinjaGASDataAsset* AbilityData)
+{
+	check(IsInGameThread());
+
+	const TObjectKey<const UNinjaGASDataAsset> Key(AbilityData);
+	if (const TSharedRef<const FNinjaAbilityGrantPlan>* ExistingPlan = GrantPlans.Find(Key))
+	{
+		return *ExistingPlan;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NinjaGAS_CompileGrantPlan);
+	TSharedRef<const FNinjaAbilityGrantPlan> NewPlan = FNinjaAbilityGrantPlan::Compile(AbilityData);
+	GrantPlans.Add(Key, NewPlan);
+	SET_DWORD_STAT(STAT_NinjaGAS_CachedGrantPlans, GrantPlans.Num());
+
+	return NewPlan;
+}
+
+void UNinjaGASGrantPlanSubsystem::InvalidateGrantPlan(const UNinjaGASDataAsset* AbilityData)
+{
+	GrantPlans.Remove(TObjectKey<const UNinjaGASDataAsset>(AbilityData));
+	SET_DWORD_STAT(STAT_NinjaGAS_CachedGrantPlans, GrantPlans.Num());
+}
+
+void UNinjaGASGrantPlanSubsystem::InvalidateAllGrantPlans()
+{
+	GrantPlans.Reset();
+	SET_DWORD_STAT(STAT_NinjaGAS_CachedGrantPlans, 0);
+}
+
+TSharedRef<const FNinjaAttributeTableLayout> UNinjaGASGrantPlanSubsystem::GetAttributeTableLayout(const UClass* AttributeSetClass, const UDataTable* AttributeTable)
+{
+	check(IsInGameThread());
+
+	const FAttributeTableLayoutKey Key(AttributeSetClass, AttributeTable);
+	if (const TSharedRef<const FNinjaAttributeTableLayout>* ExistingLayout = AttributeTableLayouts.Find(Key))
+	{
+		return *ExistingLayout;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NinjaGAS_BuildAttributeTableLayout);
+	TSharedRef<const FNinjaAttributeTableLayout> NewLayout = FNinjaAttributeTableLayout::Build(AttributeSetClass, AttributeTable);
+	AttributeTableLayouts.Add(Key, NewLayout);
+	SET_DWORD_STAT(STAT_NinjaGAS_CachedAttributeTableLayouts, AttributeTableLayouts.Num());
+
+#if WITH_EDITOR
+	// Rows can be edited or reimported without touching the table properties.
+	const TObjectKey<const UDataTable> TableKey(AttributeTable);
+	if (IsValid(AttributeTable) && !ObservedTables.Contains(TableKey))
+	{
+		ObservedTables.Add(TableKey);
+		const_cast<UDataTable*>(AttributeTable)->OnDataTableChanged().AddUObject(this, &ThisClass::HandleDataTableChanged, TableKey);
+	}
+#endif
+	
+	return NewLayout;
+}
+
+void UNinjaGASGrantPlanSubsystem::InvalidateAttributeTableLayouts(const UDataTable* AttributeTable)
+{
+	const TObjectKey<const UDataTable> TableKey(AttributeTable);
+	for (auto It(AttributeTableLayouts.CreateIterator()); It; ++It)
+	{
+		if (It.Key().Value == TableKey)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_NinjaGAS_CachedAttributeTableLayouts, AttributeTableLayouts.Num());
+}
+
+void UNinjaGASGrantPlanSubsystem::HandlePostGarbageCollect()
+{
+	for (auto It(GrantPlans.CreateIterator()); It; ++It)
+	{
+		if (It.Key().ResolveObjectPtr() == nullptr)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (auto It(AttributeTableLayouts.CreateIterator()); It; ++It)
+	{
+		// Layouts with class defaults are not bound to any table.
+		const bool bTableWasCollected = It.Key().Value != TObjectKey<const UDataTable>() && It.Key().Value.ResolveObjectPtr() == nullptr;
+		if (It.Key().Key.ResolveObjectPtr() == nullptr || bTableWasCollected)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+#if WITH_EDITOR
+	for (auto It(ObservedTables.CreateIterator()); It; ++It)
+	{
+		if (It->ResolveObjectPtr() == nullptr)
+		{
+			It.RemoveCurrent();
+		}
+	}
+#endif
+	
+	SET_DWORD_STAT(STAT_NinjaGAS_CachedGrantPlans, GrantPlans.Num());
+	SET_DWORD_STAT(STAT_NinjaGAS_CachedAttributeTableLayouts, AttributeTableLayouts.Num());
+}
+
+void UNinjaGASGrantPlanSubsystem::HandleObjectsReplaced(const TMap<UObject*, UObject*>& ReplacementMap)
+{
+	if (ReplacementMap.IsEmpty())
+	{
+		return;
+	}
+
+	// Plans hold effect definitions, ability specs and tables that may point to the old objects.
+	InvalidateAllGrantPlans();
+	AttributeTableLayouts.Reset();
+	SET_DWORD_STAT(STAT_NinjaGAS_CachedAttributeTableLayouts, 0);
+}
+
+#if WITH_EDITOR
+void UNinjaGASGrantPlanSubsystem::HandleObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent)
+{
+	if (const UNinjaGASDataAsset* AbilityData = Cast<UNinjaGASDataAsset>(Object))
+	{
+		InvalidateGrantPlan(AbilityData);
+	}
+	else if (const UDataTable* AttributeTable = Cast<UDataTable>(Object))
+	{
+		InvalidateAttributeTableLayouts(AttributeTable);
+	}
+}
+
+void UNinjaGASGrantPlanSubsystem::HandleDataTableChanged(const TObjectKey<const UDataTable> AttributeTable)
+{
+	if (const UDataTable* Table = AttributeTable.ResolveObjectPtr())
+	{
+		InvalidateAttributeTableLayouts(Table);
+	}
+}
+
+void UNinjaGASGrantPlanSubsystem::HandlePackageReloaded(const EPackageReloadPhase Phase, FPackageReloadedEvent* PackageReloadedEvent)
+{
+	if (Phase == EPackageReloadPhase::PostBatchPostGC)
+	{
+		InvalidateAllGrantPlans();
+		AttributeTableLayouts.Reset();
+		SET_DWORD_STAT(STAT_NinjaGAS_CachedAttributeTableLayouts, 0);
+	}
+}
+#endif
@@ -0,0 +1,113 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#include "NinjaGASIdleDemotionSubsystem.h"
+
+#include "NinjaGASLog.h"
+#include "NinjaGASStats.h"
+#include "Engine/World.h"
+#include "GameFramework/NinjaGASActor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Idle Demotion"), STAT_NinjaGAS_UpdateIdleDemotion, STATGROUP_NinjaGAS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Idle Demotion Candidates"), STAT_NinjaGAS_IdleDemotionCandidates, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ability System Components Demoted"), STAT_NinjaGAS_AbilitySystemComponentsDemoted, STATGROUP_NinjaGAS);
+
+static TAutoConsoleVariable<bool> CVarIdleDemotionEnabled(
+	TEXT("NinjaGAS.IdleDemotion.Enabled"),
+	true,
+	TEXT("When enabled, lazy actors set to demote idle components release them after their idle delay.")
+);
+
+static TAutoConsoleVariable<int32> CVarIdleDemotionChecksPerFrame(
+	TEXT("NinjaGAS.IdleDemotion.ChecksPerFrame"),
+	64,
+	TEXT("Number of watched actors checked for idle components each frame.")
+);
+
+bool UNinjaGASIdleDemotionSubsystem::IsDemotionEnabled()
+{
+	return CVarIdleDemotionEnabled.GetValueOnGameThread();
+}
+
+void UNinjaGASIdleDemotionSubsystem::Deinitialize()
+{
+	Candidates.Reset();
+	NextCandidateIndex = 0;
+	SET_DWORD_STAT(STAT_NinjaGAS_IdleDemotionCandidates, 0);
+	Super::Deinitialize();
+}
+
+bool UNinjaGASIdleDemotionSubsystem::IsTickable() const
+{
+	return !Candidates.IsEmpty() && IsDemotionEnabled();
+}
+
+TStatId UNinjaGASIdleDemotionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNinjaGASIdleDemotionSubsystem, STATGROUP_Tickables);
+}
+
+void UNinjaGASIdleDemotionSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	SCOPE_CYCLE_COUNTER(STAT_NinjaGAS_UpdateIdleDemotion);
+
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+	const int32 CheckCount = FMath::Min(FMath::Max(CVarIdleDemotionChecksPerFrame.GetValueOnGameThread(), 1), Candidates.Num());
+	int32 DemotedCount = 0;
+
+	for (int32 CheckIndex = 0; CheckIndex < CheckCount && !Candidates.IsEmpty(); ++CheckIndex)
+	{
+		if (!Candidates.IsValidIndex(NextCandidateIndex))
+		{
+			NextCandidateIndex = 0;
+		}
+
+		FIdleCandidate& Candidate = Candidates[NextCandidateIndex];
+		ANinjaGASActor* Actor = Candidate.Actor.Get();
+
+		// Destroyed actors are not removed when ending play, so they are pruned here instead.
+		if (!IsValid(Actor) || !IsValid(Actor->ActorAbilities))
+		{
+			Candidates.RemoveAtSwap(NextCandidateIndex);
+			continue;
+		}
+
+		if (!Actor->IsAbilitySystemComponentIdle())
+		{
+			Candidate.IdleSince = -1.;
+			++NextCandidateIndex;
+			continue;
+		}
+
+		if (Candidate.IdleSince < 0.)
+		{
+			Candidate.IdleSince = CurrentTime;
+		}
+
+		if (CurrentTime - Candidate.IdleSince < Actor->IdleDemotionDelay)
+		{
+			++NextCandidateIndex;
+			continue;
+		}
+
+		// Removed before demoting, since the actor registers again once a new component is created.
+		Candidates.RemoveAtSwap(NextCandidateIndex);
+		Actor->DemoteAbilitySystemComponent();
+		++DemotedCount;
+	}
+
+	INC_DWORD_STAT_BY(STAT_NinjaGAS_AbilitySystemComponentsDemoted, DemotedCount);
+	SET_DWORD_STAT(STAT_NinjaGAS_IdleDemotionCandidates, Candidates.Num());
+
+	UE_CLOG(DemotedCount > 0, LogNinjaGAS, Verbose, TEXT("Demoted %d idle Ability System Components, %d remaining."), DemotedCount, Candidates.Num());
+}
+
+void UNinjaGASIdleDemotionSubsystem::Register(ANinjaGASActor* Actor)
+{
+	check(IsValid(Actor));
+
+	FIdleCandidate& Candidate = Candidates.AddDefaulted_GetRef();
+	Candidate.Actor = Actor;
+
+	SET_DWORD_STAT(STAT_NinjaGAS_IdleDemotionCandidates, Candidates.Num());
+}
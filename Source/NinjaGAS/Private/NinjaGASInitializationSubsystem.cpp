@@ -0,0 +1,190 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#include "NinjaGASInitializationSubsystem.h"
+
+#include "NinjaGASLog.h"
+#include "NinjaGASStats.h"
+#include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Process Scheduled Initialization"), STAT_NinjaGAS_ProcessScheduledInitialization, STATGROUP_NinjaGAS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scheduled Initialization Queue"), STAT_NinjaGAS_ScheduledInitializationQueue, STATGROUP_NinjaGAS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scheduled Initializations Processed"), STAT_NinjaGAS_ScheduledInitializationsProcessed, STATGROUP_NinjaGAS);
+
+static TAutoConsoleVariable<bool> CVarScheduledInitializationEnabled(
+	TEXT("NinjaGAS.ScheduledInitialization.Enabled"),
+	true,
+	TEXT("When enabled, components set to schedule their initialization are processed under a frame budget.")
+);
+
+static TAutoConsoleVariable<float> CVarScheduledInitializationBudgetMs(
+	TEXT("NinjaGAS.ScheduledInitialization.FrameBudgetMs"),
+	2.f,
+	TEXT("Milliseconds per frame used to initialize and reset scheduled components. At least one component is always processed.")
+);
+
+bool UNinjaGASInitializationSubsystem::IsSchedulingEnabled()
+{
+	return CVarScheduledInitializationEnabled.GetValueOnGameThread();
+}
+
+void UNinjaGASInitializationSubsystem::Deinitialize()
+{
+	PendingRequests.Reset();
+	SET_DWORD_STAT(STAT_NinjaGAS_ScheduledInitializationQueue, 0);
+	Super::Deinitialize();
+}
+
+bool UNinjaGASInitializationSubsystem::IsTickable() const
+{
+	return !PendingRequests.IsEmpty();
+}
+
+TStatId UNinjaGASInitializationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNinjaGASInitializationSubsystem, STATGROUP_Tickables);
+}
+
+void UNinjaGASInitializationSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	SCOPE_CYCLE_COUNTER(STAT_NinjaGAS_ProcessScheduledInitialization);
+
+	const UWorld* World = GetWorld();
+
+	TArray<FVector> PlayerLocations;
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APlayerController* PlayerController = It->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			PlayerLocations.Add(ViewLocation);
+		}
+	}
+
+	for (FPendingRequest& Request : PendingRequests)
+	{
+		Request.Priority = GetPriority(Request.AbilitySystemComponent.Get(), PlayerLocations);
+	}
+
+	// Processed from the back, so the highest priority goes last.
+	PendingRequests.Sort([](const FPendingRequest& A, const FPendingRequest& B)
+	{
+		return A.Priority != B.Priority ? A.Priority > B.Priority : A.Sequence > B.Sequence;
+	});
+
+	const double BudgetSeconds = FMath::Max(CVarScheduledInitializationBudgetMs.GetValueOnGameThread(), 0.f) / 1000.;
+	const double StartTime = FPlatformTime::Seconds();
+	int32 ProcessedCount = 0;
+
+	while (!PendingRequests.IsEmpty())
+	{
+		// Popped before processing, since components may queue new work while being processed.
+		const FPendingRequest Request = PendingRequests.Pop();
+		if (UNinjaGASAbilitySystemComponent* AbilitySystemComponent = Request.AbilitySystemComponent.Get())
+		{
+			AbilitySystemComponent->ProcessScheduledInitialization(Request.bReset, Request.bInitialize, Request.bAvatarHasChanged);
+			++ProcessedCount;
+		}
+
+		if (ProcessedCount > 0 && FPlatformTime::Seconds() - StartTime >= BudgetSeconds)
+		{
+			break;
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_NinjaGAS_ScheduledInitializationsProcessed, ProcessedCount);
+	SET_DWORD_STAT(STAT_NinjaGAS_ScheduledInitializationQueue, PendingRequests.Num());
+
+	UE_LOG(LogNinjaGAS, Verbose, TEXT("Processed %d scheduled Ability System Components in %.3f ms, %d remaining."),
+		ProcessedCount, (FPlatformTime::Seconds() - StartTime) * 1000., PendingRequests.Num());
+}
+
+void UNinjaGASInitializationSubsystem::QueueInitialization(UNinjaGASAbilitySystemComponent* AbilitySystemComponent, const bool bAvatarHasChanged)
+{
+	FPendingRequest& Request = FindOrAddRequest(AbilitySystemComponent);
+	Request.bInitialize = true;
+	Request.bAvatarHasChanged |= bAvatarHasChanged;
+}
+
+void UNinjaGASInitializationSubsystem::QueueReset(UNinjaGASAbilitySystemComponent* AbilitySystemComponent)
+{
+	FPendingRequest& Request = FindOrAddRequest(AbilitySystemComponent);
+	Request.bReset = true;
+}
+
+void UNinjaGASInitializationSubsystem::Dequeue(const UNinjaGASAbilitySystemComponent* AbilitySystemComponent)
+{
+	PendingRequests.RemoveAll([AbilitySystemComponent](const FPendingRequest& Request)
+	{
+		return Request.AbilitySystemComponent == AbilitySystemComponent;
+	});
+
+	SET_DWORD_STAT(STAT_NinjaGAS_ScheduledInitializationQueue, PendingRequests.Num());
+}
+
+bool UNinjaGASInitializationSubsystem::IsQueued(const UNinjaGASAbilitySystemComponent* AbilitySystemComponent) const
+{
+	return PendingRequests.ContainsByPredicate([AbilitySystemComponent](const FPendingRequest& Request)
+	{
+		return Request.AbilitySystemComponent == AbilitySystemComponent;
+	});
+}
+
+double UNinjaGASInitializationSubsystem::GetPriority(const UNinjaGASAbilitySystemComponent* AbilitySystemComponent, const TArray<FVector>& PlayerLocations) const
+{
+	if (!IsValid(AbilitySystemComponent))
+	{
+		return 0.;
+	}
+
+	const AActor* OwnerActor = AbilitySystemComponent->GetOwnerActor();
+	const AActor* AvatarActor = AbilitySystemComponent->GetAvatarActor();
+	const APawn* AvatarPawn = Cast<APawn>(AvatarActor);
+
+	if ((OwnerActor && OwnerActor->IsA<APlayerState>()) || (AvatarPawn && AvatarPawn->IsPlayerControlled()))
+	{
+		return -1.;
+	}
+
+	if (!IsValid(AvatarActor) || PlayerLocations.IsEmpty())
+	{
+		return TNumericLimits<double>::Max();
+	}
+
+	const FVector AvatarLocation = AvatarActor->GetActorLocation();
+	double ClosestDistanceSquared = TNumericLimits<double>::Max();
+	for (const FVector& PlayerLocation : PlayerLocations)
+	{
+		ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector::DistSquared(AvatarLocation, PlayerLocation));
+	}
+
+	return ClosestDistanceSquared;
+}
+
+UNinjaGASInitializationSubsystem::FPendingRequest& UNinjaGASInitializationSubsystem::FindOrAddRequest(UNinjaGASAbilitySystemComponent* AbilitySystemComponent)
+{
+	check(IsValid(AbilitySystemComponent));
+
+	FPendingRequest* ExistingRequest = PendingRequests.FindByPredicate([AbilitySystemComponent](const FPendingRequest& Request)
+	{
+		return Request.AbilitySystemComponent == AbilitySystemComponent;
+	});
+
+	if (ExistingRequest)
+	{
+		return *ExistingRequest;
+	}
+
+	FPendingRequest& NewRequest = PendingRequests.AddDefaulted_GetRef();
+	NewRequest.AbilitySystemComponent = AbilitySystemComponent;
+	NewRequest.Sequence = NextSequence++;
+
+	SET_DWORD_STAT(STAT_NinjaGAS_ScheduledInitializationQueue, PendingRequests.Num());
+	return NewRequest;
+}
@@ -0,0 +1,160 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#include "NinjaGASMontageReplicationSubsystem.h"
+
+#include "NinjaGASLog.h"
+#include "NinjaGASStats.h"
+#include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flush Montage Replication"), STAT_NinjaGAS_FlushMontageReplication, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Net Updates Forced"), STAT_NinjaGAS_MontageNetUpdatesForced, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Net Updates Saved"), STAT_NinjaGAS_MontageNetUpdatesSaved, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Commands Rate Limited"), STAT_NinjaGAS_MontageCommandsRateLimited, STATGROUP_NinjaGAS);
+
+static TAutoConsoleVariable<bool> CVarMontageReplicationCoalesce(
+	TEXT("NinjaGAS.MontageReplication.CoalesceUpdates"),
+	true,
+	TEXT("When enabled, montage replication changes made during a frame are flushed once, with a single forced net update per avatar.")
+);
+
+static TAutoConsoleVariable<float> CVarMontageCommandRateLimit(
+	TEXT("NinjaGAS.MontageCommands.RateLimit"),
+	30.f,
+	TEXT("Montage commands per second that a client connection can apply on the server. Zero or less disables the limit.")
+);
+
+static TAutoConsoleVariable<int32> CVarMontageCommandBurstSize(
+	TEXT("NinjaGAS.MontageCommands.BurstSize"),
+	20,
+	TEXT("Montage commands that a client connection can apply at once, before the rate limit applies.")
+);
+
+static TAutoConsoleVariable<int32> CVarMontageCommandMaxBacklog(
+	TEXT("NinjaGAS.MontageCommands.MaxBacklog"),
+	64,
+	TEXT("Rate limited montage commands the server keeps for a client. Clients going over it are disconnected.")
+);
+
+bool UNinjaGASMontageReplicationSubsystem::IsCoalescingEnabled()
+{
+	return CVarMontageReplicationCoalesce.GetValueOnGameThread();
+}
+
+int32 UNinjaGASMontageReplicationSubsystem::GetMaxMontageCommandBacklog()
+{
+	return CVarMontageCommandMaxBacklog.GetValueOnGameThread();
+}
+
+void UNinjaGASMontageReplicationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ThisClass::HandlePostActorTick);
+}
+
+void UNinjaGASMontageReplicationSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	PendingComponents.Reset();
+	MontageCommandBudgets.Reset();
+	Super::Deinitialize();
+}
+
+void UNinjaGASMontageReplicationSubsystem::QueueFlush(UNinjaGASAbilitySystemComponent* AbilitySystemComponent)
+{
+	check(IsValid(AbilitySystemComponent));
+	PendingComponents.AddUnique(AbilitySystemComponent);
+}
+
+void UNinjaGASMontageReplicationSubsystem::Flush()
+{
+	if (PendingComponents.IsEmpty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NinjaGAS_FlushMontageReplication);
+
+	// Swapped before flushing, since flushing may queue components again.
+	TArray<TWeakObjectPtr<UNinjaGASAbilitySystemComponent>> ComponentsToFlush = MoveTemp(PendingComponents);
+	TArray<AActor*, TInlineAllocator<16>> AvatarsToUpdate;
+	int32 RequestedCount = 0;
+
+	for (const TWeakObjectPtr<UNinjaGASAbilitySystemComponent>& WeakComponent : ComponentsToFlush)
+	{
+		UNinjaGASAbilitySystemComponent* AbilitySystemComponent = WeakComponent.Get();
+		const int32 ComponentRequests = IsValid(AbilitySystemComponent) ? AbilitySystemComponent->FlushMontageReplication() : 0;
+		RequestedCount += ComponentRequests;
+		
+		if (ComponentRequests > 0)
+		{
+			AActor* AvatarActor = AbilitySystemComponent->GetAvatarActor_Direct();
+			if (IsValid(AvatarActor))
+			{
+				AvatarsToUpdate.AddUnique(AvatarActor);
+			}
+		}
+	}
+
+	for (AActor* AvatarActor : AvatarsToUpdate)
+	{
+		AvatarActor->ForceNetUpdate();
+	}
+
+	INC_DWORD_STAT_BY(STAT_NinjaGAS_MontageNetUpdatesForced, AvatarsToUpdate.Num());
+	INC_DWORD_STAT_BY(STAT_NinjaGAS_MontageNetUpdatesSaved, FMath::Max(RequestedCount - AvatarsToUpdate.Num(), 0));
+}
+
+int32 UNinjaGASMontageReplicationSubsystem::ConsumeMontageCommandBudget(const UNetConnection* Connection, const int32 CommandCount)
+{
+	const float RateLimit = CVarMontageCommandRateLimit.GetValueOnGameThread();
+	if (RateLimit <= 0.f || !IsValid(Connection) || CommandCount <= 0)
+	{
+		return CommandCount;
+	}
+
+	const double BurstSize = FMath::Max(CVarMontageCommandBurstSize.GetValueOnGameThread(), 1);
+	const double CurrentTime = GetWorld()->GetRealTimeSeconds();
+
+	const TObjectKey<UNetConnection> ConnectionKey(Connection);
+	FMontageCommandBudget* Budget = MontageCommandBudgets.Find(ConnectionKey);
+	if (Budget == nullptr)
+	{
+		// New connections are a good moment to drop the ones that are gone.
+		for (auto It(MontageCommandBudgets.CreateIterator()); It; ++It)
+		{
+			if (It.Key().ResolveObjectPtr() == nullptr)
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		Budget = &MontageCommandBudgets.Add(ConnectionKey);
+		Budget->Tokens = BurstSize;
+		Budget->LastRefillTime = CurrentTime;
+	}
+
+	Budget->Tokens = FMath::Min(Budget->Tokens + (CurrentTime - Budget->LastRefillTime) * RateLimit, BurstSize);
+	Budget->LastRefillTime = CurrentTime;
+
+	const int32 AllowedCount = FMath::Min(CommandCount, FMath::FloorToInt32(Budget->Tokens));
+	Budget->Tokens -= AllowedCount;
+
+	if (AllowedCount < CommandCount)
+	{
+		INC_DWORD_STAT_BY(STAT_NinjaGAS_MontageCommandsRateLimited, CommandCount - AllowedCount);
+		UE_LOG(LogNinjaGAS, Verbose, TEXT("Montage commands from %s were rate limited: %d received, %d applied."),
+			*Connection->GetName(), CommandCount, AllowedCount);
+	}
+	
+	return AllowedCount;
+}
+
+void UNinjaGASMontageReplicationSubsystem::HandlePostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		Flush();
+	}
+}
@@ -1,19 +1,299 @@
-// Copyright (c) Ninja Bear Studio Inc.
+﻿// Copyright (c) Ninja Bear Studio Inc.
 #include "Types/FAbilityMontageReplication.h"
 
+#include "NinjaGASStats.h"
 #include "AbilitySystem/NinjaGASAbilitySystemComponent.h"
+#include "Engine/PackageMapClient.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Updates Serialized"), STAT_NinjaGAS_MontageUpdatesSerialized, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Blend Settings Serialized"), STAT_NinjaGAS_MontageBlendSettingsSerialized, STATGROUP_NinjaGAS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Montage Updates Reduced"), STAT_NinjaGAS_MontageUpdatesReduced, STATGROUP_NinjaGAS);
+
+static TAutoConsoleVariable<int32> CVarMontagePositionDecimals(
+	TEXT("NinjaGAS.MontageReplication.PositionDecimals"),
+	3,
+	TEXT("Decimal places kept when replicating montage positions and blend times, from 0 to 7.")
+);
+
+static TAutoConsoleVariable<bool> CVarMontageReplicationLOD(
+	TEXT("NinjaGAS.MontageReplication.LOD"),
+	true,
+	TEXT("When enabled, montage data for additional meshes is replicated with the fidelity chosen by each component for each connection.")
+);
+
+static TAutoConsoleVariable<int32> CVarMontagePlayRateDecimals(
+	TEXT("NinjaGAS.MontageReplication.PlayRateDecimals"),
+	2,
+	TEXT("Decimal places kept when replicating montage play rates, from 0 to 7.")
+);
+
+namespace NinjaGAS::MontageReplication
+{
+	/** Fields in the change mask. Fields not in the mask have their default values. */
+	enum EFieldMask : uint16
+	{
+		Field_Animation					= 1 << 0,
+		Field_PlayRate					= 1 << 1,
+		Field_Position					= 1 << 2,
+		Field_BlendTime					= 1 << 3,
+		Field_NextSectionID				= 1 << 4,
+		Field_IsStopped					= 1 << 5,
+		Field_SkipPositionCorrection	= 1 << 6,
+		Field_SkipPlayRate				= 1 << 7,
+		Field_BlendIn					= 1 << 8,
+		Field_MontageRegistryIndex		= 1 << 9,
+		Field_ServerTimestamp			= 1 << 10,
+		Field_ReducedFidelity			= 1 << 11,
+		Field_BlendInKept				= 1 << 12,
+	};
+
+	static constexpr uint32 FieldMaskBits = 13;
+	
+	/** Decimal places kept for positions replicated with reduced fidelity, which only need to identify sections. */
+	static constexpr int32 ReducedPositionDecimals = 2;
+	static constexpr uint8 MaxDecimals = 7;
+	static constexpr uint32 DecimalsBits = 3;
+
+	/** Fidelity for the connection being written, so entries are serialized for it without being modified. */
+	static EMontageReplicationLOD WritingLOD = EMontageReplicationLOD::Full;
+
+	/** Entries whose blend settings were already written to the connection being written, for the current instance. */
+	static const TSet<const FPlayTagGameplayAbilityRepAnimMontage*>* WrittenBlendIns = nullptr;
+
+	/**
+	 * Serializes a float as a packed integer, keeping a number of decimal places.
+	 * Decimals are sent along with the value, so peers with different settings can still read it.
+	 */
+	static void SerializeQuantized(FArchive& Ar, float& Value, const int32 ConfiguredDecimals)
+	{
+		uint8 Decimals = static_cast<uint8>(FMath::Clamp(ConfiguredDecimals, 0, static_cast<int32>(MaxDecimals)));
+		Ar.SerializeBits(&Decimals, DecimalsBits);
+		
+		const double Scale = FMath::Pow(10., static_cast<double>(Decimals));
+		if (Ar.IsSaving())
+		{
+			const double Scaled = FMath::Clamp(FMath::RoundHalfFromZero(Value * Scale), static_cast<double>(MIN_int32), static_cast<double>(MAX_int32));
+			const int32 Quantized = static_cast<int32>(Scaled);
+
+			// Zig-zag encoding keeps small negative values small.
+			uint32 Packed = (static_cast<uint32>(Quantized) << 1) ^ static_cast<uint32>(Quantized >> 31);
+			Ar.SerializeIntPacked(Packed);
+		}
+		else
+		{
+			uint32 Packed = 0;
+			Ar.SerializeIntPacked(Packed);
+
+			const int32 Quantized = static_cast<int32>(Packed >> 1) ^ -static_cast<int32>(Packed & 1);
+			Value = static_cast<float>(Quantized / Scale);
+		}
+	}
+}
 
 bool FPlayTagGameplayAbilityRepAnimMontage::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
 {
-	FGameplayAbilityRepAnimMontage::NetSerialize(Ar, Map, bOutSuccess);
+	using namespace NinjaGAS::MontageReplication;
+
+	// Only fields used by mesh-aware montage replication are serialized, so the base serializer is not called.
+	uint16 FieldMask = 0;
+	if (Ar.IsSaving())
+	{
+		const bool bWriteReduced = WritingLOD == EMontageReplicationLOD::Reduced;
+		const bool bBlendInKept = bOverrideBlendIn && WrittenBlendIns && WrittenBlendIns->Contains(this);
+		FieldMask |= MontageRegistryIndex != 0 ? Field_MontageRegistryIndex : 0;
+		FieldMask |= MontageRegistryIndex == 0 && Animation != nullptr ? Field_Animation : 0;
+		FieldMask |= !bSkipPlayRate && PlayRate != 1.f ? Field_PlayRate : 0;
+		FieldMask |= Position != 0.f ? Field_Position : 0;
+		FieldMask |= BlendTime != 0.f ? Field_BlendTime : 0;
+		FieldMask |= NextSectionID != 0 ? Field_NextSectionID : 0;
+		FieldMask |= IsStopped ? Field_IsStopped : 0;
+		FieldMask |= SkipPositionCorrection ? Field_SkipPositionCorrection : 0;
+		FieldMask |= bSkipPlayRate ? Field_SkipPlayRate : 0;
+		FieldMask |= bOverrideBlendIn && !bBlendInKept ? Field_BlendIn : 0;
+		FieldMask |= bBlendInKept ? Field_BlendInKept : 0;
+		FieldMask |= bHasServerTimestamp && !IsStopped && !bWriteReduced ? Field_ServerTimestamp : 0;
+		FieldMask |= bWriteReduced ? Field_ReducedFidelity : 0;
+	}
+
+	Ar.SerializeBits(&FieldMask, FieldMaskBits);
+	const bool bReduced = (FieldMask & Field_ReducedFidelity) != 0;
+
+	if (Ar.IsLoading())
+	{
+		// Connections may skip updates, so blend settings are reset unless this one carries or keeps them.
+		Animation = nullptr;
+		MontageRegistryIndex = 0;
+		PlayRate = 1.f;
+		Position = 0.f;
+		BlendTime = 0.f;
+		NextSectionID = 0;
+		IsStopped = (FieldMask & Field_IsStopped) != 0;
+		SkipPositionCorrection = (FieldMask & Field_SkipPositionCorrection) != 0;
+		bSkipPlayRate = (FieldMask & Field_SkipPlayRate) != 0;
+		bHasServerTimestamp = (FieldMask & Field_ServerTimestamp) != 0;
+		bReducedFidelity = bReduced;
+		bOverrideBlendIn = (FieldMask & (Field_BlendIn | Field_BlendInKept)) != 0;
+		ServerTimestamp = 0;
+
+		if (!bOverrideBlendIn)
+		{
+			BlendInOverride = FMontageBlendSettings();
+		}
+	}
+
+	if (FieldMask & Field_Animation)
+	{
+		Ar << Animation;
+	}
+
+	if (FieldMask & Field_MontageRegistryIndex)
+	{
+		// Resolved by the Ability System Component once the entry is received.
+		uint32 PackedIndex = MontageRegistryIndex;
+		Ar.SerializeIntPacked(PackedIndex);
+		MontageRegistryIndex = static_cast<uint16>(PackedIndex);
+	}
+
+	if (FieldMask & Field_PlayRate)
+	{
+		SerializeQuantized(Ar, PlayRate, CVarMontagePlayRateDecimals.GetValueOnAnyThread());
+	}
 
-	Ar << bOverrideBlendIn;
-	Ar << BlendInOverride.Blend.BlendTime;
-	Ar << BlendInOverride.Blend.BlendOption;
-	Ar << BlendInOverride.Blend.CustomCurve;
-	Ar << BlendInOverride.BlendMode;
-	Ar << BlendInOverride.BlendProfile;
+	if (FieldMask & Field_Position)
+	{
+		const int32 PositionDecimals = CVarMontagePositionDecimals.GetValueOnAnyThread();
+		SerializeQuantized(Ar, Position, bReduced ? FMath::Min(PositionDecimals, ReducedPositionDecimals) : PositionDecimals);
+	}
+
+	if (FieldMask & Field_BlendTime)
+	{
+		SerializeQuantized(Ar, BlendTime, CVarMontagePositionDecimals.GetValueOnAnyThread());
+	}
+
+	if (FieldMask & Field_NextSectionID)
+	{
+		Ar << NextSectionID;
+	}
+
+	if (FieldMask & Field_ServerTimestamp)
+	{
+		Ar << ServerTimestamp;
+	}
+
+	if (FieldMask & Field_BlendIn)
+	{
+		Ar << BlendInOverride.Blend.BlendTime;
+		Ar << BlendInOverride.Blend.BlendOption;
+		Ar << BlendInOverride.Blend.CustomCurve;
+		Ar << BlendInOverride.BlendMode;
+		Ar << BlendInOverride.BlendProfile;
+		
+		INC_DWORD_STAT(STAT_NinjaGAS_MontageBlendSettingsSerialized);
+	}
+
+	INC_DWORD_STAT(STAT_NinjaGAS_MontageUpdatesSerialized);
+	INC_DWORD_STAT_BY(STAT_NinjaGAS_MontageUpdatesReduced, bReduced && Ar.IsSaving() ? 1 : 0);
 	
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool FNinjaRepMeshReference::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 bUsesRegistry = RegistryIndex != 0;
+	Ar.SerializeBits(&bUsesRegistry, 1);
+
+	if (bUsesRegistry)
+	{
+		Ar << RegistryIndex;
+		if (Ar.IsLoading())
+		{
+			// Resolved by the Ability System Component once the entry is received.
+			Mesh = nullptr;
+		}
+	}
+	else
+	{
+		Ar << Mesh;
+		if (Ar.IsLoading())
+		{
+			RegistryIndex = 0;
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool FNinjaMontageCommand::Supersedes(const FNinjaMontageCommand& Other) const
+{
+	if (Type != Other.Type || MeshReference.Mesh != Other.MeshReference.Mesh || Montage != Other.Montage)
+	{
+		return false;
+	}
+
+	// Only the latest next section matters for the section being changed.
+	return Type != ENinjaMontageCommandType::SetNextSection || SectionName == Other.SectionName;
+}
+
+bool FNinjaMontageCommand::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	using namespace NinjaGAS::MontageReplication;
+
+	uint8 RepType = static_cast<uint8>(Type);
+	Ar.SerializeBits(&RepType, 2);
+	Type = static_cast<ENinjaMontageCommandType>(RepType);
+
+	bool bMeshSuccess = true;
+	MeshReference.NetSerialize(Ar, Map, bMeshSuccess);
+
+	uint8 bUsesRegistry = MontageRegistryIndex != 0;
+	Ar.SerializeBits(&bUsesRegistry, 1);
+
+	if (bUsesRegistry)
+	{
+		// Resolved by the Ability System Component once the command is received.
+		uint32 PackedIndex = MontageRegistryIndex;
+		Ar.SerializeIntPacked(PackedIndex);
+		MontageRegistryIndex = static_cast<uint16>(PackedIndex);
+		
+		if (Ar.IsLoading())
+		{
+			Montage = nullptr;
+		}
+	}
+	else
+	{
+		Ar << Montage;
+		if (Ar.IsLoading())
+		{
+			MontageRegistryIndex = 0;
+		}
+	}
+
+	switch (Type)
+	{
+		case ENinjaMontageCommandType::JumpToSection:
+			Ar << SectionName;
+			break;
+
+		case ENinjaMontageCommandType::SetNextSection:
+			Ar << SectionName;
+			Ar << NextSectionName;
+			SerializeQuantized(Ar, Position, CVarMontagePositionDecimals.GetValueOnAnyThread());
+			break;
+
+		case ENinjaMontageCommandType::SetPlayRate:
+			SerializeQuantized(Ar, PlayRate, CVarMontagePlayRateDecimals.GetValueOnAnyThread());
+			break;
+
+		default:
+			Ar.SetError();
+			break;
+	}
+
+	bOutSuccess = bMeshSuccess && !Ar.IsError();
 	return true;
 }
 
@@ -34,22 +314,81 @@ void FGameplayAbilityRepAnimMontageContainer::SetAbilitySystemComponent(UNinjaGA
 
 FGameplayAbilityRepAnimMontageForMesh& FGameplayAbilityRepAnimMontageContainer::GetGameplayAbilityRepAnimMontageForMesh(USkeletalMeshComponent* Mesh)
 {
-	for (FGameplayAbilityRepAnimMontageForMesh& Entry : Entries)
+	if (FGameplayAbilityRepAnimMontageForMesh* ExistingEntry = FindGameplayAbilityRepAnimMontageForMesh(Mesh))
 	{
-		if (Entry.Mesh == Mesh)
-		{
-			return Entry;
-		}
+		return *ExistingEntry;
 	}
 
-	FGameplayAbilityRepAnimMontageForMesh& NewEntry = Entries.AddDefaulted_GetRef();
+	// New meshes are a good moment to drop the ones destroyed with their equipment.
+	RemoveInvalidMeshes();
+	
+	const int32 NewIndex = Entries.AddDefaulted();
+	EntryIndices.Add(Mesh, NewIndex);
+	
+	FGameplayAbilityRepAnimMontageForMesh& NewEntry = Entries[NewIndex];
 	NewEntry.Mesh = Mesh;
+	NewEntry.MeshReference.Mesh = Mesh;
+	NewEntry.MeshReference.RegistryIndex = AbilitySystemComponent->GetMeshRegistryIndex(Mesh);
 	
 	AbilitySystemComponent->SynchronizeRepAnimMontageInfo(NewEntry);
 	
 	return NewEntry;
 }
 
+FGameplayAbilityRepAnimMontageForMesh* FGameplayAbilityRepAnimMontageContainer::FindGameplayAbilityRepAnimMontageForMesh(const USkeletalMeshComponent* Mesh)
+{
+	const int32 Index = FindEntryIndex(Mesh);
+	return Index != INDEX_NONE ? &Entries[Index] : nullptr;
+}
+
+int32 FGameplayAbilityRepAnimMontageContainer::RemoveInvalidMeshes()
+{
+	const int32 RemovedCount = Entries.RemoveAll([](const FGameplayAbilityRepAnimMontageForMesh& Entry)
+	{
+		return !IsValid(Entry.Mesh);
+	});
+
+	if (RemovedCount > 0)
+	{
+		RebuildEntryIndices();
+		MarkArrayDirty();
+	}
+
+	return RemovedCount;
+}
+
+int32 FGameplayAbilityRepAnimMontageContainer::FindEntryIndex(const USkeletalMeshComponent* Mesh)
+{
+	const TObjectKey<USkeletalMeshComponent> Key(Mesh);
+	if (const int32* Index = EntryIndices.Find(Key))
+	{
+		if (Entries.IsValidIndex(*Index) && Entries[*Index].Mesh == Mesh)
+		{
+			return *Index;
+		}
+	}
+	else if (EntryIndices.Num() == Entries.Num())
+	{
+		// All entries are indexed, so this mesh is not in the container.
+		return INDEX_NONE;
+	}
+
+	// Entries may have been added, removed or reordered by replication.
+	RebuildEntryIndices();
+	
+	const int32* Index = EntryIndices.Find(Key);
+	return Index ? *Index : INDEX_NONE;
+}
+
+void FGameplayAbilityRepAnimMontageContainer::RebuildEntryIndices()
+{
+	EntryIndices.Reset();
+	for (int32 Idx = 0; Idx < Entries.Num(); ++Idx)
+	{
+		EntryIndices.Add(Entries[Idx].Mesh, Idx);
+	}
+}
+
 void FGameplayAbilityRepAnimMontageContainer::MarkMontageDirty(FGameplayAbilityRepAnimMontageForMesh& Entry)
 {
 	Entry.UpdateReplicationID();
@@ -58,8 +397,11 @@ void FGameplayAbilityRepAnimMontageContainer::MarkMontageDirty(FGameplayAbilityR
 
 void FGameplayAbilityRepAnimMontageContainer::PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize)
 {
+	EntryIndices.Reset();
+	
 	for (const int32 Idx : AddedIndices)
 	{
+		AbilitySystemComponent->ResolveMontageRegistryReferences(Entries[Idx]);
 		AbilitySystemComponent->PostAnimationEntryChange(Entries[Idx]);
 		Entries[Idx].LastAnimationReplicationId = Entries[Idx].AnimationReplicationId; 
 	}
@@ -67,14 +409,98 @@ void FGameplayAbilityRepAnimMontageContainer::PostReplicatedAdd(const TArrayView
 
 void FGameplayAbilityRepAnimMontageContainer::PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize)
 {
+	// Meshes are resolved again, so they may not match the current indices.
+	EntryIndices.Reset();
+	
 	for (const int32 Idx : ChangedIndices)
 	{
+		AbilitySystemComponent->ResolveMontageRegistryReferences(Entries[Idx]);
 		AbilitySystemComponent->PostAnimationEntryChange(Entries[Idx]);
 		Entries[Idx].LastAnimationReplicationId = Entries[Idx].AnimationReplicationId;
 	}	
 }
 
+void FGameplayAbilityRepAnimMontageContainer::PostReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize)
+{
+	// Indices are rebuilt on the next lookup, once the removal is done.
+	EntryIndices.Reset();
+}
+
 bool FGameplayAbilityRepAnimMontageContainer::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams)
 {
-	return FastArrayDeltaSerialize<FGameplayAbilityRepAnimMontageForMesh, FGameplayAbilityRepAnimMontageContainer>(Entries, DeltaParams, *this);	
+	using namespace NinjaGAS::MontageReplication;
+	
+	if (DeltaParams.Writer == nullptr)
+	{
+		return FastArrayDeltaSerialize<FGameplayAbilityRepAnimMontageForMesh, FGameplayAbilityRepAnimMontageContainer>(Entries, DeltaParams, *this);
+	}
+
+	const UPackageMapClient* PackageMap = Cast<UPackageMapClient>(DeltaParams.Map);
+	const UNetConnection* Connection = PackageMap ? PackageMap->GetConnection() : nullptr;
+	const EMontageReplicationLOD ReplicationLOD = GetReplicationLOD(Connection);
+	TSet<const FPlayTagGameplayAbilityRepAnimMontage*> ConnectionBlendIns;
+
+	if (IsValid(Connection))
+	{
+		const TObjectKey<UNetConnection> ConnectionKey(Connection);
+		if (const FConnectionState* PreviousState = ConnectionStates.Find(ConnectionKey))
+		{
+			if (PreviousState->LOD != ReplicationLOD)
+			{
+				// Deltas only carry entries that changed, so a connection changing fidelity would keep the
+				// entries it received before. Without a base state, every entry is written again for it.
+				DeltaParams.OldState = nullptr;
+			}
+		}
+		else
+		{
+			// New connections are a good moment to drop the ones that are gone.
+			for (auto It(ConnectionStates.CreateIterator()); It; ++It)
+			{
+				if (It.Key().ResolveObjectPtr() == nullptr)
+				{
+					It.RemoveCurrent();
+				}
+			}
+		}
+
+		FConnectionState& State = ConnectionStates.FindOrAdd(ConnectionKey);
+		State.LOD = ReplicationLOD;
+
+		// Blend settings only matter when an instance starts, so they are written once for each instance.
+		// Entries written with a new montage or instance carry them, while the others only keep them.
+		TMap<int32, FBlendInInstance> BlendInInstances;
+		for (const FGameplayAbilityRepAnimMontageForMesh& Entry : Entries)
+		{
+			if (!Entry.RepMontageInfo.bOverrideBlendIn || Entry.ReplicationID == INDEX_NONE)
+			{
+				continue;
+			}
+
+			const FBlendInInstance Instance(Entry.RepMontageInfo.Animation, Entry.RepMontageInfo.MontageInstanceId);
+			const FBlendInInstance* WrittenInstance = State.BlendInInstances.Find(Entry.ReplicationID);
+			if (WrittenInstance && *WrittenInstance == Instance)
+			{
+				ConnectionBlendIns.Add(&Entry.RepMontageInfo);
+			}
+
+			BlendInInstances.Add(Entry.ReplicationID, Instance);
+		}
+
+		State.BlendInInstances = MoveTemp(BlendInInstances);
+	}
+
+	TGuardValue<EMontageReplicationLOD> WritingLODGuard(WritingLOD, ReplicationLOD);
+	TGuardValue<const TSet<const FPlayTagGameplayAbilityRepAnimMontage*>*> WrittenBlendInsGuard(WrittenBlendIns, &ConnectionBlendIns);
+	return FastArrayDeltaSerialize<FGameplayAbilityRepAnimMontageForMesh, FGameplayAbilityRepAnimMontageContainer>(Entries, DeltaParams, *this);
+}
+
+EMontageReplicationLOD FGameplayAbilityRepAnimMontageContainer::GetReplicationLOD(const UNetConnection* Connection) const
+{
+	if (!IsValid(AbilitySystemComponent) || !CVarMontageReplicationLOD.GetValueOnGameThread())
+	{
+		return EMontageReplicationLOD::Full;
+	}
+
+	return AbilitySystemComponent->GetMontageReplicationLOD(Connection);
 }
@@ -0,0 +1,91 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#include "Types/FNinjaAbilityGrantPlan.h"
+
+#include "AttributeSet.h"
+#include "GameplayEffect.h"
+#include "NinjaGASLog.h"
+#include "Abilities/GameplayAbility.h"
+#include "Data/NinjaGASDataAsset.h"
+#include "Types/FNinjaAbilityDefaultHandles.h"
+
+TSharedRef<const FNinjaAbilityGrantPlan> FNinjaAbilityGrantPlan::Compile(const UNinjaGASDataAsset* AbilityData)
+{
+	TSharedRef<FNinjaAbilityGrantPlan> Plan = MakeShared<FNinjaAbilityGrantPlan>();
+	if (!IsValid(AbilityData))
+	{
+		return Plan;
+	}
+
+	Plan->SourceData = AbilityData;
+	Plan->InitialGameplayTags = AbilityData->InitialGameplayTags;
+
+	Plan->AttributeSets.Reserve(AbilityData->DefaultAttributeSets.Num());
+	for (const FDefaultAttributeSet& Entry : AbilityData->DefaultAttributeSets)
+	{
+		if (!IsValid(Entry.AttributeSetClass))
+		{
+			UE_LOG(LogNinjaGAS, Warning, TEXT("Attribute Set Entry in %s is missing a valid Attribute Set class!"), *GetNameSafe(AbilityData));
+			continue;
+		}
+
+		FAttributeSetEntry& NewEntry = Plan->AttributeSets.AddDefaulted_GetRef();
+		NewEntry.AttributeSetClass = Entry.AttributeSetClass;
+		NewEntry.AttributeTable = Entry.AttributeTable;
+		NewEntry.ScopeMask = (Entry.AppliesOnServer() ? ServerScope : 0) | (Entry.AppliesOnClient() ? ClientScope : 0);
+		NewEntry.bPermanent = Entry.IsPermanent();
+
+		for (int32 AuthIdx = 0; AuthIdx < 2; ++AuthIdx)
+		{
+			if (AppliesTo(NewEntry, AuthIdx == 1))
+			{
+				int32* Counts = NewEntry.bPermanent ? Plan->PermanentAttributeSetCount : Plan->TemporaryAttributeSetCount;
+				++Counts[AuthIdx];
+			}
+		}
+	}
+
+	Plan->GameplayEffects.Reserve(AbilityData->DefaultGameplayEffects.Num());
+	for (const FDefaultGameplayEffect& Entry : AbilityData->DefaultGameplayEffects)
+	{
+		if (!IsValid(Entry.GameplayEffectClass))
+		{
+			UE_LOG(LogNinjaGAS, Warning, TEXT("Gameplay Effect Entry in %s is missing a valid Gameplay Effect class!"), *GetNameSafe(AbilityData));
+			continue;
+		}
+
+		FGameplayEffectEntry& NewEntry = Plan->GameplayEffects.AddDefaulted_GetRef();
+		NewEntry.GameplayEffectClass = Entry.GameplayEffectClass;
+		NewEntry.GameplayEffectDefinition = Entry.GameplayEffectClass->GetDefaultObject<UGameplayEffect>();
+		NewEntry.Level = Entry.Level;
+	}
+
+	Plan->AbilitySpecTemplates.Reserve(AbilityData->DefaultGameplayAbilities.Num());
+	for (const FDefaultGameplayAbility& Entry : AbilityData->DefaultGameplayAbilities)
+	{
+		if (!IsValid(Entry.GameplayAbilityClass))
+		{
+			UE_LOG(LogNinjaGAS, Warning, TEXT("Gameplay Ability Entry in %s is missing a valid Gameplay Ability class!"), *GetNameSafe(AbilityData));
+			continue;
+		}
+
+		Plan->AbilitySpecTemplates.Emplace(Entry.GameplayAbilityClass, Entry.Level, Entry.Input);
+	}
+
+	UE_LOG(LogNinjaGAS, Verbose, TEXT("Compiled grant plan for %s: [ Attribute Sets: %d, Effects: %d, Abilities: %d ]."),
+		*GetNameSafe(AbilityData), Plan->AttributeSets.Num(), Plan->GameplayEffects.Num(), Plan->AbilitySpecTemplates.Num());
+
+	return Plan;
+}
+
+void FNinjaAbilityGrantPlan::ReserveHandles(FAbilityDefaultHandles& Handles, const bool bIsAuth) const
+{
+	const int32 AuthIdx = bIsAuth ? 1 : 0;
+	Handles.PermanentAttributes.Reserve(Handles.PermanentAttributes.Num() + PermanentAttributeSetCount[AuthIdx]);
+	Handles.TemporaryAttributes.Reserve(Handles.TemporaryAttributes.Num() + TemporaryAttributeSetCount[AuthIdx]);
+
+	if (bIsAuth)
+	{
+		Handles.DefaultEffectHandles.Reserve(Handles.DefaultEffectHandles.Num() + GameplayEffects.Num());
+		Handles.DefaultAbilityHandles.Reserve(Handles.DefaultAbilityHandles.Num() + AbilitySpecTemplates.Num());
+	}
+}
@@ -0,0 +1,115 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#include "Types/FNinjaAttributeTableLayout.h"
+
+#include "AttributeSet.h"
+#include "Engine/DataTable.h"
+#include "UObject/UnrealType.h"
+
+TSharedRef<const FNinjaAttributeTableLayout> FNinjaAttributeTableLayout::Build(const UClass* AttributeSetClass, const UDataTable* AttributeTable)
+{
+	TSharedRef<FNinjaAttributeTableLayout> Layout = MakeShared<FNinjaAttributeTableLayout>();
+	if (!IsValid(AttributeSetClass))
+	{
+		return Layout;
+	}
+
+	static const FString Context = FString(TEXT("FNinjaAttributeTableLayout::Build"));
+	const bool bUsesClassDefaults = !IsValid(AttributeTable);
+	const UObject* ClassDefaults = AttributeSetClass->GetDefaultObject();
+
+	for (TFieldIterator<FProperty> It(AttributeSetClass, EFieldIteratorFlags::IncludeSuper); It; ++It)
+	{
+		const FProperty* Property = *It;
+		const FNumericProperty* NumericProperty = CastField<FNumericProperty>(Property);
+		const bool bIsAttributeData = !NumericProperty && FGameplayAttribute::IsGameplayAttributeDataProperty(Property);
+
+		if (!NumericProperty && !bIsAttributeData)
+		{
+			continue;
+		}
+
+		if (bUsesClassDefaults)
+		{
+			if (NumericProperty)
+			{
+				// Integer and enum values are copied as they are, since only floating points can be read as floats.
+				FNumericEntry& Entry = Layout->NumericValues.AddDefaulted_GetRef();
+				Entry.Property = NumericProperty;
+				if (NumericProperty->IsFloatingPoint())
+				{
+					Entry.Value = NumericProperty->GetFloatingPointPropertyValue(NumericProperty->ContainerPtrToValuePtr<void>(ClassDefaults));
+				}
+				else
+				{
+					Entry.DefaultValue = NumericProperty->ContainerPtrToValuePtr<void>(ClassDefaults);
+				}
+			}
+			else
+			{
+				const FGameplayAttributeData* DefaultData = Property->ContainerPtrToValuePtr<FGameplayAttributeData>(ClassDefaults);
+				FAttributeDataEntry& Entry = Layout->AttributeData.AddDefaulted_GetRef();
+				Entry.Offset = Property->GetOffset_ForInternal();
+				Entry.BaseValue = DefaultData->GetBaseValue();
+				Entry.CurrentValue = DefaultData->GetCurrentValue();
+			}
+
+			continue;
+		}
+		
+		// Same row naming used by the engine: "OwnerClass.PropertyName".
+		const FString RowName = FString::Printf(TEXT("%s.%s"), *Property->GetOwnerStruct()->GetName(), *Property->GetName());
+		const FAttributeMetaData* MetaData = AttributeTable->FindRow<FAttributeMetaData>(FName(*RowName), Context, false);
+		if (MetaData == nullptr)
+		{
+			continue;
+		}
+
+		if (NumericProperty)
+		{
+			FNumericEntry& Entry = Layout->NumericValues.AddDefaulted_GetRef();
+			Entry.Property = NumericProperty;
+			Entry.Value = MetaData->BaseValue;
+		}
+		else
+		{
+			FAttributeDataEntry& Entry = Layout->AttributeData.AddDefaulted_GetRef();
+			Entry.Offset = Property->GetOffset_ForInternal();
+			Entry.BaseValue = MetaData->BaseValue;
+			Entry.CurrentValue = MetaData->BaseValue;
+		}
+	}
+
+	Layout->AttributeData.Shrink();
+	Layout->NumericValues.Shrink();
+	return Layout;
+}
+
+void FNinjaAttributeTableLayout::Apply(UAttributeSet* AttributeSet) const
+{
+	check(IsValid(AttributeSet));
+	uint8* Container = reinterpret_cast<uint8*>(AttributeSet);
+
+	for (const FAttributeDataEntry& Entry : AttributeData)
+	{
+		FGameplayAttributeData* Data = reinterpret_cast<FGameplayAttributeData*>(Container + Entry.Offset);
+		Data->SetBaseValue(Entry.BaseValue);
+		Data->SetCurrentValue(Entry.CurrentValue);
+	}
+
+	for (const FNumericEntry& Entry : NumericValues)
+	{
+		void* Data = Entry.Property->ContainerPtrToValuePtr<void>(AttributeSet);
+		if (Entry.Property->IsFloatingPoint())
+		{
+			Entry.Property->SetFloatingPointPropertyValue(Data, Entry.Value);
+		}
+		else if (Entry.DefaultValue != nullptr)
+		{
+			Entry.Property->CopyCompleteValue(Data, Entry.DefaultValue);
+		}
+		else
+		{
+			Entry.Property->SetIntPropertyValue(Data, static_cast<int64>(Entry.Value));
+		}
+	}
+}
@@ -67,8 +67,11 @@ protected:
 
 	/**
 	 * Retrieves the Ability System Component from the AI Controller in the context. 
+	 *
+	 * @param Context				State Tree context providing the AI Controller.
+	 * @param bInitializeIfNeeded	Initializes lazy Ability System Components that are not available yet.
 	 */
-	static UAbilitySystemComponent* GetAbilitySystemComponent(const FStateTreeExecutionContext& Context);
+	static UAbilitySystemComponent* GetAbilitySystemComponent(const FStateTreeExecutionContext& Context, bool bInitializeIfNeeded = true);
 	
 	/**
 	 * Check for incoming data, to make sure it can be processed.
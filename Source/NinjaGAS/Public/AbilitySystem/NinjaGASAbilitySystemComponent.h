@@ -11,16 +11,28 @@
 
 #include "CoreMinimal.h"
 #include "AbilitySystemComponent.h"
+#include "GameplayEffectAggregator.h"
 #include "Animation/AnimMontage.h"
 #include "Interfaces/AbilitySystemDefaultsInterface.h"
 #include "Runtime/Launch/Resources/Version.h"
+#include "Types/EMontageReplicationLOD.h"
+#include "Types/EMontageReplicationUpdateMode.h"
 #include "Types/FNinjaAbilityDefaultHandles.h"
 #include "Types/FNinjaAbilityDefaults.h"
+#include "Types/FNinjaIdleAttributeBaseline.h"
+#include "Types/FNinjaPooledAttributeSets.h"
 #include "Types/FAbilityMontageReplication.h"
+#include "Types/FPendingAttributeReplication.h"
 #include "NinjaGASAbilitySystemComponent.generated.h"
 
 class UNinjaGASDataAsset;
+class UNinjaGASInitializationSubsystem;
+class UNinjaGASMontageReplicationSubsystem;
 class UAnimMontage;
+class UNetConnection;
+class UAnimNotifyState;
+struct FNinjaAbilityGrantPlan;
+struct FStreamableHandle;
 class USkeletalMeshComponent;
 
 /**
@@ -45,7 +57,13 @@ class NINJAGAS_API UNinjaGASAbilitySystemComponent : public UAbilitySystemCompon
 {
 
 	DECLARE_MULTICAST_DELEGATE_OneParam(FNinjaAbilityGivenDelegate, const FGameplayAbilitySpec&);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FNinjaAbilitiesGivenDelegate, const TArray<FGameplayAbilitySpecHandle>&);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FNinjaDefaultsReadyDelegate, const UNinjaGASDataAsset*);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FNinjaPendingAttributesAppliedDelegate, TConstArrayView<FPendingAttributeReplication>);
+	DECLARE_MULTICAST_DELEGATE(FNinjaAbilitySystemInitializedDelegate);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE(FAbilitySystemInitializedSignature);
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FAbilitySystemAvatarChangedSignature, AActor*, NewAvatar);
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FAbilitySystemDefaultsReadySignature, const UNinjaGASDataAsset*, AbilityData);
 	
 	GENERATED_BODY()
 
@@ -54,6 +72,14 @@ public:
 	/** Broadcasts a changed in the Avatar. */
 	UPROPERTY(BlueprintAssignable)
 	FAbilitySystemAvatarChangedSignature OnAbilitySystemAvatarChanged;
+
+	/** Broadcasts when defaults from a data asset have been granted, including the ones loaded asynchronously. */
+	UPROPERTY(BlueprintAssignable)
+	FAbilitySystemDefaultsReadySignature OnAbilitySystemDefaultsReady;
+
+	/** Broadcasts when the actor info and all defaults have been initialized, including scheduled and loaded ones. */
+	UPROPERTY(BlueprintAssignable)
+	FAbilitySystemInitializedSignature OnAbilitySystemInitialized;
 	
 	UNinjaGASAbilitySystemComponent();
 
@@ -71,9 +97,39 @@ public:
 
 	// -- Begin Ability System Defaults implementation
 	virtual const UNinjaGASDataAsset* GetAbilityData() const override;
+	virtual TSoftObjectPtr<UNinjaGASDataAsset> GetSoftAbilityData() const override;
 	// -- End Ability System Defaults implementation
 
 	FNinjaAbilityGivenDelegate& OnAbilityGiven() { return AbilityGivenDelegate; }
+
+	/** Broadcasts when defaults from a data asset have been granted. */
+	FNinjaDefaultsReadyDelegate& OnDefaultsReady() { return DefaultsReadyDelegate; }
+
+	/** Informs if defaults for the owner or avatar are still being loaded asynchronously. */
+	UFUNCTION(BlueprintPure, Category = "NBS|GAS|Ability System")
+	bool AreDefaultsLoading() const;
+
+	/** Broadcasts when the actor info and all defaults have been initialized. */
+	FNinjaAbilitySystemInitializedDelegate& OnInitialized() { return AbilitySystemInitializedDelegate; }
+	
+	/**
+	 * Informs if the actor info and all defaults have been initialized.
+	 * Scheduled or asynchronous initialization may finish a few frames after the actor info is set.
+	 */
+	UFUNCTION(BlueprintPure, Category = "NBS|GAS|Ability System")
+	bool IsAbilitySystemInitialized() const { return bAbilitySystemInitialized; }
+
+	/**
+	 * Broadcasts abilities granted on this ASC.
+	 * Abilities granted in bulk are broadcast together, once the bulk update finishes.
+	 */
+	FNinjaAbilitiesGivenDelegate& OnAbilitiesGiven() { return AbilitiesGivenDelegate; }
+
+	/**
+	 * Broadcasts once all attributes pending replication have been set, with every applied value.
+	 * Listeners reacting to many attributes can use this instead of each attribute change delegate.
+	 */
+	FNinjaPendingAttributesAppliedDelegate& OnPendingAttributesApplied() { return PendingAttributesAppliedDelegate; }
 	
 	/**
 	 * Obtains the Anim Instance from the Actor Info.
@@ -105,6 +161,28 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "NBS|GAS|Ability System")
 	FGameplayAbilitySpecHandle GiveAbilityFromClass(const TSubclassOf<UGameplayAbility> AbilityClass, int32 Level = 1, int32 Input = -1);
 
+	/**
+	 * Grants multiple abilities in a single bulk update.
+	 *
+	 * Individual notifications and logs are deferred, so listeners are notified once with all
+	 * the granted handles. Each spec must have its own handle.
+	 *
+	 * @param AbilitySpecs		Specs for the abilities being granted.
+	 * @param OutHandles		Handles for the abilities that were granted.
+	 */
+	void GiveAbilitiesInBulk(TConstArrayView<FGameplayAbilitySpec> AbilitySpecs, TArray<FGameplayAbilitySpecHandle>& OutHandles);
+
+	/**
+	 * Removes multiple abilities while the ability list is locked, so removals are processed together.
+	 * Passive abilities are cancelled first, since they would never end otherwise.
+	 *
+	 * @param AbilityHandles	Handles for the abilities being removed.
+	 */
+	void RemoveAbilitiesInBulk(TConstArrayView<FGameplayAbilitySpecHandle> AbilityHandles);
+
+	/** Informs if effect changes are currently deferring attribute aggregation. */
+	bool IsDeferringAggregation() const { return DeferredAggregationCount > 0; }
+	
 	/**
 	 * Tries to activate the ability by the handle, aggregating all RPCs that happened in the same frame.
 	 *
@@ -161,6 +239,23 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category = "NBS|GAS|Ability System")
 	virtual void ResetAbilitySystemComponent();
+
+	/**
+	 * Requests a reset for this component.
+	 *
+	 * If the component schedules its initialization, the reset is processed by the initialization
+	 * subsystem under the frame budget. Otherwise, the component is reset immediately.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "NBS|GAS|Ability System")
+	void RequestResetAbilitySystemComponent();
+
+	/**
+	 * Resets all state, so this component can be reused by another owner.
+	 *
+	 * Besides the regular reset, removes anything granted by other sources, montage data and the
+	 * actor info. Used when the component is returned to the Component Pool Subsystem.
+	 */
+	virtual void ResetForRecycling();
 	
 	/**
 	 * Sets a base attribute value, after a deferred/lazy initialization.
@@ -177,6 +272,74 @@ public:
 	 * @param NewValue		New attribute data value to be applied.
 	 */	
 	void DeferredSetBaseAttributeValueFromReplication(const FGameplayAttribute& Attribute, const FGameplayAttributeData& NewValue);
+
+	/**
+	 * Sets base attribute values received before this component replicated.
+	 *
+	 * All base values are written first, so attribute change notifications, sent afterward for
+	 * each attribute, never observe a partially applied state. Once all of them are notified,
+	 * a single batched notification is sent through OnPendingAttributesApplied.
+	 *
+	 * Pending values only keep the latest value for each attribute, so each one is set once.
+	 *
+	 * @param PendingAttributes		Latest value received for each attribute.
+	 */
+	void DeferredSetBaseAttributeValuesFromReplication(TConstArrayView<FPendingAttributeReplication> PendingAttributes);
+
+	/**
+	 * Provides a spawned Attribute Set by its exact class, using the internal index.
+	 *
+	 * @param AttributeSetClass		Class of the Attribute Set.
+	 * @return						The spawned Attribute Set, or null if none was spawned.
+	 */
+	UAttributeSet* FindAttributeSetByClass(const TSubclassOf<UAttributeSet>& AttributeSetClass) const;
+
+	/**
+	 * Provides the spawned Attribute Set owning an attribute, using the internal index.
+	 * Sets that are subclasses of the attribute's owner class are accepted as well.
+	 *
+	 * @param Attribute				Attribute to check.
+	 * @return						The spawned Attribute Set, or null if none was spawned.
+	 */
+	UAttributeSet* FindAttributeSetForAttribute(const FGameplayAttribute& Attribute) const;
+
+	/**
+	 * Indexed equivalent of "HasAttributeSetForAttribute".
+	 *
+	 * @param Attribute				Attribute to check.
+	 * @return						True for system attributes or attributes with a spawned Attribute Set.
+	 */
+	bool IsAttributeAvailable(const FGameplayAttribute& Attribute) const;
+
+	/** Number of Attribute Sets that were reused from the pool. */
+	UFUNCTION(BlueprintPure, Category = "NBS|GAS|Ability System")
+	int32 GetAttributeSetPoolHits() const { return AttributeSetPoolHits; }
+
+	/** Number of Attribute Sets that had to be created while the pool was enabled. */
+	UFUNCTION(BlueprintPure, Category = "NBS|GAS|Ability System")
+	int32 GetAttributeSetPoolMisses() const { return AttributeSetPoolMisses; }
+
+	/**
+	 * Captures owned tags, Attribute Sets and attribute values as the idle baseline.
+	 * Meant to be called once defaults are initialized, so later changes can be detected.
+	 */
+	void CaptureIdleBaseline();
+
+	/**
+	 * Informs if this component holds no state beyond its idle baseline.
+	 *
+	 * That means no active abilities, no effects other than the defaults, the same owned tags
+	 * and Attribute Sets, and attributes modified on top of their base values just like they
+	 * were when the baseline was captured.
+	 */
+	bool IsIdle() const;
+
+	/**
+	 * Collects attributes whose base values are different from the idle baseline.
+	 *
+	 * @param OutAttributes		Attributes that changed since the baseline, with their current data.
+	 */
+	void GetNonBaselineAttributes(TArray<FPendingAttributeReplication>& OutAttributes) const;
 	
 protected:
 
@@ -189,6 +352,13 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
 	TObjectPtr<const UNinjaGASDataAsset> DefaultAbilitySetup;
 
+	/**
+	 * Default configuration for the Ability System, loaded asynchronously with its "Abilities" bundle.
+	 * Only used if the hard reference is not set. Defaults are granted once the data is loaded.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System", meta = (EditCondition = "DefaultAbilitySetup == nullptr"))
+	TSoftObjectPtr<UNinjaGASDataAsset> SoftAbilitySetup;
+
 	/**
 	 * If set to true, fully resets the ASC State when the avatar changes.
 	 *
@@ -201,6 +371,30 @@ protected:
 	 */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
 	bool bResetStateWhenAvatarChanges;
+
+	/**
+	 * If set to true, avatar changes only grant and revoke the difference between setups.
+	 *
+	 * Attribute Sets, Gameplay Effects, Gameplay Abilities and Tags shared by the previous and
+	 * new avatar setups are kept as they are, so passive abilities are not reactivated and shared
+	 * state is not replicated again. Useful for variations of the same avatar, such as mounts.
+	 * When the actor info is cleared, avatar abilities, effects and tags are revoked, while the setup
+	 * and its Attribute Sets are kept, so the next avatar is still swapped by difference.
+	 *
+	 * This has no effect when the state is fully reset when the avatar changes.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System", meta = (EditCondition = "!bResetStateWhenAvatarChanges"))
+	bool bDiffDefaultsWhenAvatarChanges;
+
+	/**
+	 * If set to true, defaults and resets are scheduled in the Initialization Subsystem.
+	 *
+	 * Scheduled components are processed under a frame budget, so many actors spawning or
+	 * resetting in the same frame do not cause a hitch. Gameplay that depends on defaults
+	 * should wait for the component to be initialized.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
+	bool bScheduleInitialization;
 	
 	/**
 	 * Determines if the ASC can batch-activate abilities.
@@ -210,9 +404,24 @@ protected:
 	 */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System", DisplayName = "Enable Ability Batch RPCs")
 	bool bEnableAbilityBatchRPC;
+
+	/**
+	 * If set to true, Attribute Sets removed from the ASC are kept in a pool.
+	 *
+	 * Pooled sets are reset to their defaults and reused by the next setup granting the same
+	 * class, avoiding new objects and subobject registrations whenever the avatar changes.
+	 * This is useful for ASCs owned by Player States, in games with frequent respawns.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
+	bool bPoolAttributeSets;
+
+	/** Maximum amount of pooled Attribute Sets kept for each class. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System", meta = (EditCondition = "bPoolAttributeSets", ClampMin = 1))
+	int32 MaxPooledAttributeSetsPerClass;
 	
 	// -- Begin Ability System Component implementation
 	virtual void OnGiveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+	virtual void OnRep_SpawnedAttributes(const TArray<UAttributeSet*>& PreviousSpawnedAttributes) override;
 	// -- End Ability System Component implementation
 	
 	/**
@@ -226,6 +435,53 @@ protected:
 	 * This will also reset previous defaults granted by a former avatar, if the avatar changes.
 	 */
 	void InitializeDefaultsFromAvatar(const AActor* NewAvatar);
+
+	/**
+	 * Initializes defaults from the owner and, if it has changed, from the avatar.
+	 * This is the part of the actor info initialization that can be scheduled.
+	 */
+	void InitializeDefaults(bool bAvatarHasChanged);
+
+	/**
+	 * Processes work scheduled in the Initialization Subsystem.
+	 *
+	 * @param bReset				The component must be reset.
+	 * @param bInitialize			Defaults must be initialized.
+	 * @param bAvatarHasChanged		Defaults from a new avatar must be initialized.
+	 */
+	void ProcessScheduledInitialization(bool bReset, bool bInitialize, bool bAvatarHasChanged);
+
+	/** Provides the Initialization Subsystem, if this component should schedule its initialization. */
+	UNinjaGASInitializationSubsystem* GetInitializationScheduler() const;
+
+	/** Marks the component as initialized, once nothing is pending. */
+	void UpdateInitializedState();
+
+	/**
+	 * Grants defaults from the avatar's data asset, replacing the ones from a former avatar.
+	 * Depending on the configuration, only the difference between both setups is granted.
+	 */
+	void ApplyAvatarDefaults(const UNinjaGASDataAsset* AbilityData);
+
+	/**
+	 * Loads a data asset and its "Abilities" bundle asynchronously, granting defaults once loaded.
+	 *
+	 * @param SoftAbilityData	Data asset that will be loaded.
+	 * @param RequestedAvatar	Avatar requesting the defaults, or null if requested by the owner.
+	 */
+	void LoadDefaultsAsync(const TSoftObjectPtr<UNinjaGASDataAsset>& SoftAbilityData, const AActor* RequestedAvatar);
+
+	/** Grants defaults from a data asset that has been asynchronously loaded. */
+	void HandleDefaultsLoaded(TSoftObjectPtr<UNinjaGASDataAsset> SoftAbilityData, TWeakObjectPtr<const AActor> RequestedAvatar);
+
+	/**
+	 * Starts loading the owner's data asset on clients, as soon as the component is initialized.
+	 * This makes sure classes in replicated specs are resident once they arrive.
+	 */
+	void PreloadDefaultsForClient();
+	
+	/** Notifies listeners that defaults from a data asset have been granted. */
+	void BroadcastDefaultsReady(const UNinjaGASDataAsset* AbilityData);
 	
 	/**
 	 * Initializes Abilities from the provided Data Asset.
@@ -237,25 +493,184 @@ protected:
 	 */
 	void InitializeAttributeSets(const TArray<FDefaultAttributeSet>& AttributeSets, FAbilityDefaultHandles& OutHandles);
 
+	/**
+	 * Initializes Attribute Sets from a compiled grant plan.
+	 */
+	void InitializeAttributeSets(const FNinjaAbilityGrantPlan& GrantPlan, FAbilityDefaultHandles& OutHandles);
+
+	/**
+	 * Instantiates and registers a single default Attribute Set.
+	 *
+	 * @param AttributeSetClass		Class of the Attribute Set to instantiate.
+	 * @param AttributeTable		Optional table with default values.
+	 * @param bPermanent			Informs if the set is kept when the avatar changes.
+	 * @param OutHandles			Handles that will track the new Attribute Set.
+	 */
+	void InitializeAttributeSet(const TSubclassOf<UAttributeSet>& AttributeSetClass, const UDataTable* AttributeTable, bool bPermanent, FAbilityDefaultHandles& OutHandles);
+	
 	/**
 	 * Initializes the Gameplay Effects provided by the interface.
 	 */
 	void InitializeGameplayEffects(const TArray<FDefaultGameplayEffect>& GameplayEffects, FAbilityDefaultHandles& OutHandles);
 
+	/**
+	 * Initializes the Gameplay Effects from a compiled grant plan.
+	 */
+	void InitializeGameplayEffects(const FNinjaAbilityGrantPlan& GrantPlan, FAbilityDefaultHandles& OutHandles);
+	
 	/**
 	 * Initializes the Gameplay Abilities provided by the interface.
 	 */
 	void InitializeGameplayAbilities(const TArray<FDefaultGameplayAbility>& GameplayAbilities, FAbilityDefaultHandles& OutHandles);
 
+	/**
+	 * Initializes the Gameplay Abilities from a compiled grant plan.
+	 */
+	void InitializeGameplayAbilities(const FNinjaAbilityGrantPlan& GrantPlan, FAbilityDefaultHandles& OutHandles);
+
+	/**
+	 * Replaces the defaults granted by a previous setup, changing only what differs between them.
+	 *
+	 * @param AbilityData		New data asset providing the defaults.
+	 * @param Handles			Handles granted by the previous data asset, updated in place.
+	 */
+	void SwapDefaultsFromData(const UNinjaGASDataAsset* AbilityData, FAbilityDefaultHandles& Handles);
+	
 	/**
 	 * Clears default abilities, effects and attribute sets.
 	 */
 	virtual void ClearDefaults(FAbilityDefaultHandles& Handles, bool bRemovePermanentAttributes = false);
 
+	/**
+	 * Revokes tags, abilities and effects granted by a setup, keeping its Attribute Sets and data asset.
+	 * Used when the avatar is removed, so defaults cannot be used until the next avatar swaps them.
+	 */
+	void SuspendDefaults(FAbilityDefaultHandles& Handles);
+
+	/**
+	 * Removes tags, abilities and effects granted by a setup, on the authority.
+	 *
+	 * @param Handles				Handles granted by the setup.
+	 * @param OutTagCount			Number of tags removed.
+	 * @param OutAbilityCount		Number of abilities removed.
+	 * @param OutEffectCount		Number of effects removed.
+	 */
+	void RevokeGrantedDefaults(FAbilityDefaultHandles& Handles, int32& OutTagCount, int32& OutAbilityCount, int32& OutEffectCount);
+
+	/**
+	 * Removes an ability granted by default, cancelling it first if it's a passive ability.
+	 */
+	void RemoveDefaultAbility(const FGameplayAbilitySpecHandle& Handle);
+
+	/**
+	 * Adds an Attribute Set to the ASC, keeping the internal index up to date.
+	 */
+	void RegisterAttributeSet(UAttributeSet* AttributeSet);
+
+	/**
+	 * Removes an Attribute Set from the ASC, keeping the internal index up to date.
+	 */
+	void UnregisterAttributeSet(UAttributeSet* AttributeSet);
+
+	/**
+	 * Provides a new Attribute Set, reusing a pooled instance when possible.
+	 */
+	UAttributeSet* AcquireAttributeSet(const TSubclassOf<UAttributeSet>& AttributeSetClass);
+
+	/**
+	 * Removes an Attribute Set from the ASC, returning it to the pool when enabled.
+	 */
+	void ReleaseAttributeSet(UAttributeSet* AttributeSet);
+	
 private:
 
+	friend struct FScopedNinjaAbilityBulkUpdate;
+	friend struct FScopedNinjaDeferredAggregation;
+	friend class UNinjaGASComponentPoolSubsystem;
+	friend class UNinjaGASInitializationSubsystem;
+	friend class UNinjaGASMontageReplicationSubsystem;
+
+	/** Informs if the actor info and defaults have been initialized. */
+	bool bAbilitySystemInitialized = false;
+
+	/** Informs if defaults are currently being initialized, so the state is only updated at the end. */
+	bool bInitializingDefaults = false;
+
+	/** Broadcasts when the actor info and defaults have been initialized. */
+	FNinjaAbilitySystemInitializedDelegate AbilitySystemInitializedDelegate;
+	
 	/** Broadcasts when abilities have been granted. */
 	FNinjaAbilityGivenDelegate AbilityGivenDelegate;
+
+	/** Broadcasts a list of abilities that have been granted. */
+	FNinjaAbilitiesGivenDelegate AbilitiesGivenDelegate;
+
+	/** Broadcasts all attributes applied after pending replication. */
+	FNinjaPendingAttributesAppliedDelegate PendingAttributesAppliedDelegate;
+
+	/** Broadcasts when defaults have been granted. */
+	FNinjaDefaultsReadyDelegate DefaultsReadyDelegate;
+
+	/** Keeps the owner's data asset and bundle loaded. */
+	TSharedPtr<FStreamableHandle> OwnerDefaultsHandle;
+
+	/** Keeps the avatar's data asset and bundle loaded. */
+	TSharedPtr<FStreamableHandle> AvatarDefaultsHandle;
+
+	/** Number of bulk ability updates currently open. */
+	int32 BulkAbilityUpdateCount = 0;
+
+	/** Abilities granted during the current bulk update. */
+	TArray<FGameplayAbilitySpecHandle> PendingGivenAbilityHandles;
+
+	/** Opens a bulk ability update. */
+	void BeginBulkAbilityUpdate();
+
+	/** Closes a bulk ability update, broadcasting pending notifications for the outermost one. */
+	void EndBulkAbilityUpdate();
+
+	/** Number of deferred aggregation scopes currently open for this component, in the current stack. */
+	int32 DeferredAggregationCount = 0;
+
+	/**
+	 * Spawned Attribute Sets, by their exact class.
+	 * Only read after validating the index, since the spawned attributes list keeps sets alive.
+	 */
+	mutable TMap<const UClass*, UAttributeSet*> AttributeSetsByClass;
+
+	/** Spawned Attribute Sets, by each Attribute Set class in their hierarchy. */
+	mutable TMap<const UClass*, UAttributeSet*> AttributeSetsByOwnerClass;
+
+	/** Incremented whenever the spawned attributes change in a way the index cannot follow. */
+	int32 AttributeSetGeneration = 0;
+
+	/** Generation reflected in the index. */
+	mutable int32 IndexedAttributeSetGeneration = INDEX_NONE;
+
+	/** Number of spawned Attribute Sets reflected in the index, catching sets added or removed elsewhere. */
+	mutable int32 IndexedAttributeSetCount = 0;
+
+	/** Detached Attribute Sets available for reuse, by class. */
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<UClass>, FNinjaPooledAttributeSets> PooledAttributeSets;
+
+	/** Attribute Sets reused from the pool. */
+	int32 AttributeSetPoolHits = 0;
+
+	/** Attribute Sets created while the pool was enabled. */
+	int32 AttributeSetPoolMisses = 0;
+
+	/**
+	 * Rebuilds the index if its generation is outdated or the number of spawned sets changed.
+	 * Sets replaced elsewhere, keeping the same count, must invalidate the index explicitly.
+	 */
+	void EnsureAttributeSetIndex() const;
+
+	/** Discards the index, so it is rebuilt on the next query. */
+	void InvalidateAttributeSetIndex();
+
+	/** Adds a single Attribute Set to the index. */
+	void IndexAttributeSet(UAttributeSet* AttributeSet) const;
 	
 	/** Setup and handles granted by the owner. */
 	FAbilityDefaultHandles OwnerHandles;
@@ -263,6 +678,27 @@ private:
 	/** Setup and handles granted by the avatar. */
 	FAbilityDefaultHandles AvatarHandles;
 
+	/** Informs if the idle baseline was captured. */
+	bool bHasIdleBaseline = false;
+
+	/** Owned tags when the idle baseline was captured. */
+	FGameplayTagContainer IdleBaselineTags;
+
+	/** Spawned Attribute Sets when the idle baseline was captured, in order. */
+	TArray<TObjectKey<UAttributeSet>> IdleBaselineAttributeSets;
+
+	/** Base and current attribute values when the idle baseline was captured, in Attribute Set order. */
+	TArray<FNinjaIdleAttributeBaseline> IdleBaselineAttributes;
+
+	/** Informs if spawned Attribute Sets are the same, and in the same order, as in the idle baseline. */
+	bool HasIdleBaselineAttributeSets() const;
+
+	/** Collects all Gameplay Attribute Data properties from spawned Attribute Sets. */
+	void CollectAttributeData(TArray<FPendingAttributeReplication>& OutAttributes) const;
+
+	/** Informs if an active effect was granted as a default by the owner or avatar. */
+	bool IsDefaultGameplayEffect(const FActiveGameplayEffectHandle& Handle) const;
+
 #pragma region AnimationMontages
 public:
 	
@@ -308,6 +744,27 @@ public:
 	UFUNCTION()
 	virtual void CurrentMontageSetPlayRateForMesh(USkeletalMeshComponent* InMesh, float InPlayRate);
 
+	/**
+	 * Sets meshes following montages played by a leader mesh, forming a montage group.
+	 *
+	 * Followers mirror playback, sections and play rates from the leader on each peer, so only the
+	 * leader is replicated. Groups are set where montages are played and replicated with the leader.
+	 *
+	 * @param Leader		Mesh used to play, stop and modify montages.
+	 * @param Followers		Meshes following the leader. An empty list removes the group.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "NBS|GAS|Ability System")
+	void SetMontageGroup(USkeletalMeshComponent* Leader, const TArray<USkeletalMeshComponent*>& Followers);
+
+	/**
+	 * Plays a montage on a leader mesh and its followers, replicating a single entry.
+	 * Followers are kept for montages played by the leader afterward.
+	 */
+	virtual float PlayMontageForMeshGroup(UGameplayAbility* AnimatingAbility, USkeletalMeshComponent* Leader, const TArray<USkeletalMeshComponent*>& Followers, FGameplayAbilityActivationInfo ActivationInfo, UAnimMontage* Montage, float InPlayRate, bool bOverrideBlendIn, const FMontageBlendSettings& BlendInOverride, FName StartSectionName = NAME_None, float StartTimeSeconds = 0.f, bool bReplicateMontage = true);
+
+	/** Provides valid followers for a leader mesh. */
+	TArray<USkeletalMeshComponent*> GetMontageGroupFollowers(const USkeletalMeshComponent* Leader) const;
+
 	// Returns true if the passed in ability is the current animating ability
 	bool IsAnimatingAbilityForAnyMesh(const UGameplayAbility* Ability) const;
 
@@ -344,11 +801,155 @@ public:
 	 * Callback from the animation data replication that handles montage playback.
 	 */
 	void PostAnimationEntryChange(FGameplayAbilityRepAnimMontageForMesh& Entry);
+
+	/**
+	 * Resolves montage and mesh registry indices received for a replicated entry.
+	 * Entries without registry indices are not modified.
+	 */
+	void ResolveMontageRegistryReferences(FGameplayAbilityRepAnimMontageForMesh& Entry) const;
+
+	/**
+	 * Provides the registry index for a mesh.
+	 *
+	 * @param InMesh	Mesh that will be replicated.
+	 * @return			One-based index in the mesh registry, or zero if the mesh is not registered.
+	 */
+	uint8 GetMeshRegistryIndex(const USkeletalMeshComponent* InMesh) const;
+
+	/**
+	 * Provides the registry index for a montage.
+	 *
+	 * @param Animation		Montage that will be replicated.
+	 * @return				One-based index in the montage registry, or zero if the montage is not registered.
+	 */
+	uint16 GetMontageRegistryIndex(const UAnimSequenceBase* Animation) const;
+
+	/**
+	 * Determines the fidelity used to replicate montage data for additional meshes to a connection.
+	 *
+	 * By default, connections viewing the avatar from beyond the LOD distance receive reduced data.
+	 * Subclasses can use the Significance Manager, or any other relevance metric, instead.
+	 *
+	 * @param Connection	Connection receiving montage data.
+	 * @return				Fidelity used for the connection.
+	 */
+	virtual EMontageReplicationLOD GetMontageReplicationLOD(const UNetConnection* Connection) const;
+
+	/**
+	 * Checks if the Ability System Component of a mesh owner drives a notify window from montage time.
+	 * Notify States use this to ignore animation events, so windows are not applied twice.
+	 *
+	 * @param InMesh		Mesh receiving animation events.
+	 * @param NotifyState	Notify State receiving the events.
+	 * @return				True if the window is driven by the Ability System Component.
+	 */
+	static bool IsNotifyWindowDrivenForMesh(const USkeletalMeshComponent* InMesh, const UAnimNotifyState* NotifyState);
 	
 protected:
 	
 	bool bSyncMeshAnimInfoWithLocalAnimInfo;
 	bool bPendingMontageRepForMesh;
+
+	/**
+	 * Determines how replicated montage data for additional meshes is updated on the server.
+	 *
+	 * With a timer, the component does not have to tick while montages are playing. Playing,
+	 * stopping, changing sections and play rates still update replicated data immediately.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System|Montages")
+	EMontageReplicationUpdateMode MontageReplicationUpdateMode;
+
+	/**
+	 * Samples per second used to update replicated montage data, when using a timer.
+	 * A rate of zero means replicated data is only updated when montages change.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System|Montages", meta = (EditCondition = "MontageReplicationUpdateMode == EMontageReplicationUpdateMode::Timer", ClampMin = 0, Units = "Hz"))
+	float MontageReplicationUpdateRate;
+
+	/**
+	 * Distance from the viewer beyond which montage data for additional meshes has reduced fidelity.
+	 * Far simulated proxies only receive starts, stops, sections and play rates. Zero disables it.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System|Montages", meta = (ClampMin = 0, Units = "cm"))
+	float MontageReplicationLODDistance;
+
+	/**
+	 * Drives notify windows from montage time on the server, instead of animation evaluation.
+	 *
+	 * Windows from Notify States implementing the Ability Notify Window Interface are extracted
+	 * when a montage is played, so servers can skip evaluating skeletal meshes entirely. Montage
+	 * time is extrapolated from the play rate while the montage is not advanced by its mesh.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System|Montages")
+	bool bDriveNotifyWindowsFromMontageTime;
+
+	/** Samples per second used to update notify windows driven from montage time. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System|Montages", meta = (EditCondition = "bDriveNotifyWindowsFromMontageTime", ClampMin = 1, Units = "Hz"))
+	float NotifyWindowUpdateRate;
+
+	/** Timer sampling replicated montage data. */
+	FTimerHandle MontageReplicationTimerHandle;
+
+	/**
+	 * Replicates registered montages and meshes as small indices, instead of object references.
+	 *
+	 * Montages are registered by the "Replicated Montages" in the owner and avatar data assets,
+	 * and meshes by the component tags below. Montages and meshes that are not registered are
+	 * still replicated by reference.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System|Montages")
+	bool bUseMontageRegistry;
+
+	/**
+	 * Component tags registering avatar meshes, in index order.
+	 * The first Skeletal Mesh Component in the avatar with each tag is registered, when the
+	 * actor info or defaults are initialized.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System|Montages", meta = (EditCondition = "bUseMontageRegistry"))
+	TArray<FName> MontageRegistryMeshTags;
+
+	/** Montages registered by the owner and avatar data assets, in index order. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAnimMontage>> RegisteredMontages;
+
+	/** One-based index of each registered montage. */
+	TMap<TObjectKey<UAnimSequenceBase>, uint16> MontageRegistryIndices;
+
+	/** Avatar meshes registered by each mesh tag, in index order. */
+	TArray<TWeakObjectPtr<USkeletalMeshComponent>> RegisteredMeshes;
+
+	/** One-based index of each registered avatar mesh. */
+	TMap<TObjectKey<USkeletalMeshComponent>, uint8> MeshRegistryIndices;
+
+	/**
+	 * Rebuilds registered montages from the owner and avatar data assets, and meshes from the avatar.
+	 * Clients also resolve any entries that were waiting for the registry.
+	 */
+	void RebuildMontageRegistry();
+
+	/** Provides a registered montage, from its one-based index. */
+	UAnimMontage* GetRegisteredMontage(uint16 RegistryIndex) const;
+
+	/** Provides a registered mesh from the avatar, from its one-based index. */
+	USkeletalMeshComponent* GetRegisteredMesh(uint8 RegistryIndex) const;
+
+	/** Followers for each montage group leader. Followers are driven locally and not replicated on their own. */
+	TMap<TObjectKey<USkeletalMeshComponent>, TArray<TWeakObjectPtr<USkeletalMeshComponent>>> MontageGroupFollowers;
+
+	/** Plays the montage started by a leader on its followers. */
+	void PlayMontageOnGroupFollowers(USkeletalMeshComponent* Leader, UAnimMontage* Montage, float InPlayRate, bool bOverrideBlendIn, const FMontageBlendSettings& BlendInOverride, float StartTimeSeconds);
+
+	/** Stops the montage stopped by a leader on its followers. */
+	void StopMontageOnGroupFollowers(const USkeletalMeshComponent* Leader, const UAnimMontage* Montage, float BlendOutTime);
+
+	/** Copies position, play rate and next sections from the leader's active montage to its followers. */
+	void SyncMontageGroupFollowers(USkeletalMeshComponent* Leader);
+
+	/** Updates the replicated followers for a leader, when a new montage instance starts. */
+	void UpdateReplicatedMontageGroup(FGameplayAbilityRepAnimMontageForMesh& Entry) const;
+
+	/** Applies followers received for a leader. */
+	void ApplyReplicatedMontageGroup(const FGameplayAbilityRepAnimMontageForMesh& Entry);
 	
 	/** 
 	 * Data structure for montages that were instigated locally (everything if server, predictive if client. replicated if simulated proxy).
@@ -364,13 +965,98 @@ protected:
 	UPROPERTY(Replicated)
 	FGameplayAbilityRepAnimMontageContainer RepAnimMontageInfoForMeshes;	
 
-	FGameplayAbilityLocalAnimMontageForMesh& GetLocalAnimMontageInfoForMesh(USkeletalMeshComponent* InMesh);
+	/** Slot index for each mesh in the local montage data. Validated on every lookup and rebuilt when stale. */
+	mutable TMap<TObjectKey<USkeletalMeshComponent>, int32> LocalAnimMontageSlotIndices;
+	
+	/**
+	 * Provides local montage data for a mesh, adding a new slot if necessary.
+	 *
+	 * Slots are never removed here, so indices are stable until slots are pruned on avatar changes.
+	 * Pointers are valid until the next new mesh, since adding a slot may grow the array.
+	 *
+	 * @param InMesh	Mesh playing montages.
+	 * @return			Local montage data for the mesh, or null if the mesh is not valid.
+	 */
+	FGameplayAbilityLocalAnimMontageForMesh* GetLocalAnimMontageInfoForMesh(USkeletalMeshComponent* InMesh);
+
+	/** Finds the slot index for a mesh in the local montage data. */
+	int32 FindLocalAnimMontageSlot(const USkeletalMeshComponent* InMesh) const;
+
+	/** Rebuilds slot indices for the local montage data. */
+	void RebuildLocalAnimMontageSlotIndices() const;
+
+	/**
+	 * Removes local montage data for meshes that have been destroyed.
+	 * Compacts the slots, so it must only run when no slot reference or index is being held.
+	 *
+	 * @return	Number of slots that have been removed.
+	 */
+	int32 PruneLocalAnimMontageSlots();
+
+	/**
+	 * Removes local and replicated montage data for meshes that have been destroyed,
+	 * and resets Anim Instances cached for the previous avatar.
+	 */
+	void PruneMontageSlots();
+	
+	/** Provides the Anim Instance for a mesh owned by the avatar, using the cached one if possible. */
+	UAnimInstance* GetAnimInstanceForMesh(const USkeletalMeshComponent* InMesh) const;
+
+	/** Provides the Anim Instance for a slot in the local montage data, caching it in the slot. */
+	UAnimInstance* GetAnimInstanceForSlot(const FGameplayAbilityLocalAnimMontageForMesh& Slot) const;
+
+	/** Resolves the Anim Instance for a mesh, if the mesh belongs to the avatar. */
+	UAnimInstance* ResolveAnimInstanceForMesh(const USkeletalMeshComponent* InMesh) const;
+
+	/**
+	 * Provides the active montage for a mesh, with a single lookup.
+	 *
+	 * @param InMesh				Mesh playing the montage.
+	 * @param OutAnimInstance		Anim Instance for the mesh, if it belongs to the avatar.
+	 * @return						The active montage, or null if no montage is active.
+	 */
+	UAnimMontage* GetActiveMontageForMesh(USkeletalMeshComponent* InMesh, UAnimInstance*& OutAnimInstance);
 
 	/**
 	 * Helper that marks the montage dirty, requiring replication.
+	 *
+	 * @param InMesh			Mesh playing the montage.
+	 * @param bIsNewInstance	A new montage instance has started, so blend settings must be replicated.
 	 */
 	UFUNCTION()
-	void MarkMontageReplicationDirtyForMesh(USkeletalMeshComponent* InMesh);
+	void MarkMontageReplicationDirtyForMesh(USkeletalMeshComponent* InMesh, bool bIsNewInstance = false);
+
+	/** Montage change waiting to be flushed at the end of the frame. */
+	struct FPendingMontageReplication
+	{
+		TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+		bool bIsNewInstance = false;
+	};
+
+	/** Montage changes made during the current frame. */
+	TArray<FPendingMontageReplication> PendingMontageReplications;
+
+	/** Net updates requested during the current frame. */
+	int32 PendingMontageNetUpdateRequests = 0;
+
+	/** Set while pending montage changes are flushed. */
+	bool bFlushingMontageReplication = false;
+
+	/** Provides the Montage Replication Subsystem, if changes should be coalesced. */
+	UNinjaGASMontageReplicationSubsystem* GetMontageReplicationScheduler() const;
+
+	/** Updates the replicated entry for a mesh and marks it dirty. */
+	void UpdateMontageReplicationForMesh(USkeletalMeshComponent* InMesh, bool bIsNewInstance);
+
+	/** Forces a net update for the avatar, or requests one at the end of the frame. */
+	void RequestMontageNetUpdate();
+
+	/**
+	 * Applies montage changes made during the frame, and sends montage commands predicted by clients.
+	 *
+	 * @return	Number of net updates requested, so the caller can force a single one.
+	 */
+	int32 FlushMontageReplication();
 	
 	// Called when a prediction key that played a montage is rejected
 	virtual void OnPredictiveMontageRejectedForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* PredictiveMontage);
@@ -382,20 +1068,209 @@ protected:
 	// Copy over playing flags for duplicate animation data
 	void AnimMontage_UpdateForcedPlayFlagsForMesh(FGameplayAbilityRepAnimMontageForMesh& OutRepAnimMontageInfo);	
 
+	/** Informs if any replicated montage is still playing on a valid mesh, requiring its data to be sampled. */
+	bool HasPlayingReplicatedMontages() const;
+	
+	/** Starts or stops the timer sampling replicated montage data, based on the montages currently playing. */
+	void UpdateMontageReplicationTimer();
+
+	/** Samples replicated montage data, marking entries dirty when they stop or move to another section. */
+	void SampleReplicatedMontages();
+
+	/**
+	 * Corrects the position of a replicated montage on a simulated proxy, when the error is too large.
+	 * Moving forward triggers any notifies that were skipped.
+	 *
+	 * @param Entry				Replicated montage data.
+	 * @param AnimInstance		Anim Instance playing the montage.
+	 * @param bStrictThreshold	Uses the base threshold, since the montage started or its play rate changed.
+	 */
+	void CorrectReplicatedMontagePositionForMesh(const FGameplayAbilityRepAnimMontageForMesh& Entry, UAnimInstance* AnimInstance, bool bStrictThreshold);
+
+	/** Informs if a mesh is throttled, so it may not be evaluated this frame. */
+	bool ShouldDeferMontageCorrectionForMesh(const USkeletalMeshComponent* InMesh) const;
+
+	/** Scales the correction threshold for a mesh, by the number of frames between its updates. */
+	float GetMontageCorrectionThresholdScale(const USkeletalMeshComponent* InMesh) const;
+
+	/** Defers the correction for a mesh until it is evaluated, merging it with any correction already pending. */
+	void DeferMontageCorrectionForMesh(USkeletalMeshComponent* InMesh, bool bStrictThreshold);
+
+	/** Applies the deferred correction for a mesh, once its bone transforms have been evaluated. */
+	void ApplyDeferredMontageCorrection(TWeakObjectPtr<USkeletalMeshComponent> WeakMesh);
+
+	/** Montage correction waiting for a throttled mesh to be evaluated. */
+	struct FDeferredMontageCorrection
+	{
+		TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+		FDelegateHandle EvaluatedHandle;
+		bool bStrictThreshold = false;
+	};
+
+	/** Corrections deferred for throttled meshes. */
+	TMap<TObjectKey<USkeletalMeshComponent>, FDeferredMontageCorrection> DeferredMontageCorrections;
+	
+	/** Notify window extracted from a montage, in montage time. */
+	struct FMontageNotifyWindow
+	{
+		TWeakObjectPtr<UAnimNotifyState> NotifyState;
+		TWeakObjectPtr<UAnimSequenceBase> Animation;
+		float StartTime = 0.f;
+		float EndTime = 0.f;
+		bool bActive = false;
+	};
+
+	/** Montage playing on a mesh, with the notify windows driven from its time. */
+	struct FDrivenMontageNotifyWindows
+	{
+		TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+		TWeakObjectPtr<UAnimMontage> Montage;
+		TArray<FMontageNotifyWindow> Windows;
+
+		/** Montage time used in the last update. */
+		float Position = 0.f;
+
+		/** Position reported by the montage instance in the last update. */
+		float ObservedPosition = 0.f;
+
+		/** World time of the last update. */
+		double UpdateTime = 0.;
+	};
+
+	/** Montages with notify windows driven from their time. */
+	TArray<FDrivenMontageNotifyWindows> DrivenNotifyWindows;
+
+	/** Timer updating notify windows driven from montage time. */
+	FTimerHandle NotifyWindowTimerHandle;
+
+	/** Informs if notify windows should be driven from montage time. */
+	bool ShouldDriveNotifyWindows() const;
+
+	/**
+	 * Extracts notify windows from a montage, including the ones from its slot segments.
+	 *
+	 * @param Montage		Montage that will be played.
+	 * @param OutWindows	Windows for Notify States implementing the Ability Notify Window Interface.
+	 */
+	static void ExtractNotifyWindows(const UAnimMontage* Montage, TArray<FMontageNotifyWindow>& OutWindows);
+
+	/** Starts driving notify windows for a montage that was just played, replacing any other montage on the mesh. */
+	void StartNotifyWindowsForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* Montage);
+
+	/**
+	 * Begins and ends windows for the current montage time.
+	 *
+	 * @return	True if the montage is still playing, false if all windows were ended.
+	 */
+	bool UpdateDrivenNotifyWindows(FDrivenMontageNotifyWindows& Driven, double CurrentTime);
+
+	/** Ends all active windows for a montage. */
+	static void EndDrivenNotifyWindows(FDrivenMontageNotifyWindows& Driven);
+
+	/** Updates all notify windows driven from montage time, stopping the timer once no montage is left. */
+	void UpdateNotifyWindows();
+
+	/** Provides the server time in milliseconds, wrapped to 16 bits, used to timestamp replicated montage positions. */
+	uint16 GetCompactServerTime() const;
+
+	/**
+	 * Extrapolates a replicated montage position, from the time elapsed since the server sampled it.
+	 * The position is kept within the replicated section, since the server may jump or loop from there.
+	 *
+	 * @param RepMontageInfo	Replicated montage data.
+	 * @param AnimMontage		Montage playing locally.
+	 * @param RepSectionID		Section containing the replicated position.
+	 * @return					Expected position for the montage on the server.
+	 */
+	float GetExtrapolatedMontagePosition(const FPlayTagGameplayAbilityRepAnimMontage& RepMontageInfo, const UAnimMontage* AnimMontage, int32 RepSectionID) const;
+
 	// Returns true if we are ready to handle replicated montage information
 	virtual bool IsReadyForReplicatedMontageForMesh();
 	
-	// RPC function called from CurrentMontageSetNextSectionName, replicates to other clients
-	UFUNCTION(Reliable, Server, WithValidation)
-	void ServerCurrentMontageSetNextSectionNameForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* ClientAnimMontage, float ClientPosition, FName SectionName, FName NextSectionName);
+	/** Montage commands predicted during the current frame, waiting to be sent to the server. */
+	TArray<FNinjaMontageCommand> PendingMontageCommands;
 
-	// RPC function called from CurrentMontageJumpToSection, replicates to other clients
-	UFUNCTION(Reliable, Server, WithValidation)
-	void ServerCurrentMontageJumpToSectionNameForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* ClientAnimMontage, FName SectionName);
+	/** Sequence assigned to the next batch of montage commands sent to the server. */
+	uint16 NextMontageCommandSequence = 0;
+
+	/** Sequence of the last batch of montage commands received by the server. */
+	uint16 LastMontageCommandSequence = 0;
 
-	// RPC function called from CurrentMontageSetPlayRate, replicates to other clients
+	/** Informs if the server has received any batch of montage commands. */
+	bool bHasReceivedMontageCommands = false;
+
+	/** Montage commands received by the server over the connection budget, applied in order once it refills. */
+	TArray<FNinjaMontageCommand> ThrottledMontageCommands;
+
+	/**
+	 * Queues a predicted montage command, sent to the server with other commands from the frame.
+	 *
+	 * @param InMesh		Mesh playing the montage.
+	 * @param AnimMontage	Montage being edited.
+	 * @param Command		Command with the edit, completed with the mesh and montage references.
+	 */
+	void QueueMontageCommand(USkeletalMeshComponent* InMesh, UAnimMontage* AnimMontage, FNinjaMontageCommand& Command);
+
+	/** Sends all pending montage commands to the server. */
+	void SendMontageCommands();
+
+	/** Applies a montage command received from the owning client. */
+	void ApplyMontageCommand(const FNinjaMontageCommand& Command);
+
+	/** Applies throttled montage commands allowed by the connection budget, retrying the rest on the next flush. */
+	void ApplyThrottledMontageCommands();
+
+	/**
+	 * Applies montage commands predicted by the owning client, replicating them to other clients.
+	 * Batches are applied in sequence, and commands over the connection budget are queued until it refills.
+	 * Batches that would grow the queue over the maximum backlog fail validation, closing the connection.
+	 */
 	UFUNCTION(Reliable, Server, WithValidation)
-	void ServerCurrentMontageSetPlayRateForMesh(USkeletalMeshComponent* InMesh, UAnimMontage* ClientAnimMontage, float InPlayRate);
+	void ServerApplyMontageCommands(uint16 Sequence, const TArray<FNinjaMontageCommand>& Commands);
 	
 #pragma endregion
 };
+
+/**
+ * Defers ability notifications from the Ninja ASC until the outermost scope ends.
+ * Abilities granted within the scope are broadcast together, with a single log entry.
+ */
+struct NINJAGAS_API FScopedNinjaAbilityBulkUpdate
+{
+	explicit FScopedNinjaAbilityBulkUpdate(UNinjaGASAbilitySystemComponent& InAbilitySystemComponent);
+	~FScopedNinjaAbilityBulkUpdate();
+
+private:
+
+	UNinjaGASAbilitySystemComponent& AbilitySystemComponent;
+	
+};
+
+/**
+ * Defers attribute aggregation while multiple effects are applied or removed from the Ninja ASC.
+ *
+ * Aggregators dirtied within the scope are evaluated once, when the outermost scope ends,
+ * so each affected attribute is recalculated and broadcast a single time.
+ *
+ * The batch is the engine's aggregator batch, which is global and not per component: while it
+ * is open, aggregators dirtied by any Ability System Component are deferred as well. For that
+ * reason, the scope can only live on the stack, so the batch is always closed by the same stack
+ * that opened it, even if the component is recycled or destroyed in between.
+ */
+struct NINJAGAS_API FScopedNinjaDeferredAggregation
+{
+	explicit FScopedNinjaDeferredAggregation(UNinjaGASAbilitySystemComponent& InAbilitySystemComponent);
+	~FScopedNinjaDeferredAggregation();
+
+	UE_NONCOPYABLE(FScopedNinjaDeferredAggregation);
+	void* operator new(size_t) = delete;
+	void* operator new[](size_t) = delete;
+
+private:
+
+	UNinjaGASAbilitySystemComponent& AbilitySystemComponent;
+
+	/** Global aggregator batch, opened by the outermost scope for the component. */
+	TOptional<FScopedAggregatorOnDirtyBatch> AggregatorBatch;
+	
+};
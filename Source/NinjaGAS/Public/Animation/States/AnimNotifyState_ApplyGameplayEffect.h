@@ -4,6 +4,7 @@
 #include "CoreMinimal.h"
 #include "ActiveGameplayEffectHandle.h"
 #include "Animation/AnimNotifies/AnimNotifyState.h"
+#include "Interfaces/AbilityNotifyWindowInterface.h"
 #include "Templates/SubclassOf.h"
 #include "AnimNotifyState_ApplyGameplayEffect.generated.h"
 
@@ -13,7 +14,7 @@ class UGameplayEffect;
  * Applies and removes a gameplay effect.
  */
 UCLASS(meta = (DisplayName = "Apply Gameplay Effect"))
-class NINJAGAS_API UAnimNotifyState_ApplyGameplayEffect : public UAnimNotifyState
+class NINJAGAS_API UAnimNotifyState_ApplyGameplayEffect : public UAnimNotifyState, public IAbilityNotifyWindowInterface
 {
 	
 	GENERATED_BODY()
@@ -23,6 +24,11 @@ public:
 	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration, const FAnimNotifyEventReference& EventReference) override;
 	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference) override;
 
+	// -- Begin Notify Window implementation
+	virtual void BeginNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+	virtual void EndNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+	// -- End Notify Window implementation
+
 protected:
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Gameplay Effect")
@@ -4,6 +4,7 @@
 #include "CoreMinimal.h"
 #include "GameplayTagContainer.h"
 #include "Animation/AnimNotifies/AnimNotifyState.h"
+#include "Interfaces/AbilityNotifyWindowInterface.h"
 #include "AnimNotifyState_ApplyLooseGameplayTags.generated.h"
 
 class UAbilitySystemComponent;
@@ -12,7 +13,7 @@ class UAbilitySystemComponent;
  * Adds and removes loose gameplay tags.
  */
 UCLASS(meta = (DisplayName = "Apply Loose Gameplay Tags"))
-class NINJAGAS_API UAnimNotifyState_ApplyLooseGameplayTags : public UAnimNotifyState
+class NINJAGAS_API UAnimNotifyState_ApplyLooseGameplayTags : public UAnimNotifyState, public IAbilityNotifyWindowInterface
 {
 	
 	GENERATED_BODY()
@@ -22,6 +23,11 @@ public:
 	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration, const FAnimNotifyEventReference& EventReference) override;
 	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference) override;
 
+	// -- Begin Notify Window implementation
+	virtual void BeginNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+	virtual void EndNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+	// -- End Notify Window implementation
+
 protected:
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Gameplay Tags")
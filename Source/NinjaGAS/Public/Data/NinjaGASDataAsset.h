@@ -7,6 +7,8 @@
 #include "Engine/DataAsset.h"
 #include "NinjaGASDataAsset.generated.h"
 
+class UAnimMontage;
+
 /**
  * Configures abilities that can be assigned to an avatar.
  */
@@ -21,6 +23,9 @@ public:
 	/** Asset type that uniquely identifies this data asset. */
 	static FPrimaryAssetType AssetType;	
 
+	/** Bundle containing everything granted by this data asset. */
+	static FName AbilitiesBundle;
+
 	/** List of Attribute Sets assigned to an avatar. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Abilities", meta = (AssetBundles = "Abilities", TitleProperty = "AttributeSetClass"))
 	TArray<FDefaultAttributeSet> DefaultAttributeSets;
@@ -36,6 +41,13 @@ public:
 	/** Gameplay tags that are added by default to the owner's ASC. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Abilities")
 	FGameplayTagContainer InitialGameplayTags;
+
+	/**
+	 * Montages replicated as registry indices, when the ASC uses a montage registry.
+	 * Indices follow this order, so servers and clients must use the same data.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Montages")
+	TArray<TObjectPtr<UAnimMontage>> ReplicatedMontages;
 	
 	UNinjaGASDataAsset();
 
@@ -11,6 +11,8 @@
 #include "NinjaGASActor.generated.h"
 
 class UNinjaGASAbilitySystemComponent;
+class UNinjaGASComponentPoolSubsystem;
+class UNinjaGASIdleDemotionSubsystem;
 
 /**
  * Base Actor class, with a pre-configured Ability System Component.
@@ -41,10 +43,13 @@ public:
 	// -- Begin Ability System implementation
 	virtual UAbilitySystemComponent* GetAbilitySystemComponent() const override;
 	virtual UNinjaGASDataAsset* GetAbilityData() const override;
+	virtual TSoftObjectPtr<UNinjaGASDataAsset> GetSoftAbilityData() const override;
 	// -- End Ability System implementation
 
 	// -- Begin Lazy Ability System Component Owner implementation
 	virtual ELazyAbilitySystemInitializationMode GetAbilitySystemInitializationMode() const override;
+	virtual UAbilitySystemComponent* PeekAbilitySystemComponent() const override;
+	virtual UAbilitySystemComponent* EnsureAbilitySystemComponent() override;
 	virtual void InitializeAbilitySystemComponent() override;
 	virtual void SetPendingAttributeFromReplication(const FGameplayAttribute& Attribute, const FGameplayAttributeData& NewValue) override;
 	virtual void ApplyPendingAttributesFromReplication() override;
@@ -78,18 +83,56 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
 	TSubclassOf<UNinjaGASAbilitySystemComponent> AbilitySystemComponentClass;
 
+	/**
+	 * Borrows the Ability System Component from the world's component pool, returning it once destroyed.
+	 * Useful for lazy actors that are spawned and destroyed often, such as projectiles or destructibles.
+	 *
+	 * On networked worlds, returned components are replicated, so they are destroyed instead of
+	 * recycled, and the pool only provides components warmed up when the level is loaded.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System", meta = (EditCondition = "AbilitySystemInitializationMode == ELazyAbilitySystemInitializationMode::Lazy"))
+	bool bUseAbilitySystemComponentPool;
+
+	/**
+	 * Releases the Ability System Component once it stays idle, keeping only attributes that changed
+	 * from their defaults. The component is created again on the next access, restoring those values.
+	 *
+	 * Useful for worlds with many actors that are only affected by abilities once in a while.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System", meta = (EditCondition = "AbilitySystemInitializationMode == ELazyAbilitySystemInitializationMode::Lazy"))
+	bool bDemoteIdleAbilitySystemComponent;
+
+	/** Seconds the Ability System Component must stay idle before being released. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System", meta = (EditCondition = "bDemoteIdleAbilitySystemComponent", ClampMin = 0, Units = "s"))
+	float IdleDemotionDelay;
+
 	/** Default configuration for the Ability System. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
 	TObjectPtr<UNinjaGASDataAsset> DefaultAbilitySetup;
+
+	/**
+	 * Default configuration for the Ability System, loaded asynchronously with its "Abilities" bundle.
+	 * Only used if the hard reference is not set, so first spawns do not cause a synchronous load.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System", meta = (EditCondition = "DefaultAbilitySetup == nullptr"))
+	TSoftObjectPtr<UNinjaGASDataAsset> SoftAbilitySetup;
 	
 	/**
 	 * Hook invoked when the ability system component replicates.
 	 */
 	UFUNCTION()
 	virtual void OnRep_ReplicatedActorAbilities();
+
+	/** Provides the component pool, if this actor should use it. */
+	UNinjaGASComponentPoolSubsystem* GetAbilitySystemComponentPool() const;
+
+	/** Provides the idle demotion scheduler, if this actor should use it. */
+	UNinjaGASIdleDemotionSubsystem* GetIdleDemotionScheduler() const;
 	
 private:
 
+	friend class UNinjaGASIdleDemotionSubsystem;
+
 	/** The Ability System Component managed by this actor class. */
 	UPROPERTY(Transient)
 	TObjectPtr<UNinjaGASAbilitySystemComponent> ActorAbilities;
@@ -100,8 +143,30 @@ private:
 
 	/**
 	 * Attributes pending replication, that must be handled when the ASC replicates.
+	 * Only the latest value received for each attribute is kept.
 	 * Always empty if the ASC initialization is set to "eager".
 	 */
 	TArray<FPendingAttributeReplication> PendingAttributeReplications;
+
+	/** Informs if the current Ability System Component was borrowed from the component pool. */
+	bool bAbilitySystemComponentFromPool;
+
+	/** Attributes that changed from their defaults when the component was demoted, restored once it is created again. */
+	TArray<FPendingAttributeReplication> DemotedAttributes;
+
+	/** Handle for the initialization of the current component, used to capture its idle baseline. */
+	FDelegateHandle AbilitySystemInitializedHandle;
+
+	/** Captures the idle baseline for a new component and restores demoted attributes. */
+	void HandleAbilitySystemInitialized();
+
+	/** Informs if the current component holds no state beyond its defaults. */
+	bool IsAbilitySystemComponentIdle() const;
+
+	/** Releases the idle component, keeping attributes that changed from their defaults. */
+	void DemoteAbilitySystemComponent();
+
+	/** Returns the component to the pool, or destroys it, clearing all references. */
+	void ReleaseAbilitySystemComponent();
 	
 };
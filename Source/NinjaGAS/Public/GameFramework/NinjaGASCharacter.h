@@ -6,6 +6,8 @@
 #include "AbilitySystemInterface.h"
 #include "GameFramework/Character.h"
 #include "Interfaces/AbilitySystemDefaultsInterface.h"
+#include "Interfaces/LazyAbilitySystemComponentOwnerInterface.h"
+#include "Types/FPendingAttributeReplication.h"
 #include "NinjaGASCharacter.generated.h"
 
 class UNinjaGASDataAsset;
@@ -16,7 +18,7 @@ class UNinjaGASAbilitySystemComponent;
  */
 UCLASS(Abstract)
 class NINJAGAS_API ANinjaGASCharacter : public ACharacter, public IAbilitySystemInterface, public IAbilitySystemDefaultsInterface,
-	public IGameplayTagAssetInterface
+	public IGameplayTagAssetInterface, public ILazyAbilitySystemComponentOwnerInterface
 {
 	
 	GENERATED_BODY()
@@ -29,6 +31,8 @@ public:
 	ANinjaGASCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
 	// -- Begin Character implementation
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	virtual void PostInitProperties() override;
 	virtual void PreInitializeComponents() override;
 	virtual void BeginPlay() override;
@@ -38,8 +42,18 @@ public:
 	// -- Begin Ability System implementation
 	virtual UAbilitySystemComponent* GetAbilitySystemComponent() const override;
 	virtual UNinjaGASDataAsset* GetAbilityData() const override;
+	virtual TSoftObjectPtr<UNinjaGASDataAsset> GetSoftAbilityData() const override;
 	// -- End Ability System implementation
 
+	// -- Begin Lazy Ability System Component Owner implementation
+	virtual ELazyAbilitySystemInitializationMode GetAbilitySystemInitializationMode() const override;
+	virtual UAbilitySystemComponent* PeekAbilitySystemComponent() const override;
+	virtual UAbilitySystemComponent* EnsureAbilitySystemComponent() override;
+	virtual void InitializeAbilitySystemComponent() override;
+	virtual void SetPendingAttributeFromReplication(const FGameplayAttribute& Attribute, const FGameplayAttributeData& NewValue) override;
+	virtual void ApplyPendingAttributesFromReplication() override;
+	// -- End Lazy Ability System Component Owner implementation
+
 	// -- Begin Gameplay Tags implementation
 	virtual void GetOwnedGameplayTags(FGameplayTagContainer& TagContainer) const override;
 	// -- End Gameplay Tags implementation
@@ -48,6 +62,20 @@ protected:
 
 	/** Allows subclasses to skip ASC initialization, most likely because they'll use the Player State. */
 	bool bInitializeAbilityComponentOnBeginPlay;
+
+	/**
+	 * Determines how this character will initialize its Ability System Component.
+	 *
+	 * Only used when the Ability System Component is not created as a default subobject. Subclasses
+	 * can skip it with "DoNotCreateDefaultSubobject(AbilitySystemComponentName)", so it is created
+	 * at runtime, using the Ability System Component Class.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
+	ELazyAbilitySystemInitializationMode AbilitySystemInitializationMode;
+
+	/** The class used to initialize the Ability System Component, when not created as a default subobject. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
+	TSubclassOf<UNinjaGASAbilitySystemComponent> AbilitySystemComponentClass;
 	
 	/**
 	 * Sets how the Ability System component will replicate data to clients.
@@ -69,6 +97,13 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
 	TObjectPtr<UNinjaGASDataAsset> DefaultAbilitySetup;
 
+	/**
+	 * Default configuration for the Ability System, loaded asynchronously with its "Abilities" bundle.
+	 * Only used if the hard reference is not set, so first spawns do not cause a synchronous load.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System", meta = (EditCondition = "DefaultAbilitySetup == nullptr"))
+	TSoftObjectPtr<UNinjaGASDataAsset> SoftAbilitySetup;
+
 	/**
 	 * Initializes the ability system component using the source as an avatar.
 	 *
@@ -91,11 +126,28 @@ protected:
 	 */
 	UFUNCTION()
 	virtual void InitializeFromPlayerState();
+
+	/**
+	 * Hook invoked when the ability system component replicates.
+	 */
+	UFUNCTION()
+	virtual void OnRep_ReplicatedCharacterAbilities();
 	
 private:
 
 	/** The Ability System Component managed by this character class. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess))
 	TObjectPtr<UNinjaGASAbilitySystemComponent> CharacterAbilities;
+
+	/** Replicated Ability System Component, considering the creation policy. */
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_ReplicatedCharacterAbilities)
+	TObjectPtr<UNinjaGASAbilitySystemComponent> ReplicatedCharacterAbilities;
+
+	/**
+	 * Attributes pending replication, that must be handled when the ASC replicates.
+	 * Only the latest value received for each attribute is kept.
+	 * Always empty if the ASC is created as a default subobject or initialized eagerly.
+	 */
+	TArray<FPendingAttributeReplication> PendingAttributeReplications;
 	
 };
@@ -5,6 +5,8 @@
 #include "AbilitySystemComponent.h"
 #include "AbilitySystemInterface.h"
 #include "GameFramework/Pawn.h"
+#include "Interfaces/LazyAbilitySystemComponentOwnerInterface.h"
+#include "Types/FPendingAttributeReplication.h"
 #include "NinjaGASPawn.generated.h"
 
 class UNinjaGASAbilitySystemComponent;
@@ -13,7 +15,7 @@ class UNinjaGASAbilitySystemComponent;
  * Base Pawn class, with a pre-configured Ability System Component.
  */
 UCLASS(Abstract)
-class NINJAGAS_API ANinjaGASPawn : public APawn, public IAbilitySystemInterface
+class NINJAGAS_API ANinjaGASPawn : public APawn, public IAbilitySystemInterface, public ILazyAbilitySystemComponentOwnerInterface
 {
 	
 	GENERATED_BODY()
@@ -26,6 +28,8 @@ public:
 	ANinjaGASPawn(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
 	// -- Begin Actor implementation
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	virtual void PostInitProperties() override;
 	virtual void PreInitializeComponents() override;
 	virtual void BeginPlay() override;
@@ -36,10 +40,33 @@ public:
 	virtual UAbilitySystemComponent* GetAbilitySystemComponent() const override;
 	// -- End Ability System implementation
 
+	// -- Begin Lazy Ability System Component Owner implementation
+	virtual ELazyAbilitySystemInitializationMode GetAbilitySystemInitializationMode() const override;
+	virtual UAbilitySystemComponent* PeekAbilitySystemComponent() const override;
+	virtual UAbilitySystemComponent* EnsureAbilitySystemComponent() override;
+	virtual void InitializeAbilitySystemComponent() override;
+	virtual void SetPendingAttributeFromReplication(const FGameplayAttribute& Attribute, const FGameplayAttributeData& NewValue) override;
+	virtual void ApplyPendingAttributesFromReplication() override;
+	// -- End Lazy Ability System Component Owner implementation
+	
 protected:
 
 	/** Allows subclasses to skip ASC initialization, most likely because they'll use the Player State. */
 	bool bInitializeAbilityComponentOnBeginPlay;
+
+	/**
+	 * Determines how this pawn will initialize its Ability System Component.
+	 *
+	 * Only used when the Ability System Component is not created as a default subobject. Subclasses
+	 * can skip it with "DoNotCreateDefaultSubobject(AbilitySystemComponentName)", so it is created
+	 * at runtime, using the Ability System Component Class.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
+	ELazyAbilitySystemInitializationMode AbilitySystemInitializationMode;
+
+	/** The class used to initialize the Ability System Component, when not created as a default subobject. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability System")
+	TSubclassOf<UNinjaGASAbilitySystemComponent> AbilitySystemComponentClass;
 	
 	/**
 	 * Sets how the Ability System component will replicate data to clients.
@@ -79,11 +106,28 @@ protected:
 	 */
 	UFUNCTION()
 	virtual void InitializeFromPlayerState();
+
+	/**
+	 * Hook invoked when the ability system component replicates.
+	 */
+	UFUNCTION()
+	virtual void OnRep_ReplicatedPawnAbilities();
 	
 private:
 
 	/** The Ability System Component managed by this pawn class. */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess))
 	TObjectPtr<UNinjaGASAbilitySystemComponent> PawnAbilities;
+
+	/** Replicated Ability System Component, considering the creation policy. */
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_ReplicatedPawnAbilities)
+	TObjectPtr<UNinjaGASAbilitySystemComponent> ReplicatedPawnAbilities;
+
+	/**
+	 * Attributes pending replication, that must be handled when the ASC replicates.
+	 * Only the latest value received for each attribute is kept.
+	 * Always empty if the ASC is created as a default subobject or initialized eagerly.
+	 */
+	TArray<FPendingAttributeReplication> PendingAttributeReplications;
 	
 };
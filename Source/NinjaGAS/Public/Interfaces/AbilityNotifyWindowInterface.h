@@ -0,0 +1,47 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "UObject/Interface.h"
+#include "AbilityNotifyWindowInterface.generated.h"
+
+class UAnimSequenceBase;
+class USkeletalMeshComponent;
+
+UINTERFACE(MinimalAPI, meta = (CannotImplementInterfaceInBlueprint))
+class UAbilityNotifyWindowInterface : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Defines a Notify State whose window can be driven by the Ninja ASC from montage time.
+ *
+ * Servers set to drive notify windows extract them when a montage starts, so gameplay-relevant
+ * windows still begin and end even if the skeletal mesh is never evaluated.
+ */
+class NINJAGAS_API IAbilityNotifyWindowInterface
+{
+	
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Begins the window for a mesh.
+	 *
+	 * @param MeshComp		Mesh playing the animation.
+	 * @param Animation		Animation containing the notify.
+	 */
+	virtual void BeginNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) = 0;
+
+	/**
+	 * Ends the window for a mesh.
+	 *
+	 * @param MeshComp		Mesh playing the animation.
+	 * @param Animation		Animation containing the notify.
+	 */
+	virtual void EndNotifyWindow(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) = 0;
+	
+};
@@ -4,6 +4,7 @@
 #include "CoreMinimal.h"
 #include "UObject/ObjectMacros.h"
 #include "UObject/Interface.h"
+#include "UObject/SoftObjectPtr.h"
 #include "AbilitySystemDefaultsInterface.generated.h"
 
 class UNinjaGASDataAsset;
@@ -27,6 +28,12 @@ public:
 	/** Provides the default bundle for the avatar. */
 	virtual const UNinjaGASDataAsset* GetAbilityData() const = 0;
 	
+	/**
+	 * Provides a soft reference to the default bundle for the avatar.
+	 * Only used when no data is provided by "GetAbilityData", and loaded asynchronously.
+	 */
+	virtual TSoftObjectPtr<UNinjaGASDataAsset> GetSoftAbilityData() const { return nullptr; }
+	
 	/** Informs if an Ability Bundle is available. */
-	virtual bool HasAbilityData() const { return GetAbilityData() != nullptr; }
+	virtual bool HasAbilityData() const { return GetAbilityData() != nullptr || !GetSoftAbilityData().IsNull(); }
 };
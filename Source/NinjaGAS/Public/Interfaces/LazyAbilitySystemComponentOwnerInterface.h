@@ -7,6 +7,8 @@
 #include "Types/ELazyAbilitySystemInitializationMode.h"
 #include "LazyAbilitySystemComponentOwnerInterface.generated.h"
 
+class UAbilitySystemComponent;
+
 UINTERFACE(MinimalAPI, meta=(CannotImplementInterfaceInBlueprint))
 class ULazyAbilitySystemComponentOwnerInterface : public UInterface
 {
@@ -15,6 +17,9 @@ class ULazyAbilitySystemComponentOwnerInterface : public UInterface
 
 /**
  * An interface for actors, pawns and characters that support lazy initialization for the Ability System Component.
+ *
+ * Owners implementing this interface initialize lazy components when "GetAbilitySystemComponent" is called, which
+ * includes lookups from the Ability System Globals. Queries that can handle a missing component should peek instead.
  */
 class NINJAGAS_API ILazyAbilitySystemComponentOwnerInterface
 {
@@ -28,8 +33,23 @@ public:
 	 */
 	virtual ELazyAbilitySystemInitializationMode GetAbilitySystemInitializationMode() const = 0;
 
+	/**
+	 * Provides the Ability System Component, only if it has been initialized already.
+	 * 
+	 * @return	The current Ability System Component, or null if it was not initialized yet.
+	 */
+	virtual UAbilitySystemComponent* PeekAbilitySystemComponent() const = 0;
+
+	/**
+	 * Provides the Ability System Component, initializing it if necessary.
+	 * 
+	 * @return	The Ability System Component, or null if it cannot be initialized by this instance.
+	 */
+	virtual UAbilitySystemComponent* EnsureAbilitySystemComponent() = 0;
+
 	/**
 	 * Logic invoked to initialize the Ability System Component, when necessary.
+	 * Clients do not create components, they hydrate the replicated one instead.
 	 */
 	virtual void InitializeAbilitySystemComponent() = 0;	
 	
@@ -43,6 +63,8 @@ public:
 
 	/**
 	 * Handles pending attributes when the Ability System Component is initialized.
+	 * Only the latest value received for each attribute is applied. Base values are all written
+	 * before any change is notified, followed by one batched notification from the component.
 	 */
 	virtual void ApplyPendingAttributesFromReplication() = 0;
 
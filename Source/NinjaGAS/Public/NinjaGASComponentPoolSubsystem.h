@@ -0,0 +1,103 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayEffectTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Types/FNinjaPooledAbilitySystemComponents.h"
+#include "NinjaGASComponentPoolSubsystem.generated.h"
+
+class UNinjaGASAbilitySystemComponent;
+
+/**
+ * Keeps pre-constructed Ninja ASCs, so lazy actors can borrow one instead of creating it.
+ *
+ * Components are pooled by class and replication mode. Each pool can be warmed up when the first
+ * actor using it begins play, moving the construction cost to the level load. Actors return their
+ * component when destroyed, and it is reset before being borrowed by another actor.
+ *
+ * On networked worlds, this is only a warm-up cache. Components that were replicated keep their
+ * network identity, so they are destroyed when returned, instead of being moved to another actor.
+ * Pools still provide components created ahead of time, moving their cost to the level load.
+ */
+UCLASS()
+class NINJAGAS_API UNinjaGASComponentPoolSubsystem : public UWorldSubsystem
+{
+
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Informs if component pooling is globally enabled.
+	 * When disabled, actors create and destroy their components, as usual.
+	 */
+	static bool IsPoolingEnabled();
+
+	// -- Begin Subsystem implementation
+	virtual void Deinitialize() override;
+	// -- End Subsystem implementation
+
+	/**
+	 * Borrows a component for an owner, creating a new one if the pool is empty.
+	 * The component is moved to the owner, but it is not registered or initialized.
+	 *
+	 * @param Owner				Actor that will own the component.
+	 * @param ComponentClass	Class of the component.
+	 * @param ReplicationMode	Replication mode for Gameplay Effects.
+	 * @return					Component owned by the actor.
+	 */
+	UNinjaGASAbilitySystemComponent* Acquire(AActor* Owner, const TSubclassOf<UNinjaGASAbilitySystemComponent>& ComponentClass, EGameplayEffectReplicationMode ReplicationMode);
+
+	/**
+	 * Returns a component to the pool, resetting its state. Components that cannot be recycled, such
+	 * as replicated ones on networked worlds, or that would exceed the maximum size of their pool,
+	 * are destroyed instead.
+	 *
+	 * @param AbilitySystemComponent	Component being returned.
+	 */
+	void Release(UNinjaGASAbilitySystemComponent* AbilitySystemComponent);
+
+	/**
+	 * Creates components for a class and replication mode, up to the warm-up count.
+	 * Each pool is only warmed up once, so this can be called by every actor using it.
+	 *
+	 * @param ComponentClass	Class of the components.
+	 * @param ReplicationMode	Replication mode for Gameplay Effects.
+	 */
+	void WarmUp(const TSubclassOf<UNinjaGASAbilitySystemComponent>& ComponentClass, EGameplayEffectReplicationMode ReplicationMode);
+
+	/** Number of components currently available in all pools. */
+	int32 GetPooledCount() const { return PooledCount; }
+
+protected:
+
+	/** Takes an available component from a pool, if there is one. */
+	UNinjaGASAbilitySystemComponent* PopPooledComponent(const FNinjaComponentPoolKey& PoolKey);
+
+	/** Counts available components for a pool. */
+	int32 CountPooledComponents(const FNinjaComponentPoolKey& PoolKey) const;
+
+	/** Creates an unregistered component, owned by this subsystem until it is borrowed. */
+	UNinjaGASAbilitySystemComponent* CreatePooledComponent(UClass* ComponentClass, EGameplayEffectReplicationMode ReplicationMode);
+
+	/**
+	 * Informs if a component can be moved to another actor once returned.
+	 * Replicated components cannot be recycled on networked worlds, since clients know them by their owner.
+	 */
+	virtual bool CanRecycle(const UNinjaGASAbilitySystemComponent* AbilitySystemComponent) const;
+
+private:
+
+	/** Components available to be borrowed, for each pool. */
+	UPROPERTY(Transient)
+	TMap<FNinjaComponentPoolKey, FNinjaPooledAbilitySystemComponents> PooledComponents;
+
+	/** Number of components available in all pools. */
+	int32 PooledCount = 0;
+	
+	/** Pools that have been warmed up already. */
+	UPROPERTY(Transient)
+	TSet<FNinjaComponentPoolKey> WarmedUpPools;
+
+};
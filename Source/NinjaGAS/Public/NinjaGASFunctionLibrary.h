@@ -7,6 +7,7 @@
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "NinjaGASFunctionLibrary.generated.h"
 
+class UAbilitySystemComponent;
 class UNinjaGASAbilitySystemComponent;
 
 /**
@@ -23,9 +24,31 @@ public:
 	/**
 	 * Provides the custom (Ninja GAS) Ability System Component from an owner.
 	 * Performs like the Ability System Globals version, but handles the cast for you.
+	 *
+	 * Lazy Ability System Components are initialized, if necessary.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "NBS|GAS", meta = (ReturnDisplayName = "ASC"))
 	static UNinjaGASAbilitySystemComponent* GetCustomAbilitySystemComponentFromActor(AActor* Owner);
+
+	/**
+	 * Provides the Ability System Component from an owner, without initializing lazy components.
+	 * Meant for queries that can handle a missing component, such as overlaps or perception.
+	 *
+	 * @param Owner		Actor providing the Ability System Component.
+	 * @return			The Ability System Component, or null if it is not available yet.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "NBS|GAS", meta = (ReturnDisplayName = "ASC"))
+	static UAbilitySystemComponent* PeekAbilitySystemComponentFromActor(const AActor* Owner);
+
+	/**
+	 * Provides the Ability System Component from an owner, initializing lazy components if necessary.
+	 * Meant for logic that really needs the component, such as granting or activating abilities.
+	 *
+	 * @param Owner		Actor providing the Ability System Component.
+	 * @return			The Ability System Component, or null if the owner does not have one.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "NBS|GAS", meta = (ReturnDisplayName = "ASC"))
+	static UAbilitySystemComponent* EnsureAbilitySystemComponentFromActor(AActor* Owner);
 	
 	/**
 	 * Sends a Gameplay Event to the Owner's of an Ability System Component.
@@ -0,0 +1,123 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "Types/FNinjaAbilityGrantPlan.h"
+#include "Types/FNinjaAttributeTableLayout.h"
+#include "UObject/ObjectKey.h"
+#include "NinjaGASGrantPlanSubsystem.generated.h"
+
+class UDataTable;
+class UNinjaGASDataAsset;
+class FPackageReloadedEvent;
+enum class EPackageReloadPhase : uint8;
+struct FPropertyChangedEvent;
+
+/**
+ * Caches compiled grant plans for Ninja GAS Data Assets and baked Attribute Table layouts.
+ *
+ * Plans are shared by every world, compiled on first use and discarded when the data asset
+ * is garbage collected, modified in the editor or reloaded. Layouts follow the same rules
+ * for their Attribute Set class and Attribute Table. Everything is discarded when objects
+ * are replaced, since plans reference class defaults that are reinstanced by Blueprint
+ * compilation and hot reload.
+ */
+UCLASS()
+class NINJAGAS_API UNinjaGASGrantPlanSubsystem : public UEngineSubsystem
+{
+
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Convenience accessor that retrieves a plan from the engine subsystem.
+	 *
+	 * @param AbilityData		Data asset providing the defaults.
+	 * @return					The cached plan, or null if plans are disabled or unavailable.
+	 */
+	static TSharedPtr<const FNinjaAbilityGrantPlan> FindOrCompileGrantPlan(const UNinjaGASDataAsset* AbilityData);
+
+	/**
+	 * Convenience accessor that retrieves a table layout from the engine subsystem.
+	 *
+	 * @param AttributeSetClass		Attribute Set class that will be initialized.
+	 * @param AttributeTable		Table with default values, or null for the class defaults.
+	 * @return						The cached layout, or null if layouts are disabled or unavailable.
+	 */
+	static TSharedPtr<const FNinjaAttributeTableLayout> FindOrBuildAttributeTableLayout(const UClass* AttributeSetClass, const UDataTable* AttributeTable);
+
+	// -- Begin Subsystem implementation
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// -- End Subsystem implementation
+
+	/**
+	 * Provides the plan for a data asset, compiling it if necessary.
+	 *
+	 * @param AbilityData		Data asset providing the defaults.
+	 * @return					The compiled plan.
+	 */
+	TSharedRef<const FNinjaAbilityGrantPlan> GetGrantPlan(const UNinjaGASDataAsset* AbilityData);
+
+	/** Discards the plan compiled for a given data asset. */
+	void InvalidateGrantPlan(const UNinjaGASDataAsset* AbilityData);
+
+	/** Discards all compiled plans. */
+	void InvalidateAllGrantPlans();
+
+	/**
+	 * Provides the layout for an Attribute Set class and table, building it if necessary.
+	 *
+	 * @param AttributeSetClass		Attribute Set class that will be initialized.
+	 * @param AttributeTable		Table with default values, or null for the class defaults.
+	 * @return						The baked layout.
+	 */
+	TSharedRef<const FNinjaAttributeTableLayout> GetAttributeTableLayout(const UClass* AttributeSetClass, const UDataTable* AttributeTable);
+
+	/** Discards all layouts built from a given table. */
+	void InvalidateAttributeTableLayouts(const UDataTable* AttributeTable);
+
+protected:
+
+	/** Removes plans for data assets that have been collected. */
+	void HandlePostGarbageCollect();
+
+	/** Discards all plans and layouts when objects they may reference are reinstanced. */
+	void HandleObjectsReplaced(const TMap<UObject*, UObject*>& ReplacementMap);
+
+#if WITH_EDITOR
+	/** Invalidates a plan or layouts when their source asset is modified. */
+	void HandleObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent);
+
+	/** Invalidates layouts when rows in an Attribute Table change. */
+	void HandleDataTableChanged(TObjectKey<const UDataTable> AttributeTable);
+
+	/** Invalidates all plans when packages are reloaded. */
+	void HandlePackageReloaded(EPackageReloadPhase Phase, FPackageReloadedEvent* PackageReloadedEvent);
+#endif
+
+private:
+
+	/** Compiled plans, by data asset. */
+	TMap<TObjectKey<const UNinjaGASDataAsset>, TSharedRef<const FNinjaAbilityGrantPlan>> GrantPlans;
+
+	/** Key for a baked layout. */
+	using FAttributeTableLayoutKey = TPair<TObjectKey<const UClass>, TObjectKey<const UDataTable>>;
+
+	/** Baked layouts, by Attribute Set class and table. */
+	TMap<FAttributeTableLayoutKey, TSharedRef<const FNinjaAttributeTableLayout>> AttributeTableLayouts;
+
+	FDelegateHandle PostGarbageCollectHandle;
+	FDelegateHandle ObjectsReplacedHandle;
+
+#if WITH_EDITOR
+	FDelegateHandle ObjectPropertyChangedHandle;
+	FDelegateHandle PackageReloadedHandle;
+
+	/** Tables we are already listening to. */
+	TSet<TObjectKey<const UDataTable>> ObservedTables;
+#endif
+
+};
@@ -0,0 +1,70 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NinjaGASIdleDemotionSubsystem.generated.h"
+
+class ANinjaGASActor;
+
+/**
+ * Watches lazy actors that created their Ninja ASC, releasing components that stay idle.
+ *
+ * Candidates are checked in a round-robin sweep, a few per frame, so large worlds only pay for
+ * a fixed number of checks. Once a component was idle for every check during the actor's delay,
+ * the actor keeps any attributes that changed from their defaults and releases the component.
+ * It is created again, and the kept attributes restored, on the next access.
+ */
+UCLASS()
+class NINJAGAS_API UNinjaGASIdleDemotionSubsystem : public UTickableWorldSubsystem
+{
+
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Informs if idle demotion is globally enabled.
+	 * When disabled, actors keep their components, as usual.
+	 */
+	static bool IsDemotionEnabled();
+
+	// -- Begin Subsystem implementation
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// -- End Subsystem implementation
+
+	/**
+	 * Starts watching an actor that just created its component.
+	 * Actors are removed once demoted or destroyed, so they are registered again with a new component.
+	 *
+	 * @param Actor		Actor owning the component.
+	 */
+	void Register(ANinjaGASActor* Actor);
+
+	/** Number of actors currently being watched. */
+	int32 GetCandidateCount() const { return Candidates.Num(); }
+
+protected:
+
+	/** Actor being watched. */
+	struct FIdleCandidate
+	{
+		/** Actor owning the component. */
+		TWeakObjectPtr<ANinjaGASActor> Actor;
+
+		/** World time when the component was first found idle, or negative if it was busy. */
+		double IdleSince = -1.;
+	};
+
+private:
+
+	/** Actors being watched. */
+	TArray<FIdleCandidate> Candidates;
+
+	/** Candidate checked next by the sweep. */
+	int32 NextCandidateIndex = 0;
+
+};
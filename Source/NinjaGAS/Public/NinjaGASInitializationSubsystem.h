@@ -0,0 +1,110 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NinjaGASInitializationSubsystem.generated.h"
+
+class UNinjaGASAbilitySystemComponent;
+
+/**
+ * Schedules default grants and resets for Ninja ASCs, processing them under a frame budget.
+ *
+ * Components opting into scheduled initialization are queued here instead of granting their
+ * defaults synchronously, so spawning many actors or resetting many players in the same frame
+ * is spread across multiple frames. Player-controlled avatars are always processed first,
+ * followed by avatars closer to any player, which are the most likely to be relevant.
+ */
+UCLASS()
+class NINJAGAS_API UNinjaGASInitializationSubsystem : public UTickableWorldSubsystem
+{
+
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Informs if scheduled initialization is globally enabled.
+	 * When disabled, components initialize and reset synchronously, as usual.
+	 */
+	static bool IsSchedulingEnabled();
+
+	// -- Begin Subsystem implementation
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// -- End Subsystem implementation
+
+	/**
+	 * Queues the initialization of defaults for a component.
+	 *
+	 * @param AbilitySystemComponent	Component that will be initialized.
+	 * @param bAvatarHasChanged			Informs if defaults from a new avatar must be granted as well.
+	 */
+	void QueueInitialization(UNinjaGASAbilitySystemComponent* AbilitySystemComponent, bool bAvatarHasChanged);
+
+	/**
+	 * Queues a full reset for a component.
+	 *
+	 * @param AbilitySystemComponent	Component that will be reset.
+	 */
+	void QueueReset(UNinjaGASAbilitySystemComponent* AbilitySystemComponent);
+
+	/** Removes any pending work for a component. */
+	void Dequeue(const UNinjaGASAbilitySystemComponent* AbilitySystemComponent);
+
+	/** Informs if a component has pending work. */
+	bool IsQueued(const UNinjaGASAbilitySystemComponent* AbilitySystemComponent) const;
+
+	/** Number of components currently waiting to be processed. */
+	int32 GetQueueSize() const { return PendingRequests.Num(); }
+
+protected:
+
+	/** Work pending for a component. */
+	struct FPendingRequest
+	{
+		/** Component waiting to be processed. */
+		TWeakObjectPtr<UNinjaGASAbilitySystemComponent> AbilitySystemComponent;
+
+		/** Sequence used to keep requests with the same priority in order. */
+		uint32 Sequence = 0;
+
+		/** Priority calculated for the current frame. Lower values are processed first. */
+		double Priority = 0.;
+
+		/** The component must be reset before anything else. */
+		bool bReset = false;
+
+		/** Defaults must be granted. */
+		bool bInitialize = false;
+
+		/** Defaults from the avatar must be granted. */
+		bool bAvatarHasChanged = false;
+	};
+
+	/**
+	 * Calculates the priority for a component. Lower values are processed first.
+	 *
+	 * By default, player-controlled avatars come first, followed by other avatars ordered
+	 * by their distance to the closest player. Subclasses can provide a different metric.
+	 *
+	 * @param AbilitySystemComponent	Component being evaluated.
+	 * @param PlayerLocations			Locations for all local and remote players in the world.
+	 * @return							Priority for the component.
+	 */
+	virtual double GetPriority(const UNinjaGASAbilitySystemComponent* AbilitySystemComponent, const TArray<FVector>& PlayerLocations) const;
+
+	/** Finds or creates the pending request for a component. */
+	FPendingRequest& FindOrAddRequest(UNinjaGASAbilitySystemComponent* AbilitySystemComponent);
+
+private:
+
+	/** Requests waiting to be processed. */
+	TArray<FPendingRequest> PendingRequests;
+
+	/** Sequence assigned to the next request. */
+	uint32 NextSequence = 0;
+
+};
@@ -0,0 +1,86 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "NinjaGASMontageReplicationSubsystem.generated.h"
+
+class UNetConnection;
+class UNinjaGASAbilitySystemComponent;
+
+/**
+ * Coalesces montage replication changes made by Ninja ASCs during a frame.
+ *
+ * Playing a montage, jumping to a section and changing the play rate in the same frame would
+ * otherwise update the replicated entry and force a net update for each change. Components
+ * queue their changes here instead, and they are flushed once after actors have ticked, with
+ * at most one forced net update per avatar.
+ *
+ * Montage commands predicted by clients are batched the same way, and the server uses this
+ * subsystem to limit how many commands each connection can apply over time.
+ */
+UCLASS()
+class NINJAGAS_API UNinjaGASMontageReplicationSubsystem : public UWorldSubsystem
+{
+
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Informs if montage replication changes are globally coalesced.
+	 * When disabled, components update replicated montages immediately, as usual.
+	 */
+	static bool IsCoalescingEnabled();
+
+	/** Maximum number of rate limited montage commands the server keeps for a client. */
+	static int32 GetMaxMontageCommandBacklog();
+
+	// -- Begin Subsystem implementation
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// -- End Subsystem implementation
+
+	/**
+	 * Queues a component with pending montage changes, to be flushed at the end of the frame.
+	 *
+	 * @param AbilitySystemComponent	Component with pending changes.
+	 */
+	void QueueFlush(UNinjaGASAbilitySystemComponent* AbilitySystemComponent);
+
+	/** Flushes all pending changes immediately. */
+	void Flush();
+
+	/**
+	 * Consumes montage commands from the budget of a connection, which is refilled over time.
+	 *
+	 * @param Connection		Connection sending the commands.
+	 * @param CommandCount		Number of commands received.
+	 * @return					Number of commands that can be applied.
+	 */
+	int32 ConsumeMontageCommandBudget(const UNetConnection* Connection, int32 CommandCount);
+
+protected:
+
+	/** Flushes pending changes once actors have ticked, before the net driver replicates them. */
+	void HandlePostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+private:
+
+	/** Components with pending changes. */
+	TArray<TWeakObjectPtr<UNinjaGASAbilitySystemComponent>> PendingComponents;
+
+	/** Commands a connection can still apply, refilled over time. */
+	struct FMontageCommandBudget
+	{
+		double Tokens = 0.;
+		double LastRefillTime = 0.;
+	};
+
+	/** Budget for each connection that has sent montage commands. */
+	TMap<TObjectKey<UNetConnection>, FMontageCommandBudget> MontageCommandBudgets;
+
+	FDelegateHandle PostActorTickHandle;
+
+};
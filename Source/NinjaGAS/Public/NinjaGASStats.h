@@ -0,0 +1,10 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/**
+ * Stat group for the Ninja GAS runtime. Use "stat NinjaGAS" to inspect it in game.
+ */
+DECLARE_STATS_GROUP(TEXT("NinjaGAS"), STATGROUP_NinjaGAS, STATCAT_Advanced);
@@ -0,0 +1,15 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+/**
+ * Fidelity used to replicate montage data for additional meshes to a connection.
+ */
+UENUM(BlueprintType)
+enum class EMontageReplicationLOD : uint8
+{
+	/** Positions are replicated with timestamps, and simulated proxies correct their playback. */
+	Full,
+
+	/** Only starts, stops, sections and play rates are replicated, without position corrections. */
+	Reduced
+};
@@ -0,0 +1,15 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+/**
+ * Determines how replicated montage data for additional meshes is kept up to date on the server.
+ */
+UENUM(BlueprintType)
+enum class EMontageReplicationUpdateMode : uint8
+{
+	/** Replicated data is sampled every frame, while any montage is playing. */
+	Tick,
+
+	/** Replicated data is sampled by a timer, at a fixed rate, and whenever montages change. */
+	Timer
+};
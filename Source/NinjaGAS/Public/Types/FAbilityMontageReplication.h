@@ -1,4 +1,4 @@
-// Copyright (c) Ninja Bear Studio Inc.
+﻿// Copyright (c) Ninja Bear Studio Inc.
 // 
 // This file incorporates portions of code from:
 //   Copyright (c) Dan Kestranek (https://github.com/tranek)
@@ -12,8 +12,12 @@
 #include "Abilities/GameplayAbilityRepAnimMontage.h"
 #include "Abilities/GameplayAbilityTypes.h"
 #include "Animation/AnimMontage.h"
+#include "Types/EMontageReplicationLOD.h"
+#include "UObject/ObjectKey.h"
 #include "FAbilityMontageReplication.generated.h"
 
+class UAnimInstance;
+class UNetConnection;
 class UPackageMap;
 class UNinjaGASAbilitySystemComponent;
 
@@ -32,6 +36,9 @@ struct NINJAGAS_API FGameplayAbilityLocalAnimMontageForMesh
 	UPROPERTY()
 	FGameplayAbilityLocalAnimMontage LocalMontageInfo;
 
+	/** Anim Instance resolved for the mesh, while the mesh belongs to the avatar. */
+	mutable TWeakObjectPtr<UAnimInstance> CachedAnimInstance;
+	
 	FGameplayAbilityLocalAnimMontageForMesh(USkeletalMeshComponent* InMesh = nullptr)
 		: Mesh(InMesh)
 	{
@@ -43,6 +50,15 @@ struct NINJAGAS_API FGameplayAbilityLocalAnimMontageForMesh
 	}
 };
 
+/**
+ * Replicated montage data, including blend settings.
+ *
+ * Serialized with a change mask, so fields with default values are not sent. Position, play rate
+ * and blend time are quantized to the precision set by "NinjaGAS.MontageReplication.*Decimals".
+ * Blend settings are only sent once for each montage instance to each connection. Later updates
+ * for the same instance only flag that the override is still active, keeping the received ones.
+ * Positions of playing montages carry a compact server timestamp, so clients can extrapolate them.
+ */
 USTRUCT()
 struct NINJAGAS_API FPlayTagGameplayAbilityRepAnimMontage : public FGameplayAbilityRepAnimMontage
 {
@@ -54,14 +70,111 @@ struct NINJAGAS_API FPlayTagGameplayAbilityRepAnimMontage : public FGameplayAbil
 	UPROPERTY()
 	FMontageBlendSettings BlendInOverride;
 
+	/** One-based index in the montage registry, replicated instead of the montage when set. */
+	uint16 MontageRegistryIndex;
+
+	/** Server time when the position was sampled, in milliseconds wrapped to 16 bits. */
+	uint16 ServerTimestamp;
+
+	/** Informs if the position has a server timestamp, so clients can extrapolate it. */
+	bool bHasServerTimestamp;
+
+	/** Received when the entry was written with reduced fidelity, so clients only keep sections in sync. */
+	bool bReducedFidelity;
+
+	/** Incremented by the server for each montage instance played by the mesh. Not replicated. */
+	uint8 MontageInstanceId;
+
 	FPlayTagGameplayAbilityRepAnimMontage()
 		: bOverrideBlendIn(false)
 		, BlendInOverride({})
+		, MontageRegistryIndex(0)
+		, ServerTimestamp(0)
+		, bHasServerTimestamp(false)
+		, bReducedFidelity(false)
+		, MontageInstanceId(0)
 	{}
 	
 	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
 };
 
+/**
+ * Replicated reference to a mesh, sent as an index in the mesh registry when the mesh is registered.
+ */
+USTRUCT()
+struct NINJAGAS_API FNinjaRepMeshReference
+{
+	GENERATED_BODY()
+
+	/** Mesh replicated by reference, when it is not registered. */
+	UPROPERTY()
+	TObjectPtr<USkeletalMeshComponent> Mesh = nullptr;
+
+	/** One-based index in the mesh registry, replicated instead of the mesh when set. */
+	UPROPERTY()
+	uint8 RegistryIndex = 0;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+/** Edits that clients can apply to a predicted montage, replicated to the server as commands. */
+UENUM()
+enum class ENinjaMontageCommandType : uint8
+{
+	JumpToSection,
+	SetNextSection,
+	SetPlayRate
+};
+
+/**
+ * Montage edit predicted by a client, sent to the server in batches.
+ * Only fields used by the command type are serialized.
+ */
+USTRUCT()
+struct NINJAGAS_API FNinjaMontageCommand
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	ENinjaMontageCommandType Type = ENinjaMontageCommandType::JumpToSection;
+
+	/** Mesh playing the montage. */
+	UPROPERTY()
+	FNinjaRepMeshReference MeshReference;
+
+	/** Montage being edited, replicated by reference when it is not registered. */
+	UPROPERTY()
+	TObjectPtr<UAnimMontage> Montage = nullptr;
+
+	/** One-based index in the montage registry, replicated instead of the montage when set. */
+	UPROPERTY()
+	uint16 MontageRegistryIndex = 0;
+
+	/** Section to jump to, or the section being changed when setting the next section. */
+	UPROPERTY()
+	FName SectionName = NAME_None;
+
+	/** Section following the changed section. */
+	UPROPERTY()
+	FName NextSectionName = NAME_None;
+
+	/** Client position when the next section was set. */
+	UPROPERTY()
+	float Position = 0.f;
+
+	/** New play rate. */
+	UPROPERTY()
+	float PlayRate = 1.f;
+
+	/**
+	 * Checks if this command replaces another one, so only the latest is sent.
+	 * Both commands must be consecutive for the mesh, since commands are applied in order.
+	 */
+	bool Supersedes(const FNinjaMontageCommand& Other) const;
+	
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
 /**
 * Data about montages that is replicated to simulated clients.
  */
@@ -70,9 +183,17 @@ struct NINJAGAS_API FGameplayAbilityRepAnimMontageForMesh : public FFastArraySer
 {
 	GENERATED_BODY();
 
-	UPROPERTY()
+	/** Mesh playing the montage. Resolved from the replicated reference on clients. */
+	UPROPERTY(NotReplicated)
 	USkeletalMeshComponent* Mesh;
 
+	UPROPERTY()
+	FNinjaRepMeshReference MeshReference;
+
+	/** Meshes following the montage played by this mesh. Updated when a new montage instance starts. */
+	UPROPERTY()
+	TArray<FNinjaRepMeshReference> FollowerReferences;
+
 	UPROPERTY()
 	FPlayTagGameplayAbilityRepAnimMontage RepMontageInfo;
 
@@ -115,18 +236,62 @@ struct FGameplayAbilityRepAnimMontageContainer : public FFastArraySerializer
 	
 	void SetAbilitySystemComponent(UNinjaGASAbilitySystemComponent* NewAbilitySystemComponent);
 	FGameplayAbilityRepAnimMontageForMesh& GetGameplayAbilityRepAnimMontageForMesh(USkeletalMeshComponent* Mesh);
+	FGameplayAbilityRepAnimMontageForMesh* FindGameplayAbilityRepAnimMontageForMesh(const USkeletalMeshComponent* Mesh);
+	
+	/**
+	 * Removes entries for meshes that have been destroyed.
+	 * Only relevant for the authority, since clients receive removals via replication.
+	 *
+	 * @return	Number of entries that have been removed.
+	 */
+	int32 RemoveInvalidMeshes();
 	void MarkMontageDirty(FGameplayAbilityRepAnimMontageForMesh& Entry);
+
+	/** Discards indices, rebuilding them on the next lookup. Used when entry meshes are resolved again. */
+	void InvalidateEntryIndices() { EntryIndices.Reset(); }
 	
 	// -- Begin FFastArraySerializer implementation
 	void PostReplicatedAdd(const TArrayView<int32> AddedIndices, int32 FinalSize);
 	void PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize);
+	void PostReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize);
 	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams);
 	// -- End FFastArraySerializer implementation	
+
+	/**
+	 * Determines the fidelity used while writing entries for a connection.
+	 * The fidelity is passed to the entry serializer, so entries themselves are never modified.
+	 */
+	EMontageReplicationLOD GetReplicationLOD(const UNetConnection* Connection) const;
 	
 private:
+
+	/** Montage and instance identifying the blend settings written for an entry. */
+	using FBlendInInstance = TPair<TObjectKey<UAnimSequenceBase>, uint8>;
+
+	/** Replication state kept for each connection. */
+	struct FConnectionState
+	{
+		/** Fidelity last used for the connection, so a change resends every entry to it. */
+		EMontageReplicationLOD LOD = EMontageReplicationLOD::Full;
+
+		/** Instance whose blend settings were written to the connection, by entry replication ID. */
+		TMap<int32, FBlendInInstance> BlendInInstances;
+	};
+	
+	/** State for each connection receiving entries. */
+	TMap<TObjectKey<UNetConnection>, FConnectionState> ConnectionStates;
 	
 	UPROPERTY(NotReplicated)
 	TObjectPtr<UNinjaGASAbilitySystemComponent> AbilitySystemComponent;
+
+	/** Entry index for each mesh. Validated on every lookup and rebuilt when stale. */
+	TMap<TObjectKey<USkeletalMeshComponent>, int32> EntryIndices;
+
+	/** Finds the index for a mesh, rebuilding the indices if necessary. */
+	int32 FindEntryIndex(const USkeletalMeshComponent* Mesh);
+
+	/** Rebuilds indices for all entries. */
+	void RebuildEntryIndices();
 	
 };
 
@@ -139,6 +304,24 @@ struct TStructOpsTypeTraits<FPlayTagGameplayAbilityRepAnimMontage> : TStructOpsT
 	};
 };
 
+template<>
+struct TStructOpsTypeTraits<FNinjaRepMeshReference> : TStructOpsTypeTraitsBase2<FNinjaRepMeshReference>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+template<>
+struct TStructOpsTypeTraits<FNinjaMontageCommand> : TStructOpsTypeTraitsBase2<FNinjaMontageCommand>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
 template<>
 struct TStructOpsTypeTraits<FGameplayAbilityRepAnimMontageContainer> : TStructOpsTypeTraitsBase2<FGameplayAbilityRepAnimMontageContainer>
 {
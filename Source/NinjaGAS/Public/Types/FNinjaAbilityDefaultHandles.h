@@ -1,4 +1,4 @@
-// Ninja Bear Studio Inc. 2024, all rights reserved.
+﻿// Ninja Bear Studio Inc. 2024, all rights reserved.
 #pragma once
 
 #include "CoreMinimal.h"
@@ -41,6 +41,13 @@ struct NINJAGAS_API FAbilityDefaultHandles
 	UPROPERTY(BlueprintReadOnly, Category = "Ability Handles")
 	TArray<FGameplayAbilitySpecHandle> DefaultAbilityHandles;	
 
+	/**
+	 * Informs if tags, effects and abilities from the setup were revoked, keeping its Attribute Sets.
+	 * Happens when the avatar is removed, so the next one can still be swapped by difference.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Ability Handles")
+	bool bSuspended = false;
+
 	/** Informs if there are any valid handles or data assigned. */
 	bool IsValid() const;
 	
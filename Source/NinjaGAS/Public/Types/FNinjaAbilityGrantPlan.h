@@ -0,0 +1,106 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayAbilitySpec.h"
+#include "GameplayTagContainer.h"
+#include "Templates/SubclassOf.h"
+
+class UAttributeSet;
+class UDataTable;
+class UGameplayEffect;
+class UNinjaGASDataAsset;
+struct FAbilityDefaultHandles;
+
+/**
+ * Immutable, pre-validated representation of a Ninja GAS Data Asset.
+ *
+ * Compiled once per data asset and shared by every Ability System Component initialized
+ * from it, so classes, scopes and specs are not re-resolved for each spawned actor.
+ */
+struct NINJAGAS_API FNinjaAbilityGrantPlan
+{
+	/** Scope bit for entries that are instantiated on the server. */
+	static constexpr uint8 ServerScope = 1 << 0;
+
+	/** Scope bit for entries that are instantiated on clients. */
+	static constexpr uint8 ClientScope = 1 << 1;
+
+	/** Resolved Attribute Set entry. */
+	struct FAttributeSetEntry
+	{
+		/** Attribute set class to instantiate. */
+		TSubclassOf<UAttributeSet> AttributeSetClass;
+
+		/** Optional table with default values. */
+		const UDataTable* AttributeTable = nullptr;
+
+		/** Combination of ServerScope and ClientScope. */
+		uint8 ScopeMask = 0;
+
+		/** Informs if the set is kept when the avatar changes. */
+		bool bPermanent = false;
+	};
+
+	/** Resolved Gameplay Effect entry. */
+	struct FGameplayEffectEntry
+	{
+		/** Class used for logging and maintenance. */
+		TSubclassOf<UGameplayEffect> GameplayEffectClass;
+
+		/**
+		 * Default object resolved when compiling, matching the definition in active effects.
+		 * Specs are still built through the component's outgoing spec, so subclasses can customize them.
+		 */
+		const UGameplayEffect* GameplayEffectDefinition = nullptr;
+
+		/** Level for the effect. */
+		float Level = 1.f;
+	};
+
+	/** The data asset compiled into this plan. */
+	TWeakObjectPtr<const UNinjaGASDataAsset> SourceData;
+
+	/** Valid attribute sets, in the order declared by the data asset. */
+	TArray<FAttributeSetEntry> AttributeSets;
+
+	/** Valid gameplay effects, in the order declared by the data asset. */
+	TArray<FGameplayEffectEntry> GameplayEffects;
+
+	/** Prebuilt specs, copied and given a fresh handle when granted. */
+	TArray<FGameplayAbilitySpec> AbilitySpecTemplates;
+
+	/** Tags added to the ASC, copied from the data asset. */
+	FGameplayTagContainer InitialGameplayTags;
+
+	/**
+	 * Compiles a data asset into a new grant plan.
+	 *
+	 * @param AbilityData		Data asset providing the defaults.
+	 * @return					The compiled plan, never null.
+	 */
+	static TSharedRef<const FNinjaAbilityGrantPlan> Compile(const UNinjaGASDataAsset* AbilityData);
+
+	/** Checks if an attribute set entry applies to the given network role. */
+	static bool AppliesTo(const FAttributeSetEntry& Entry, const bool bIsAuth)
+	{
+		return (Entry.ScopeMask & (bIsAuth ? ServerScope : ClientScope)) != 0;
+	}
+
+	/**
+	 * Reserves the exact capacity the plan requires in the handle arrays.
+	 *
+	 * @param Handles			Handles that will receive the granted elements.
+	 * @param bIsAuth			Informs if the grant happens on the authority.
+	 */
+	void ReserveHandles(FAbilityDefaultHandles& Handles, bool bIsAuth) const;
+
+private:
+
+	/** Permanent attribute sets, indexed by authority. */
+	int32 PermanentAttributeSetCount[2] = { 0, 0 };
+
+	/** Temporary attribute sets, indexed by authority. */
+	int32 TemporaryAttributeSetCount[2] = { 0, 0 };
+
+};
@@ -0,0 +1,69 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FNumericProperty;
+class UAttributeSet;
+class UDataTable;
+
+/**
+ * Baked initialization data for an Attribute Set class and an Attribute Table.
+ *
+ * Mirrors what "UAttributeSet::InitFromMetaDataTable" does, but resolves row names and
+ * properties once, so applying the table becomes a sequence of direct writes.
+ *
+ * When built without a table, the layout captures the class defaults for every attribute,
+ * which can be used to reset an existing Attribute Set instance.
+ */
+struct NINJAGAS_API FNinjaAttributeTableLayout
+{
+	/** A Gameplay Attribute Data property, written by offset. */
+	struct FAttributeDataEntry
+	{
+		/** Offset of the property in the Attribute Set. */
+		int32 Offset = 0;
+
+		/** Value assigned as the base value. */
+		float BaseValue = 0.f;
+
+		/** Value assigned as the current value. */
+		float CurrentValue = 0.f;
+	};
+
+	/** A plain numeric property, written through its property. */
+	struct FNumericEntry
+	{
+		/** Numeric property in the Attribute Set class. */
+		const FNumericProperty* Property = nullptr;
+
+		/** Value assigned to the property. */
+		float Value = 0.f;
+
+		/** Value in the class defaults, copied as it is into integer properties. */
+		const void* DefaultValue = nullptr;
+	};
+
+	/** Gameplay Attribute Data properties that have a row in the table. */
+	TArray<FAttributeDataEntry> AttributeData;
+
+	/** Numeric properties that have a row in the table. */
+	TArray<FNumericEntry> NumericValues;
+
+	/**
+	 * Builds the layout for a class and table pair.
+	 *
+	 * @param AttributeSetClass		Attribute Set class that will be initialized.
+	 * @param AttributeTable		Table with rows using the Attribute Meta Data structure, or null for class defaults.
+	 * @return						The baked layout, never null.
+	 */
+	static TSharedRef<const FNinjaAttributeTableLayout> Build(const UClass* AttributeSetClass, const UDataTable* AttributeTable);
+
+	/**
+	 * Writes all values into an Attribute Set instance.
+	 *
+	 * @param AttributeSet			Attribute Set matching the class used to build the layout.
+	 */
+	void Apply(UAttributeSet* AttributeSet) const;
+
+};
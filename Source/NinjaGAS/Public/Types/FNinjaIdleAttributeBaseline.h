@@ -0,0 +1,36 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "AttributeSet.h"
+
+/**
+ * Attribute value captured in the idle baseline, located by its Attribute Set and offset.
+ * Entries are kept in the same order as spawned Attribute Sets and their attributes.
+ */
+struct FNinjaIdleAttributeBaseline
+{
+	/** Attribute captured, reported when its base value changes. */
+	FGameplayAttribute Attribute;
+
+	/** Index of the Attribute Set in the spawned Attribute Sets. */
+	int32 AttributeSetIndex = 0;
+
+	/** Offset of the Gameplay Attribute Data property in the Attribute Set. */
+	int32 Offset = 0;
+
+	/** Attribute data when the baseline was captured. */
+	FGameplayAttributeData Value;
+
+	FNinjaIdleAttributeBaseline() { }
+
+	FNinjaIdleAttributeBaseline(const FGameplayAttribute& InAttribute, const int32 InAttributeSetIndex, const int32 InOffset, const FGameplayAttributeData& InValue)
+		: Attribute(InAttribute), AttributeSetIndex(InAttributeSetIndex), Offset(InOffset), Value(InValue)
+	{
+	}
+
+	/** Provides the current data for this attribute, from the Attribute Set it was captured from. */
+	const FGameplayAttributeData& GetCurrentData(const UAttributeSet* AttributeSet) const
+	{
+		return *reinterpret_cast<const FGameplayAttributeData*>(reinterpret_cast<const uint8*>(AttributeSet) + Offset);
+	}
+};
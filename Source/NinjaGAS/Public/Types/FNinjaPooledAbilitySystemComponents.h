@@ -0,0 +1,56 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayEffectTypes.h"
+#include "FNinjaPooledAbilitySystemComponents.generated.h"
+
+class UNinjaGASAbilitySystemComponent;
+
+/**
+ * Identifies a pool of Ability System Components, by class and replication mode.
+ */
+USTRUCT()
+struct NINJAGAS_API FNinjaComponentPoolKey
+{
+	GENERATED_BODY()
+
+	/** Class of the pooled components. */
+	UPROPERTY(Transient)
+	TObjectPtr<UClass> ComponentClass = nullptr;
+
+	/** Replication mode for Gameplay Effects, set on the pooled components. */
+	UPROPERTY(Transient)
+	EGameplayEffectReplicationMode ReplicationMode = EGameplayEffectReplicationMode::Full;
+
+	FNinjaComponentPoolKey() { }
+
+	FNinjaComponentPoolKey(UClass* InComponentClass, const EGameplayEffectReplicationMode InReplicationMode)
+		: ComponentClass(InComponentClass), ReplicationMode(InReplicationMode)
+	{
+	}
+
+	bool operator==(const FNinjaComponentPoolKey& Other) const
+	{
+		return ComponentClass == Other.ComponentClass && ReplicationMode == Other.ReplicationMode;
+	}
+
+	friend uint32 GetTypeHash(const FNinjaComponentPoolKey& Key)
+	{
+		return HashCombine(GetTypeHash(Key.ComponentClass), GetTypeHash(static_cast<uint8>(Key.ReplicationMode)));
+	}
+};
+
+/**
+ * Ability System Components of a single pool, available to be borrowed.
+ */
+USTRUCT()
+struct NINJAGAS_API FNinjaPooledAbilitySystemComponents
+{
+	GENERATED_BODY()
+
+	/** Pooled instances, borrowed from the end. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UNinjaGASAbilitySystemComponent>> Components;
+	
+};
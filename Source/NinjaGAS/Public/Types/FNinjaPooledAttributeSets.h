@@ -0,0 +1,21 @@
+﻿// Ninja Bear Studio Inc., all rights reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FNinjaPooledAttributeSets.generated.h"
+
+class UAttributeSet;
+
+/**
+ * Detached Attribute Sets of a single class, available for reuse.
+ */
+USTRUCT()
+struct NINJAGAS_API FNinjaPooledAttributeSets
+{
+	GENERATED_BODY()
+
+	/** Pooled instances, reused from the end. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAttributeSet>> AttributeSets;
+	
+};
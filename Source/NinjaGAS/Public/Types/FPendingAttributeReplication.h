@@ -21,4 +21,27 @@ struct FPendingAttributeReplication
 		Attribute = InAttribute;
 		NewValue = InNewValue;
 	}
+
+	/**
+	 * Sets the pending value for an attribute, replacing any value received before.
+	 * Only the latest value matters, so repeated updates do not grow the list.
+	 *
+	 * @param PendingAttributes		Attributes pending replication.
+	 * @param InAttribute			The attribute that was replicated.
+	 * @param InNewValue			The latest value received.
+	 */
+	static void AddOrReplace(TArray<FPendingAttributeReplication>& PendingAttributes, const FGameplayAttribute& InAttribute, const FGameplayAttributeData& InNewValue)
+	{
+		FPendingAttributeReplication* Existing = PendingAttributes.FindByPredicate([&InAttribute](const FPendingAttributeReplication& Pending)
+			{ return Pending.Attribute == InAttribute; });
+
+		if (Existing)
+		{
+			Existing->NewValue = InNewValue;
+		}
+		else
+		{
+			PendingAttributes.Emplace(InAttribute, InNewValue);
+		}
+	}
 };
\ No newline at end of file